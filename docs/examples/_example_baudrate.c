@@ -0,0 +1,20 @@
+/*
+ * \brief           Switch AT port to the highest working baudrate after stack is initialized
+ */
+static void
+at_port_speed_up(void) {
+    static const uint32_t bauds[] = { 115200, 460800, 921600, 2000000 };
+    esp_baudrate_step_t steps[ESP_ARRAYSIZE(bauds)];
+    uint32_t baud;
+    size_t i;
+    
+    if (esp_baudrate_negotiate(bauds, ESP_ARRAYSIZE(bauds), steps, &baud) != espOK) {
+        printf("AT port lost, reset device by hardware\r\n");
+        return;
+    }
+    for (i = 0; i < ESP_ARRAYSIZE(steps) && steps[i].baudrate; i++) {
+        printf("Baudrate %7u: %s, %6u bytes/sec\r\n", (unsigned)steps[i].baudrate,
+            steps[i].res == espOK ? "OK    " : "FAILED", (unsigned)steps[i].bytes_per_sec);
+    }
+    printf("AT port runs at %u\r\n", (unsigned)baud);
+}
@@ -0,0 +1,129 @@
+/*
+ * Stress test of input ring buffer with one writer and one reader thread on Linux.
+ *
+ * Writer puts sequence of bytes to buffer in random chunks, either by copy with esp_buff_write
+ * or directly to memory like DMA does with esp_buff_get_linear_block_write_address and esp_buff_advance.
+ * Reader takes them out with esp_buff_read or esp_buff_get_linear_block_address and esp_buff_skip
+ * and checks that no byte is lost, duplicated or reordered.
+ *
+ * Build together with esp_buff.c and esp_mem.c, optionally with -fsanitize=thread.
+ */
+#include "esp/esp_buff.h"
+#include "stdio.h"
+#include "pthread.h"
+#include "sched.h"
+
+#ifndef STRESS_BYTES
+#define STRESS_BYTES            10000000UL      /* Number of bytes to transfer */
+#endif /* STRESS_BYTES */
+#define STRESS_BUFF_SIZE        1031            /* Prime size, chunks do not align to buffer end */
+#define STRESS_MAX_CHUNK        300             /* Maximal chunk size */
+
+/* Sequence value, period is not multiple of buffer size */
+#define SEQ(i)                  ((uint8_t)((i) % 251))
+
+static uint8_t mem[STRESS_BUFF_SIZE];
+static esp_buff_t buff;
+static size_t errors;
+
+/*
+ * \brief           Xorshift random generator
+ */
+static uint32_t
+stress_rand(uint32_t* s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+/*
+ * \brief           Writer thread, interrupt or DMA in real application
+ */
+static void*
+writer_thread(void* arg) {
+    uint8_t chunk[STRESS_MAX_CHUNK], *d;
+    size_t pos = 0, len, i, w;
+    uint32_t s = 0x1234567UL;
+
+    (void)arg;
+    while (pos < STRESS_BYTES) {
+        len = 1 + stress_rand(&s) % STRESS_MAX_CHUNK;
+        if (len > STRESS_BYTES - pos) {
+            len = STRESS_BYTES - pos;
+        }
+        if (stress_rand(&s) & 1) {              /* Write with copy */
+            for (i = 0; i < len; i++) {
+                chunk[i] = SEQ(pos + i);
+            }
+            w = esp_buff_write(&buff, chunk, len);
+        } else {                                /* Write directly to memory */
+            w = esp_buff_get_linear_block_write_length(&buff);
+            if (w > len) {
+                w = len;
+            }
+            d = esp_buff_get_linear_block_write_address(&buff);
+            for (i = 0; i < w; i++) {
+                d[i] = SEQ(pos + i);
+            }
+            w = esp_buff_advance(&buff, w);
+        }
+        if (!w) {
+            sched_yield();                      /* Buffer is full, let reader run */
+        }
+        pos += w;
+    }
+    return NULL;
+}
+
+/*
+ * \brief           Reader thread, processing thread in real application
+ */
+static void*
+reader_thread(void* arg) {
+    uint8_t chunk[STRESS_MAX_CHUNK], *d;
+    size_t pos = 0, len, i;
+    uint32_t s = 0x7654321UL;
+
+    (void)arg;
+    while (pos < STRESS_BYTES) {
+        if (stress_rand(&s) & 1) {              /* Read with copy */
+            d = chunk;
+            len = esp_buff_read(&buff, chunk, 1 + stress_rand(&s) % STRESS_MAX_CHUNK);
+        } else {                                /* Process directly from memory */
+            d = esp_buff_get_linear_block_address(&buff);
+            len = esp_buff_get_linear_block_length(&buff);
+        }
+        for (i = 0; i < len; i++) {
+            if (d[i] != SEQ(pos + i)) {
+                if (!errors++) {
+                    printf("Mismatch at byte %lu\r\n", (unsigned long)(pos + i));
+                }
+            }
+        }
+        if (d != chunk) {
+            esp_buff_skip(&buff, len);          /* Release memory after it was processed */
+        }
+        if (!len) {
+            sched_yield();                      /* Buffer is empty, let writer run */
+        }
+        pos += len;
+    }
+    return NULL;
+}
+
+int
+main(void) {
+    pthread_t w, r;
+
+    buff.buff = mem;                            /* Use static memory instead of esp_buff_init */
+    buff.size = sizeof(mem);
+
+    pthread_create(&r, NULL, reader_thread, NULL);
+    pthread_create(&w, NULL, writer_thread, NULL);
+    pthread_join(w, NULL);
+    pthread_join(r, NULL);
+
+    printf("Transferred %lu bytes, errors: %lu\r\n", (unsigned long)STRESS_BYTES, (unsigned long)errors);
+    return errors ? 1 : 0;
+}
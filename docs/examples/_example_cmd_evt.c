@@ -0,0 +1,28 @@
+static size_t sent;
+
+/*
+ * \brief           Completion function of non-blocking send
+ * \param[in]       res: Final result of command
+ * \param[in]       arg: Custom user argument, connection handle in this case
+ */
+static void
+send_evt_fn(espr_t res, void* arg) {
+    esp_conn_p conn = arg;
+
+    if (res == espOK) {
+        /* Variable sent holds number of bytes sent at this point */
+    } else {
+        esp_conn_close(conn, 0);                /* Close connection in non-blocking way */
+    }
+}
+
+/*
+ * \brief           Start non-blocking send and get notified when it finishes
+ * \param[in]       conn: Connection handle
+ * \param[in]       data: Data to send, must be valid until completion function is called
+ * \param[in]       len: Number of bytes to send
+ */
+static espr_t
+send_async(esp_conn_p conn, const void* data, size_t len) {
+    return esp_conn_send_ex(conn, data, len, &sent, send_evt_fn, conn);
+}
@@ -0,0 +1,22 @@
+/*
+ * \brief           Print statistics of all commands and last finished commands
+ */
+static void
+cmd_stats_print(void) {
+    static char buff[1024];
+    esp_cmd_trace_t trace[8];
+    size_t i, cnt;
+    
+    esp_cmd_stats_dump(buff, sizeof(buff));
+    printf("%s", buff);
+    
+    cnt = esp_cmd_stats_trace(trace, ESP_ARRAYSIZE(trace));
+    for (i = 0; i < cnt; i++) {                 /* Newest command first */
+        printf("%-24s res %d: queue %4u ms, first byte %4u ms, total %5u ms\r\n",
+            esp_cmd_stats_name(trace[i].cmd), (int)trace[i].res,
+            (unsigned)(trace[i].t_start - trace[i].t_enqueue),
+            (unsigned)(trace[i].t_first - trace[i].t_start),
+            (unsigned)(trace[i].t_end - trace[i].t_enqueue));
+    }
+    esp_cmd_stats_reset();                      /* Start new measurement period */
+}
@@ -71,6 +71,13 @@ conn_cb(esp_cb_t* cb) {
                  */
                 len = esp_pbuf_length(pbuf, 1); /* Get total length of buffer */
                 printf("Length of data: %d bytes\r\n", (int)len);
+                
+                /*
+                 * Confirm processed data to stack,
+                 * required when ESP_CFG_CONN_RECV_PASSIVE is enabled,
+                 * otherwise reading stops once receive window is full
+                 */
+                esp_conn_recved(conn, pbuf);
             }
         }
         default:
@@ -0,0 +1,27 @@
+/*
+ * \brief           Echo connection callback function
+ * \param[in]       cb: ESP callback event
+ */
+static espr_t
+echo_conn_cb(esp_cb_t* cb) {
+    esp_conn_p conn = esp_conn_get_from_evt(cb);/* Get connection from current event */
+
+    switch (cb->type) {
+        case ESP_CB_CONN_DATA_RECV: {
+            esp_pbuf_p pbuf = cb->cb.conn_data_recv.buff;   /* Get data buffer */
+
+            /*
+             * Send received chain back without copying it,
+             * in non-blocking way as we are in callback function.
+             * Stack holds its own reference until data are sent
+             */
+            esp_conn_send_pbuf(conn, pbuf, NULL, 0);
+            esp_conn_recved(conn, pbuf);        /* Data are processed, open receive window again */
+            esp_pbuf_free(pbuf);                /* Release our reference */
+            break;
+        }
+        default:
+            break;
+    }
+    return espOK;
+}
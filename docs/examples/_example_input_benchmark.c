@@ -0,0 +1,86 @@
+/*
+ * Microbenchmark of input processing in command mode.
+ *
+ * Recorded AT transcript is fed to esp_input_process in blocks,
+ * like DMA receive would do, and processing speed is reported in bytes per cycle.
+ *
+ * Build with ESP_CFG_INPUT_USE_PROCESS enabled.
+ * On Linux, use ESP_CFG_SYS_PORT_POSIX and esp_ll_posix.c in ESP_LL_POSIX_SIM mode,
+ * on Cortex-M define BENCH_CYCLES() to read DWT cycle counter.
+ */
+#include "esp/esp.h"
+#include "esp/esp_input.h"
+#include "stdio.h"
+#include "string.h"
+
+#ifndef BENCH_CYCLES
+#if defined(__x86_64__) || defined(__i386__)
+#include "x86intrin.h"
+#define BENCH_CYCLES()          __rdtsc()
+#else
+#define BENCH_CYCLES()          DWT->CYCCNT
+#endif
+#endif /* BENCH_CYCLES */
+
+#ifndef BENCH_LOOPS
+#define BENCH_LOOPS             2000            /* Number of times transcript is processed */
+#endif /* BENCH_LOOPS */
+#ifndef BENCH_BLOCK_SIZE
+#define BENCH_BLOCK_SIZE        256             /* Size of block passed to input function at a time */
+#endif /* BENCH_BLOCK_SIZE */
+
+/*
+ * Unsolicited responses recorded from device, without OK, ERROR and ready
+ * which would finish or reset command in progress
+ */
+static const char transcript[] = ""
+    "+CWLAP:(3,\"Majerle WIFI\",-62,\"d8:fe:e3:74:4a:8e\",6,-24,0)\r\n"
+    "+CWLAP:(4,\"Hotel_Guests_2G\",-71,\"00:1a:1e:52:c3:a1\",1,12,0)\r\n"
+    "+CWLAP:(0,\"FreeWifi\",-84,\"2c:30:33:9f:10:5b\",11,-3,0)\r\n"
+    "+CWLAP:(3,\"TP-LINK_8C2E\",-90,\"50:c7:bf:41:8c:2e\",13,7,0)\r\n"
+    "WIFI CONNECTED\r\n"
+    "WIFI GOT IP\r\n"
+    "+CIPSTATUS:0,\"TCP\",\"93.184.216.34\",80,50612,0\r\n"
+    "+CIPSTATUS:1,\"UDP\",\"192.168.1.255\",5000,5000,0\r\n"
+    "+IPD,0,32,93.184.216.34,80:HTTP/1.1 200 OK\r\nServer: ECS\r\n\r\n"
+    "Recv 512 bytes\r\n"
+    "SEND OK\r\n"
+    "0,CLOSED\r\n"
+    "+LINK_CONN:0,0,\"TCP\",1,\"192.168.1.12\",50613,80\r\n"
+    "1,CONNECT FAIL\r\n"
+    "AT version:1.6.0.0(Feb  3 2018 12:00:06)\r\n"
+    "SDK version:2.2.0(f28eaf2)\r\n";
+
+/*
+ * \brief           Global callback
+ */
+static espr_t
+esp_cb(esp_cb_t* cb) {
+    return espOK;
+}
+
+int
+main(void) {
+    uint64_t start, cycles;
+    size_t i, off, len, total = 0;
+
+    esp_init(esp_cb);
+
+    start = BENCH_CYCLES();
+    for (i = 0; i < BENCH_LOOPS; i++) {
+        for (off = 0; off < sizeof(transcript) - 1; off += len) {
+            len = sizeof(transcript) - 1 - off;
+            if (len > BENCH_BLOCK_SIZE) {
+                len = BENCH_BLOCK_SIZE;
+            }
+            esp_input_process(&transcript[off], len);
+        }
+        total += sizeof(transcript) - 1;
+    }
+    cycles = BENCH_CYCLES() - start;
+
+    printf("Processed %u bytes in %llu cycles: %u.%03u bytes/cycle\r\n",
+        (unsigned)total, (unsigned long long)cycles,
+        (unsigned)(total / cycles), (unsigned)((total * 1000ULL / cycles) % 1000));
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Fragmentation and speed benchmark of memory manager.
+ *
+ * Allocation trace of typical application is replayed:
+ * command messages freed right after execution, timeouts with short lifetime,
+ * +IPD packet buffers held by application for a while and long living netconn structures.
+ *
+ * Run once with ESP_CFG_MEM_SLAB disabled and once enabled to compare results.
+ */
+#include "esp/esp.h"
+#include "esp/esp_mem.h"
+#include "stdio.h"
+#include "time.h"
+
+#ifndef BENCH_HEAP_SIZE
+#define BENCH_HEAP_SIZE         0x4000          /* Size of memory region */
+#endif /* BENCH_HEAP_SIZE */
+#ifndef BENCH_STEPS
+#define BENCH_STEPS             200000          /* Number of trace steps to replay */
+#endif /* BENCH_STEPS */
+#define BENCH_SLOTS             64              /* Maximal number of live allocations */
+
+/* Allocation types of trace */
+typedef struct {
+    size_t min, max;                            /* Size range in bytes */
+    uint32_t life;                              /* Maximal lifetime in steps */
+    uint32_t weight;                            /* Relative frequency */
+} trace_type_t;
+
+static const trace_type_t types[] = {
+    { 96, 128, 1, 50 },                         /* esp_msg_t, freed after command finishes */
+    { 16, 24, 20, 20 },                         /* esp_timeout_t */
+    { 64, 1500, 40, 25 },                       /* esp_pbuf_t with +IPD payload */
+    { 40, 48, 200, 5 },                        /* esp_netconn_t */
+};
+
+static uint8_t heap[BENCH_HEAP_SIZE];
+static void* slot_ptr[BENCH_SLOTS];
+static uint32_t slot_free_at[BENCH_SLOTS];
+static uint32_t rnd = 0x12345678UL;
+
+/*
+ * \brief           Xorshift random generator, same trace on every run
+ */
+static uint32_t
+trace_rand(void) {
+    rnd ^= rnd << 13;
+    rnd ^= rnd >> 17;
+    rnd ^= rnd << 5;
+    return rnd;
+}
+
+/*
+ * \brief           Find largest block heap can still allocate
+ */
+static size_t
+largest_free(void) {
+    size_t lo = 0, hi = esp_mem_getfree(), mid;
+    void* p;
+
+    while (lo < hi) {
+        mid = (lo + hi + 1) / 2;
+        if ((p = esp_mem_alloc(mid)) != NULL) {
+            esp_mem_free(p);
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+int
+main(void) {
+    esp_mem_region_t region = { heap, sizeof(heap) };
+    struct timespec t1, t2, s1, s2;
+    uint32_t step, i, w, wsum = 0, fails = 0, ops = 0;
+    size_t size, worst_largest = (size_t)-1, l;
+    const trace_type_t* t;
+    uint64_t ns, sampling_ns = 0;
+
+    esp_sys_init();
+    esp_mem_assignmemory(&region, 1);
+    for (i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        wsum += types[i].weight;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    for (step = 0; step < BENCH_STEPS; step++) {
+        /* Free allocations with expired lifetime */
+        for (i = 0; i < BENCH_SLOTS; i++) {
+            if (slot_ptr[i] != NULL && slot_free_at[i] <= step) {
+                esp_mem_free(slot_ptr[i]);
+                slot_ptr[i] = NULL;
+                ops++;
+            }
+        }
+
+        /* New allocation of random type */
+        w = trace_rand() % wsum;
+        for (t = types; w >= t->weight; w -= t->weight, t++) {}
+        size = t->min + trace_rand() % (t->max - t->min + 1);
+        for (i = 0; i < BENCH_SLOTS && slot_ptr[i] != NULL; i++) {}
+        if (i < BENCH_SLOTS) {
+            slot_ptr[i] = esp_mem_alloc(size);
+            slot_free_at[i] = step + 1 + trace_rand() % t->life;
+            fails += slot_ptr[i] == NULL;
+            ops++;
+        }
+
+        /* Sample fragmentation from time to time */
+        if (!(step % 10000)) {
+            clock_gettime(CLOCK_MONOTONIC, &s1);
+            l = largest_free();
+            if (l < worst_largest) {
+                worst_largest = l;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &s2);
+            sampling_ns += (uint64_t)(s2.tv_sec - s1.tv_sec) * 1000000000ULL + (uint64_t)(s2.tv_nsec - s1.tv_nsec);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    ns = (uint64_t)(t2.tv_sec - t1.tv_sec) * 1000000000ULL + (uint64_t)(t2.tv_nsec - t1.tv_nsec) - sampling_ns;
+
+    printf("Operations: %u, %u ns per operation\r\n",
+        (unsigned)ops, (unsigned)(ns / (ops ? ops : 1)));
+    printf("Failed allocations: %u\r\n", (unsigned)fails);
+    printf("Heap free: %u bytes, worst largest free block: %u bytes\r\n",
+        (unsigned)esp_mem_getfree(), (unsigned)worst_largest);
+#if ESP_CFG_MEM_SLAB
+    for (i = 0; i < ESP_CFG_MEM_SLAB_CLASSES; i++) {
+        esp_mem_slab_stats_t stats;
+        esp_mem_slab_get_stats(i, &stats);
+        printf("Slab %4u bytes: %u/%u used, max used: %u, allocs: %u, misses: %u\r\n",
+            (unsigned)stats.size, (unsigned)stats.used, (unsigned)stats.blocks,
+            (unsigned)stats.max_used, (unsigned)stats.allocs, (unsigned)stats.misses);
+    }
+#endif /* ESP_CFG_MEM_SLAB */
+    return 0;
+}
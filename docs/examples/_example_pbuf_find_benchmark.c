@@ -0,0 +1,117 @@
+/*
+ * Benchmark of substring search in packet buffer chain.
+ *
+ * HTTP request with 4 KB of headers is split to packet buffers of different sizes,
+ * like it is received from +IPD statements, and searched for the same strings as HTTP server does.
+ * Result of each search is checked against simple byte by byte search.
+ *
+ * Build on Linux with ESP_CFG_SYS_PORT_POSIX enabled, together with esp_pbuf.c, esp_mem.c and esp_sys_posix.c
+ */
+#include "esp/esp.h"
+#include "esp/esp_pbuf.h"
+#include "esp/esp_mem.h"
+#include "stdio.h"
+#include "string.h"
+#include "time.h"
+
+#define BENCH_LOOPS             2000            /* Number of searches per needle */
+#define BENCH_HEADERS_SIZE      4096            /* Approximate size of headers */
+
+static uint8_t heap[0x8000];
+static char request[BENCH_HEADERS_SIZE + 256];
+
+/*
+ * \brief           Byte by byte search, used as reference
+ */
+static size_t
+ref_find(const char* h, size_t h_len, const char* n, uint8_t nocase) {
+    size_t i, k, n_len = strlen(n);
+    for (i = 0; i + n_len <= h_len; i++) {
+        for (k = 0; k < n_len; k++) {
+            char a = h[i + k], b = n[k];
+            if (nocase) {
+                a = (a >= 'A' && a <= 'Z') ? a + 32 : a;
+                b = (b >= 'A' && b <= 'Z') ? b + 32 : b;
+            }
+            if (a != b) {
+                break;
+            }
+        }
+        if (k == n_len) {
+            return i;
+        }
+    }
+    return ESP_SIZET_MAX;
+}
+
+/*
+ * \brief           Get current time in units of nanoseconds
+ */
+static uint64_t
+time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int
+main(void) {
+    static const struct {
+        const char* str;
+        uint8_t nocase;
+    } needles[] = {
+        { "\r\n\r\n", 0 },
+        { "content-length:", 1 },
+        { "X-Not-Present-Header:", 0 },
+        { " ", 0 },
+    };
+    static const size_t seg_sizes[] = { 536, 64, 1460, 128, 17, 1024 };
+    esp_mem_region_t region = { heap, sizeof(heap) };
+    esp_pbuf_p head = NULL, p;
+    size_t len = 0, off, l, i, n, pos = 0;
+    uint64_t start;
+
+    esp_sys_init();
+    esp_mem_assignmemory(&region, 1);
+
+    /* Build request with many headers */
+    len += sprintf(&request[len], "POST /upload/form.cgi HTTP/1.1\r\nHost: 192.168.1.10\r\n");
+    for (i = 0; len < BENCH_HEADERS_SIZE - 64; i++) {
+        len += sprintf(&request[len], "X-Custom-Header-%u: value-%u-abcdefghijklmnopqrstuvwxyz\r\n", (unsigned)i, (unsigned)(i * 7919));
+    }
+    len += sprintf(&request[len], "Content-Length: 1234\r\n\r\n");
+
+    /* Split it to pbufs of different sizes */
+    for (off = 0, i = 0; off < len; off += l, i++) {
+        l = ESP_MIN(seg_sizes[i % ESP_ARRAYSIZE(seg_sizes)], len - off);
+        p = esp_pbuf_new(l);
+        esp_pbuf_take(p, &request[off], l, 0);
+        if (head == NULL) {
+            head = p;
+        } else {
+            esp_pbuf_cat(head, p);
+        }
+    }
+    printf("Request: %u bytes in %u pbufs\r\n", (unsigned)len, (unsigned)i);
+
+    for (n = 0; n < ESP_ARRAYSIZE(needles); n++) {
+        /* Check result on all offsets first */
+        for (off = 0; off < len; off += 97) {
+            pos = needles[n].nocase ? esp_pbuf_strfind_nocase(head, needles[n].str, off) : esp_pbuf_strfind(head, needles[n].str, off);
+            l = ref_find(&request[off], len - off, needles[n].str, needles[n].nocase);
+            if (pos != (l == ESP_SIZET_MAX ? l : (l + off))) {
+                printf("Mismatch for needle %u at offset %u\r\n", (unsigned)n, (unsigned)off);
+                return 1;
+            }
+        }
+
+        start = time_ns();
+        for (i = 0; i < BENCH_LOOPS; i++) {
+            pos = needles[n].nocase ? esp_pbuf_strfind_nocase(head, needles[n].str, 0) : esp_pbuf_strfind(head, needles[n].str, 0);
+        }
+        printf("Needle %u, found at %5d: %6u ns per search\r\n", (unsigned)n,
+            pos == ESP_SIZET_MAX ? -1 : (int)pos, (unsigned)((time_ns() - start) / BENCH_LOOPS));
+    }
+    esp_pbuf_free(head);
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Benchmark of producer/process thread pair against AT firmware simulator.
+ *
+ * Build on Linux with ESP_CFG_SYS_PORT_POSIX enabled,
+ * together with esp_sys_posix.c, esp_ll_posix.c and esp_sim_posix.c.
+ * Low-level driver must be compiled with ESP_LL_POSIX_MODE set to ESP_LL_POSIX_SIM (3)
+ */
+#include "esp/esp.h"
+#include "system/esp_sim.h"
+#include "stdio.h"
+#include "stdlib.h"
+
+#define BENCH_CMDS              1000            /* Number of status commands to execute */
+#define BENCH_SENDS             200             /* Number of send commands to execute */
+
+static uint32_t lat[BENCH_CMDS];
+static volatile size_t recv_bytes;
+
+/*
+ * \brief           Compare function for latency sorting
+ */
+static int
+cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * \brief           Print commands/sec and latency percentiles
+ */
+static void
+report(const char* name, uint32_t* l, size_t cnt, uint32_t time, uint64_t bytes) {
+    qsort(l, cnt, sizeof(*l), cmp_u32);
+    printf("%s: %u cmds in %u ms, %u cmds/sec, %u bytes/sec, p50: %u ms, p99: %u ms\r\n",
+        name, (unsigned)cnt, (unsigned)time, (unsigned)(cnt * 1000 / (time ? time : 1)),
+        (unsigned)(bytes * 1000 / (time ? time : 1)), (unsigned)l[cnt / 2], (unsigned)l[cnt * 99 / 100]);
+}
+
+/*
+ * \brief           Connection callback, count echoed bytes
+ */
+static espr_t
+conn_cb(esp_cb_t* cb) {
+    if (cb->type == ESP_CB_CONN_DATA_RECV) {
+        recv_bytes += esp_pbuf_length(cb->cb.conn_data_recv.buff, 1);
+        esp_conn_recved(esp_conn_get_from_evt(cb), cb->cb.conn_data_recv.buff); /* Open receive window again */
+        esp_pbuf_free(cb->cb.conn_data_recv.buff);
+    }
+    return espOK;
+}
+
+/*
+ * \brief           Global callback
+ */
+static espr_t
+esp_cb(esp_cb_t* cb) {
+    return espOK;
+}
+
+int
+main(void) {
+    static uint8_t data[ESP_CFG_CONN_MAX_DATA_LEN];
+    esp_sim_cfg_t cfg = { 0 };
+    esp_sim_stats_t stats;
+    esp_conn_p conn;
+    uint32_t start, t;
+    size_t i;
+
+    /* Configure simulator, it is started by low-level driver during init */
+    cfg.baudrate = 0;                           /* Set to 115200 to emulate real UART */
+    cfg.send_ok_delay = 5;                      /* Remote acknowledge time, compare with ESP_CFG_CONN_SENDBUF */
+    cfg.echo_data = 1;
+    cfg.ap_count = 20;
+    esp_sim_set_cfg(&cfg);
+    esp_init(esp_cb);
+    esp_sta_join("sim", "sim", NULL, 0, 1);
+
+    /* Commands per second with AT+CIPSTATUS round trip */
+    esp_sim_reset_stats();
+    start = esp_sys_now();
+    for (i = 0; i < BENCH_CMDS; i++) {
+        t = esp_sys_now();
+        esp_get_conns_status(1);
+        lat[i] = esp_sys_now() - t;
+    }
+    esp_sim_get_stats(&stats);
+    report("CIPSTATUS", lat, BENCH_CMDS, esp_sys_now() - start, stats.bytes_rx + stats.bytes_tx);
+
+    /* Bytes per second with CIPSEND and echoed +IPD */
+    if (esp_conn_start(&conn, ESP_CONN_TYPE_TCP, "example.com", 80, NULL, conn_cb, 1) == espOK) {
+        esp_sim_reset_stats();
+        start = esp_sys_now();
+        for (i = 0; i < BENCH_SENDS; i++) {
+            t = esp_sys_now();
+            esp_conn_send(conn, data, sizeof(data), NULL, 1);
+            lat[i] = esp_sys_now() - t;
+        }
+        esp_sim_get_stats(&stats);
+        report("CIPSEND", lat, BENCH_SENDS, esp_sys_now() - start, stats.data_sent);
+        printf("Echoed bytes received: %u\r\n", (unsigned)recv_bytes);
+        esp_conn_close(conn, 1);
+    }
+    return 0;
+}
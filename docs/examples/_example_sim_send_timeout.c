@@ -0,0 +1,102 @@
+/*
+ * Check that packet buffer of timed out send is released, against AT firmware simulator.
+ *
+ * Received packet buffer from receive pool is echoed back with esp_conn_send_pbuf,
+ * while simulator never replies with SEND OK. After send command times out,
+ * buffer must be returned to pool, otherwise pool shrinks with every timeout.
+ * Send timeout is 60 seconds, test takes about that long.
+ *
+ * Build on Linux with ESP_CFG_SYS_PORT_POSIX and ESP_CFG_PBUF_POOL enabled,
+ * together with esp_sys_posix.c, esp_ll_posix.c and esp_sim_posix.c.
+ * Low-level driver must be compiled with ESP_LL_POSIX_MODE set to ESP_LL_POSIX_SIM (3)
+ */
+#include "esp/esp.h"
+#include "system/esp_sim.h"
+#include "stdio.h"
+
+#if !ESP_CFG_PBUF_POOL
+#error "ESP_CFG_PBUF_POOL must be enabled for this test"
+#endif /* !ESP_CFG_PBUF_POOL */
+
+#define TEST_TIMEOUT            70000           /* Maximal time to wait for buffer, longer than send timeout */
+
+static volatile uint8_t echoed;
+
+/*
+ * \brief           Connection callback, send received packet buffer back
+ */
+static espr_t
+conn_cb(esp_cb_t* cb) {
+    if (cb->type == ESP_CB_CONN_DATA_RECV) {
+        esp_pbuf_p pbuf = cb->cb.conn_data_recv.buff;
+        esp_conn_p conn = esp_conn_get_from_evt(cb);
+
+        esp_conn_recved(conn, pbuf);
+        if (esp_conn_send_pbuf(conn, pbuf, NULL, 0) == espOK) {
+            echoed = 1;                         /* Stack holds its own reference now */
+        }
+        esp_pbuf_free(pbuf);
+    }
+    return espOK;
+}
+
+/*
+ * \brief           Global callback
+ */
+static espr_t
+esp_cb(esp_cb_t* cb) {
+    return espOK;
+}
+
+/*
+ * \brief           Wait for specific time
+ * \param[in]       ms: Time to wait in units of milliseconds
+ */
+static void
+test_delay(uint32_t ms) {
+    esp_sys_sem_t sem;
+
+    if (esp_sys_sem_create(&sem, 0)) {
+        esp_sys_sem_wait(&sem, ms);
+        esp_sys_sem_delete(&sem);
+    }
+}
+
+int
+main(void) {
+    static const uint8_t data[100] = { 0 };
+    esp_pbuf_pool_stats_t stats;
+    esp_sim_cfg_t cfg = { 0 };
+    esp_conn_p conn;
+    uint32_t start;
+
+    cfg.send_ok_loss = 1000;                    /* Device never reports result of send */
+    esp_sim_set_cfg(&cfg);
+    esp_init(esp_cb);
+    esp_sta_join("sim", "sim", NULL, 0, 1);
+    if (esp_conn_start(&conn, ESP_CONN_TYPE_TCP, "example.com", 80, NULL, conn_cb, 1) != espOK) {
+        printf("FAIL: connection not started\r\n");
+        return 1;
+    }
+
+    esp_sim_ipd((uint8_t)esp_conn_getnum(conn), data, sizeof(data));
+    for (start = esp_sys_now(); !echoed && esp_sys_now() - start < 1000; ) {
+        test_delay(10);
+    }
+    if (!echoed) {
+        printf("FAIL: data not received\r\n");
+        return 1;
+    }
+
+    /* Buffer is in use until send times out */
+    for (start = esp_sys_now(); esp_sys_now() - start < TEST_TIMEOUT; ) {
+        esp_pbuf_pool_get_stats(&stats);
+        if (!stats.used) {
+            break;
+        }
+        test_delay(100);
+    }
+    printf("%s: %u of %u pool buffers in use after %u ms\r\n", stats.used ? "FAIL" : "PASS",
+        (unsigned)stats.used, (unsigned)stats.buffs, (unsigned)(esp_sys_now() - start));
+    return stats.used ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+/*
+ * Benchmark of timeout manager with many concurrent timeouts.
+ *
+ * For increasing number of active periodic timeouts, it measures
+ * cost of restarting single timeout and cost of timeout check in processing thread,
+ * which must stay the same regardless of number of timeouts.
+ *
+ * Build with esp_timeout.c, esp_mem.c and system port for your platform.
+ */
+#define ESP_INTERNAL
+#include "esp/esp_private.h"
+#include "esp/esp_timeout.h"
+#include "stdio.h"
+#include "time.h"
+
+#define BENCH_MAX_TIMEOUTS      10000           /* Maximal number of timeouts */
+#define BENCH_CALLS             100000          /* Number of measured calls */
+
+static esp_timeout_t timeouts[BENCH_MAX_TIMEOUTS];
+static uint32_t fired;
+
+/*
+ * \brief           Timeout callback
+ */
+static void
+timeout_cb(void* arg) {
+    ESP_UNUSED(arg);
+    fired++;
+}
+
+/*
+ * \brief           Get current time in units of nanoseconds
+ */
+static uint64_t
+time_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int
+main(void) {
+    static const size_t counts[] = { 10, 100, 1000, BENCH_MAX_TIMEOUTS };
+    esp_sys_mbox_t mbox;
+    uint64_t start, restart_ns, check_ns;
+    size_t c, i, active = 0;
+    void* msg;
+
+    esp_sys_init();
+    esp_sys_mbox_create(&mbox, 2);
+
+    for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        /* Periodic timeouts from 1 second to 1 minute, like connection polls and keep-alives */
+        for (; active < counts[c]; active++) {
+            esp_timeout_start(&timeouts[active], 1000 + (active * 7919) % 59000,
+                1000 + (active * 104729) % 59000, timeout_cb, NULL);
+        }
+
+        start = time_ns();
+        for (i = 0; i < BENCH_CALLS; i++) {     /* Restart, like keep-alive on every received packet */
+            esp_timeout_start(&timeouts[i % active], 30000, 30000, timeout_cb, NULL);
+        }
+        restart_ns = time_ns() - start;
+
+        start = time_ns();
+        for (i = 0; i < BENCH_CALLS; i++) {     /* Processing thread receives message and checks timeouts */
+            esp_sys_mbox_putnow(&mbox, &mbox);
+            espi_get_from_mbox_with_timeout_checks(&mbox, &msg, 10);
+        }
+        check_ns = time_ns() - start;
+
+        printf("Timeouts: %5u, restart: %4u ns, mbox get with timeout check: %5u ns\r\n",
+            (unsigned)active, (unsigned)(restart_ns / BENCH_CALLS), (unsigned)(check_ns / BENCH_CALLS));
+    }
+    printf("Fired: %u\r\n", (unsigned)fired);
+    return 0;
+}
@@ -0,0 +1,37 @@
+static uint8_t rx_buff_data[0x1000];
+static esp_buff_t rx_buff;
+
+/*
+ * \brief           Receive function for transparent mode
+ * \param[in]       data: Received data
+ * \param[in]       len: Number of bytes received
+ * \param[in]       arg: Custom user argument
+ */
+static void
+transparent_recv_fn(const void* data, size_t len, void* arg) {
+    esp_buff_write(&rx_buff, data, len);        /* Copy data to ring buffer and process them in application thread */
+}
+
+/*
+ * \brief           Upload log file to remote server
+ */
+static void
+upload_log(void) {
+    uint8_t chunk[256];
+    size_t len;
+    
+    rx_buff.buff = rx_buff_data;                /* Use static memory for ring buffer */
+    rx_buff.size = sizeof(rx_buff_data);
+    
+    if (esp_transparent_start(ESP_CONN_TYPE_TCP, "example.com", 9000, transparent_recv_fn, NULL, 1) == espOK) {
+        while ((len = log_read(chunk, sizeof(chunk))) > 0) {
+            esp_transparent_send(chunk, len);   /* Data go directly to AT port */
+        }
+        
+        /* Process response from server */
+        while ((len = esp_buff_read(&rx_buff, chunk, sizeof(chunk))) > 0) {
+            log_process_response(chunk, len);
+        }
+        esp_transparent_stop(1);                /* Go back to command mode */
+    }
+}
@@ -0,0 +1,26 @@
+/**
+ * \addtogroup      ESP_BAUDRATE
+ * \{
+ *
+ * AT port starts at \ref ESP_CFG_AT_PORT_BAUDRATE, usually `115200`,
+ * which limits throughput of every connection to roughly `11` kB/s.
+ * Most devices and hosts can run UART at several Mbaud,
+ * but the highest working baudrate depends on clocks, wiring and level shifters.
+ *
+ * \ref esp_baudrate_negotiate steps through candidate baudrates in ascending order.
+ * Each one is set with `AT+UART_CUR` on device and with \ref esp_ll_init on host,
+ * then verified with `AT` command and multiple round trips of pseudo random payload.
+ * Device echoes payload back and stack compares its length and checksum with sent one.
+ * Time of round trips gives effective throughput of AT port in bytes per second.
+ *
+ * On first failed step, both sides go back to last working baudrate and negotiation stops.
+ * Baudrate set with `AT+UART_CUR` is not saved on device, which starts with default one after power-up.
+ *
+ * \note            Payload is sent as unknown `AT+UARTCHK` command, which device rejects with `ERROR`
+ *                  after it echoes it back. Echo is enabled for round trips only
+ *                  when \ref ESP_CFG_AT_ECHO is disabled
+ *
+ * \include         _example_baudrate.c
+ *
+ * \}
+ */
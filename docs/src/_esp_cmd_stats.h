@@ -0,0 +1,33 @@
+/**
+ * \addtogroup      ESP_CMD_STATS
+ * \{
+ *
+ * When \ref ESP_CFG_CMD_STATS is enabled, every command started by API function
+ * is timestamped in 4 points:
+ *
+ *  - When it is put to producer queue
+ *  - When producer thread starts it and first AT command is sent
+ *  - When first byte is received from device while command is active
+ *  - When command is finished and blocking caller is released
+ *
+ * Time from start to finish is execution time and is added to log2 histogram of the command.
+ * Commands finished with \ref espTIMEOUT and other errors are counted separately.
+ * Statistics of single command are available with \ref esp_cmd_stats_get
+ * and last \ref ESP_CFG_CMD_STATS_TRACE_LEN commands with all timestamps with \ref esp_cmd_stats_trace.
+ *
+ * \ref esp_cmd_stats_dump writes one line per executed command, for example:
+ *
+ * \code
+ * TCPIP_CIPSEND: n=42 err=0 tmo=1 q=0 f=2 e=5/1003 h=0,3,12,20,6,0,0,0,0,0,1
+ * \endcode
+ *
+ * Line starts with name of command, as returned by \ref esp_cmd_stats_name. Values are number of commands, errors, timeouts, average queue time, average time to first response byte,
+ * average and maximal execution time, all in milliseconds, followed by histogram buckets.
+ *
+ * \note            First response byte is any byte received while command is active,
+ *                  including asynchronous statements such as `+IPD`
+ *
+ * \include         _example_cmd_stats.c
+ *
+ * \}
+ */
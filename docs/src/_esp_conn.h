@@ -47,5 +47,44 @@
  * Use \ref esp_conn_send or \ref esp_conn_sendto functions,
  * to send data directly to message queue.
  *
+ * \par             Send packet buffer chain
+ *
+ * Received packet buffers can be forwarded (echo, proxy) with \ref esp_conn_send_pbuf
+ * without copying them to linear memory first.
+ * Segments of chain are written to AT port one after another within single `AT+CIPSEND` command
+ * and stack keeps its own reference to packet buffer until device replies with `SEND OK`,
+ * so application may free its reference immediately after function returns.
+ *
+ * \include         _example_conn_send_pbuf.c
+ *
+ * \par             Completion of non-blocking send
+ *
+ * Non-blocking functions return as soon as command is queued.
+ * With \ref ESP_CFG_CMD_EVT enabled, completion function can be passed to \ref esp_conn_send_ex.
+ * It is called from producer thread with final result,
+ * when output parameters, such as number of bytes sent, are already written.
+ * Other non-blocking API functions get completion function with \ref esp_set_cmd_evt_fn,
+ * which is attached to next non-blocking command started by application.
+ *
+ * \include         _example_cmd_evt.c
+ *
+ * \section         sect_receive_data Receive data
+ *
+ * By default, device sends received data to host immediately with `+IPD` statement.
+ * If application cannot process them as fast as they arrive, data are lost in memory allocation
+ * or application queue.
+ *
+ * With \ref ESP_CFG_CONN_RECV_PASSIVE enabled, device holds TCP data in its own buffer
+ * and only reports their length. Stack reads them with `AT+CIPRECVDATA` for as long as
+ * number of bytes given to application and not yet confirmed
+ * stays below \ref ESP_CFG_CONN_RECV_WINDOW.
+ * When device buffer is full, remote side is not allowed to send more data.
+ *
+ * Application confirms data with \ref esp_conn_recved, once they are processed.
+ * Function may be called from any thread, but before packet buffer is freed.
+ * Netconn API confirms data when application takes them with \ref esp_netconn_receive.
+ *
+ * \note            Data not yet read from device are lost when connection is closed
+ *
  * \}
  */
\ No newline at end of file
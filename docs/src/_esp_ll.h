@@ -19,6 +19,20 @@
  *
  * \include         _example_ll.c
  *
+ * \par             POSIX host driver
+ *
+ * `esp_ll_posix.c` driver runs AT port over Unix socketpair, pseudo-terminal or serial device on Linux.
+ * Dedicated reader thread feeds received data in large blocks to input module.
+ * Channel is selected with `ESP_LL_POSIX_MODE` and other end is available with
+ * \ref esp_ll_posix_get_peer_fd or \ref esp_ll_posix_get_pty_name functions.
+ * Reader never takes more data than input buffer can accept, emulating hardware flow control.
+ *
+ * With `ESP_LL_POSIX_MODE` set to `ESP_LL_POSIX_SIM`, \ref ESP_SIM is started on other end of socketpair.
+ * It replies to AT commands like real device, with configurable UART speed, `SEND OK` loss and spontaneous resets,
+ * which allows measuring throughput and latency of the stack without hardware.
+ * See `docs/examples/_example_sim_benchmark.c` for usage
+ * and `docs/examples/_example_sim_send_timeout.c` for check of resources released after lost `SEND OK`.
+ *
  * \section         sect_input_process Input module
  *
  * Input module is a way how to send received data from AT port
@@ -49,6 +63,14 @@
  *
  * \include         _example_input_rx_irq.c
  *
+ * Buffer is lock-free for single writer and single reader, so \ref esp_input may be called
+ * from interrupt while processing thread reads the data, without any locking.
+ *
+ * When DMA or read function of operating system is used, data can be written directly to input buffer memory.
+ * \ref esp_input_reserve returns linear memory available for write
+ * and \ref esp_input_commit passes written bytes to processing thread, without intermediate copy.
+ * See `esp_ll_posix.c` for usage and `docs/examples/_example_buff_stress.c` for multi-threaded stress test of buffer.
+ *
  * \section         sect_input_method_2 Process data directly from receive thread
  *
  * When this usage is applied, separate thread must be introduce which only 
@@ -60,5 +60,15 @@
  *
  * \image html memory_manager_structure_freeing.svg Memory structure after freeing 2 blocks
  *
+ * \par             Slab allocator
+ *
+ * Most allocations of the stack are small and short living, such as command messages, timeouts and packet buffer headers.
+ * With \ref ESP_CFG_MEM_SLAB enabled, \ref ESP_CFG_MEM_SLAB_CLASSES size classes with \ref ESP_CFG_MEM_SLAB_BLOCKS blocks each
+ * are taken from regions when \ref esp_mem_assignmemory is called.
+ * Small requests are served from smallest fitting class in constant time and do not split heap blocks.
+ * When class is empty, request falls back to heap. Use \ref esp_mem_slab_get_stats to tune number of blocks.
+ *
+ * Fragmentation and speed can be compared with `docs/examples/_example_mem_benchmark.c`, which replays typical allocation trace.
+ *
  * \}
  */
\ No newline at end of file
@@ -86,5 +86,18 @@
  *
  * \include         _example_pbuf_chain.c
  *
+ * \par             Receive pool
+ *
+ * Every +IPD statement needs new packet buffer, allocated by processing thread.
+ * When heap is fragmented, allocation time varies and may even fail, in which case received data are lost.
+ *
+ * With \ref ESP_CFG_PBUF_POOL enabled, \ref ESP_CFG_PBUF_POOL_SIZE packet buffers
+ * of \ref ESP_CFG_PBUF_POOL_BUFF_SIZE bytes are taken from heap once in \ref esp_init function
+ * and are used only for received data. Packet buffer is taken from pool and returned to it with \ref esp_pbuf_free in constant time.
+ * When pool is exhausted, packet buffer is allocated from heap as before.
+ *
+ * Use \ref esp_pbuf_pool_get_stats to check high-water mark and number of times pool was exhausted,
+ * and size pool to number of packet buffers application holds at the same time.
+ *
  * \}
  */
\ No newline at end of file
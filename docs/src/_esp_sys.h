@@ -30,6 +30,9 @@
  *  - Keil RTX
  *  - FreeRTOS is not by default, but cmsis_os.c wrapper exists
  *      which allows you compatibility with standard CMSIS-OS functions
+ *
+ * For Linux and other POSIX hosts, `esp_sys_posix.c` port with pthreads is available.
+ * Enable \ref ESP_CFG_SYS_PORT_POSIX in configuration to select its system types.
  * 
  * \section         sect_os_functions OS functions
  *
@@ -0,0 +1,24 @@
+/**
+ * \addtogroup      ESP_TRANSPARENT
+ * \{
+ *
+ * In transparent mode, device opens single TCP or SSL connection
+ * and AT port carries raw data in both directions.
+ * There is no `AT+CIPSEND` command, prompt and `SEND OK` response for every packet,
+ * which makes it suitable for bulk transfers like firmware download or log upload.
+ *
+ * Device must not have any active connection or running server before transparent mode starts,
+ * as it requires single connection mode. Stack switches back to multiple connections
+ * when \ref esp_transparent_stop is called.
+ *
+ * Received data are given to receive function from processing thread,
+ * where they should be quickly copied, for example to ring buffer.
+ * While transparent mode is active, all other commands are rejected.
+ *
+ * \note            Transparent mode is left with `+++` sequence, which must be
+ *                  surrounded by \ref ESP_CFG_TRANSPARENT_GUARD_TIME without any data on AT port.
+ *
+ * \include         _example_transparent.c
+ *
+ * \}
+ */
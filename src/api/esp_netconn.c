@@ -47,9 +47,12 @@ typedef struct esp_netconn_t {
     
     size_t rcv_packets;                         /*!< Number of received packets so far on this connection */
     esp_conn_t* conn;                           /*!< Pointer to actual connection */
+#if ESP_CFG_CONN_RECV_PASSIVE
+    uint8_t conn_val_id;                        /*!< Validation ID of connection, received data are confirmed only while it matches */
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
     
-    esp_sys_sem_t mbox_accept;                  /*!< List of active connections waiting to be processed */
-    esp_sys_sem_t mbox_receive;                 /*!< Message queue for receive mbox */
+    esp_sys_mbox_t mbox_accept;                 /*!< List of active connections waiting to be processed */
+    esp_sys_mbox_t mbox_receive;                /*!< Message queue for receive mbox */
     
     uint8_t* buff;                              /*!< Pointer to buffer for \ref esp_netconn_write function. used only on TCP connection */
     size_t buff_len;                            /*!< Total length of buffer */
@@ -67,7 +70,7 @@ static void
 flush_mboxes(esp_netconn_t* nc) {
     esp_pbuf_t* pbuf;
     esp_netconn_t* new_nc;
-    if (esp_sys_sem_isvalid(&nc->mbox_receive)) {
+    if (esp_sys_mbox_isvalid(&nc->mbox_receive)) {
         do {
             if (!esp_sys_mbox_getnow(&nc->mbox_receive, (void **)&pbuf)) {
                 break;
@@ -77,7 +80,7 @@ flush_mboxes(esp_netconn_t* nc) {
             }
         } while (1);
     }
-    if (esp_sys_sem_isvalid(&nc->mbox_accept)) {
+    if (esp_sys_mbox_isvalid(&nc->mbox_accept)) {
         do {
             if (!esp_sys_mbox_getnow(&nc->mbox_accept, (void *)&new_nc)) {
                 break;
@@ -111,6 +114,9 @@ esp_cb(esp_cb_t* cb) {
                 nc = esp_conn_get_arg(conn);    /* Argument should be ready already */
                 if (nc) {                       /* Is netconn set? Should be already by us */
                     nc->conn = conn;            /* Save actual connection */
+#if ESP_CFG_CONN_RECV_PASSIVE
+                    nc->conn_val_id = conn->val_id;
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
                 } else {
                     close = 1;                  /* Close this connection, invalid netconn */
                 }
@@ -125,6 +131,9 @@ esp_cb(esp_cb_t* cb) {
                 
                 if (nc != NULL) {
                     nc->conn = conn;            /* Set connection callback */
+#if ESP_CFG_CONN_RECV_PASSIVE
+                    nc->conn_val_id = conn->val_id;
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
                     esp_conn_set_arg(conn, nc); /* Set argument for connection */
 #if ECP_CFG_NETCONN_ACCEPT_ON_CONNECT
                     /*
@@ -135,8 +144,8 @@ esp_cb(esp_cb_t* cb) {
                      * In case there is no listening connection,
                      * simply close the connection
                      */
-                    if (!esp_sys_mbox_isvalid(listen_api->mbox_accept) ||
-                        !esp_sys_mbox_putnow(listen_api->mbox_accept, nc)) {
+                    if (listen_api == NULL || !esp_sys_mbox_isvalid(&listen_api->mbox_accept) ||
+                        !esp_sys_mbox_putnow(&listen_api->mbox_accept, nc)) {
                         close = 1;
                     }
 #endif /* ECP_CFG_NETCONN_ACCEPT_ON_CONNECT */
@@ -166,7 +175,6 @@ esp_cb(esp_cb_t* cb) {
             uint8_t success = 0;
             nc = esp_conn_get_arg(conn);        /* Get API from connection */
 
-            esp_conn_recved(conn, pbuf);        /* Notify stack about received data */
 #if !ECP_CFG_NETCONN_ACCEPT_ON_CONNECT
             /*
              * Write data to listening connection accept mbox,
@@ -190,6 +198,7 @@ esp_cb(esp_cb_t* cb) {
             if (!close) {
                 if (!nc || !esp_sys_mbox_isvalid(&nc->mbox_receive) || 
                     !esp_sys_mbox_putnow(&nc->mbox_receive, pbuf)) {
+                    esp_conn_recved(conn, pbuf);/* Data will never reach application */
                     esp_pbuf_free(pbuf);        /* Free pbuf */
                     ESP_DEBUGF(ESP_CFG_DBG_NETCONN, "NETCONN: Ignoring more data for receive!\r\n");
                     return espOKIGNOREMORE;     /* Return OK to free the memory and ignore further data */
@@ -198,6 +207,7 @@ esp_cb(esp_cb_t* cb) {
                 }
             }
             if (!success) {
+                esp_conn_recved(conn, pbuf);    /* Data will never reach application */
                 esp_pbuf_free(pbuf);            /* Free pbuf */
             }
             ESP_DEBUGF(ESP_CFG_DBG_NETCONN | ESP_DBG_TYPE_TRACE, "NETCONN: Written %d bytes to receive mbox\r\n", cb->cb.conn_data_recv.buff->len);
@@ -537,6 +547,13 @@ esp_netconn_receive(esp_netconn_p nc, esp_pbuf_p* pbuf) {
         *pbuf = NULL;
         return espCLOSED;
     }
+#if ESP_CFG_CONN_RECV_PASSIVE
+    ESP_CORE_PROTECT();
+    if (nc->conn != NULL && nc->conn_val_id == nc->conn->val_id) {  /* Slot may be used by new connection already */
+        esp_conn_recved(nc->conn, *pbuf);       /* Notify stack that application took data */
+    }
+    ESP_CORE_UNPROTECT();
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
     return espOK;
 }
 
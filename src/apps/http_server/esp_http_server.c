@@ -627,15 +627,20 @@ http_evt_cb(esp_cb_t* cb) {
             esp_pbuf_p p = cb->cb.conn_data_recv.buff;
             size_t pos;
             
+            esp_conn_recved(conn, p);           /* Notify stack about received data */
             if (hs != NULL) {                   /* Do we have a valid http state? */
                 /*
                  * Check if we have to receive headers data first
                  * before we can proceed with everything else
                  */
                 if (!hs->headers_received) {    /* Are we still waiting for headers data? */
+                    size_t search_off = 0;
                     if (hs->p == NULL) {
                         hs->p = p;              /* This is a first received packet */
                     } else {
+                        /* Previous data were already searched, only sequence split between packets can be found there */
+                        search_off = esp_pbuf_length(hs->p, 1);
+                        search_off = search_off > 3 ? search_off - 3 : 0;
                         esp_pbuf_cat(hs->p, p); /* Add new packet to the end of linked list of recieved data */
                     }
                 
@@ -643,7 +648,7 @@ http_evt_cb(esp_cb_t* cb) {
                      * Check if headers are fully received.
                      * To know this, search for "\r\n\r\n" sequence in received data
                      */
-                    if ((pos = esp_pbuf_strfind(hs->p, CRLF CRLF, 0)) != ESP_SIZET_MAX) {
+                    if ((pos = esp_pbuf_strfind(hs->p, CRLF CRLF, search_off)) != ESP_SIZET_MAX) {
                         uint8_t http_uri_parsed;
                         ESP_DEBUGF(ESP_CFG_DBG_SERVER_TRACE, "SERVER HTTP headers received!\r\n");
                         hs->headers_received = 1;   /* Flag received headers */
@@ -670,12 +675,11 @@ http_evt_cb(esp_cb_t* cb) {
                             data_pos = pos + 4; /* Ignore 4 bytes of CRLF sequence */
                             
                             /*
-                             * Try to find content length on this request
-                             * search for 2 possible values "Content-Length" or "content-length" parameters
+                             * Try to find content length on this request,
+                             * header names are case insensitive
                              */
                             hs->content_length = 0;
-                            if (((pos = esp_pbuf_strfind(hs->p, "Content-Length:", 0)) != ESP_SIZET_MAX) ||
-                                (pos = esp_pbuf_strfind(hs->p, "content-length:", 0)) != ESP_SIZET_MAX) {
+                            if ((pos = esp_pbuf_strfind_nocase(hs->p, "Content-Length:", 0)) != ESP_SIZET_MAX) {
                                 uint8_t ch;
                                 
                                 pos += 15;      /* Skip this part */
@@ -798,7 +802,6 @@ http_evt_cb(esp_cb_t* cb) {
                 esp_pbuf_free(p);               /* Free packet buffer */
                 close = 1;
             }
-            esp_conn_recved(conn, p);           /* Notify stack about received data */
             break;
         }
         
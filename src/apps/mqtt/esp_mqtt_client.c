@@ -45,6 +45,7 @@
 
 static espr_t   mqtt_conn_cb(esp_cb_t* cb);
 static void     send_data(mqtt_client_t* client);
+static void     mqtt_keep_alive_cb(void* arg);
 
 /**
  * \brief           List of MQTT message types
@@ -326,6 +327,19 @@ write_string(mqtt_client_t* client, const char* str, uint16_t len) {
     esp_buff_write(&client->tx_buff, (const void *)str, len);   /* Write string to buffer */
 }
 
+/**
+ * \brief           Restart keep-alive timeout after packet was sent or received
+ * \param[in]       client: MQTT client
+ */
+static void
+keep_alive_restart(mqtt_client_t* client) {
+    if (client->info->keep_alive) {             /* Keep alive must be enabled */
+        /* Keep alive is in units of seconds */
+        esp_timeout_start(&client->keep_alive_timeout, client->info->keep_alive * 1000,
+            client->info->keep_alive * 1000, mqtt_keep_alive_cb, client);
+    }
+}
+
 /**
  * \brief           Send the actual data to the remote
  * \param[in]       client: MQTT client
@@ -724,7 +738,7 @@ mqtt_connected_cb(mqtt_client_t* client) {
     
     client->parser_state = MQTT_PARSER_STATE_INIT;  /* Reset parser state */
     
-    client->poll_time = 0;                      /* Reset kep alive time */
+    keep_alive_restart(client);                 /* Reset keep alive time */
     client->conn_state = MQTT_CONNECTING;       /* MQTT is connecting to server */
 
     send_data(client);                          /* Flush and send the actual data */
@@ -738,7 +752,7 @@ mqtt_connected_cb(mqtt_client_t* client) {
  */
 static uint8_t
 mqtt_data_recv_cb(mqtt_client_t* client, esp_pbuf_p pbuf) {
-    client->poll_time = 0;                      /* Reset kep alive time */
+    keep_alive_restart(client);                 /* Reset keep alive time */
     mqtt_parse_incoming(client, pbuf);
     esp_conn_recved(client->conn, pbuf);        /* Notify stack about received data */
     esp_pbuf_free(pbuf);                        /* Free memory after usage */
@@ -758,7 +772,7 @@ mqtt_data_sent_cb(mqtt_client_t* client, size_t sent_len, uint8_t successful) {
     client->is_sending = 0;                     /* We are not sending anymore */
     client->sent_total += sent_len;
 
-    client->poll_time = 0;                      /* Reset kep alive time */
+    keep_alive_restart(client);                 /* Reset keep alive time */
     
     /*
      * Even if sent was in general not successful,
@@ -797,36 +811,26 @@ mqtt_data_sent_cb(mqtt_client_t* client, size_t sent_len, uint8_t successful) {
 }
 
 /**
- * \brief           Poll for client connection
- *                  Called every ESP_CFG_CONN_POLL_INTERVAL ms when MQTT client TCP connection is established
- * \param[in]       client: MQTT client
- * \return          1 on success, 0 otherwise
+ * \brief           Keep-alive timeout callback
+ *                  Called when nothing was sent or received for keep alive time
+ * \param[in]       arg: MQTT client
  */
-static uint8_t
-mqtt_poll_cb(mqtt_client_t* client) {
-    client->poll_time++;
+static void
+mqtt_keep_alive_cb(void* arg) {
+    mqtt_client_t* client = arg;
     
     /*
-     * Check for keep-alive time if equal or greater than
-     * keep alive time. In that case, send packet 
-     * to make sure we are still alive
+     * Send packet to make sure we are still alive.
+     * Timeout is periodic and restarted when PINGREQ is sent
      */
-    if (client->info->keep_alive &&             /* Keep alive must be enabled */
-        /* Poll time is in units of ESP_CFG_CONN_POLL_INTERVAL milliseconds,
-           while keep_alive is in units of seconds */
-        (client->poll_time * ESP_CFG_CONN_POLL_INTERVAL) >= (client->info->keep_alive * 1000)) {
-            
-        if (output_check_enough_memory(client, 0)) {/* Check if memory available in output buffer */
-            write_fixed_header(client, MQTT_MSG_TYPE_PINGREQ, 0, 0, 0, 0);  /* Write PINGREQ command to output buffer */
-            send_data(client);                  /* Force send data */
-            client->poll_time = 0;              /* Reset polling time */
-            
-            ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE, "MQTT sending PINGREQ packet\r\n");
-        } else {
-            ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE_WARNING, "MQTT no memory to send PINGREQ packet\r\n");
-        }
+    if (output_check_enough_memory(client, 0)) {/* Check if memory available in output buffer */
+        write_fixed_header(client, MQTT_MSG_TYPE_PINGREQ, 0, 0, 0, 0);  /* Write PINGREQ command to output buffer */
+        send_data(client);                      /* Force send data */
+        
+        ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE, "MQTT sending PINGREQ packet\r\n");
+    } else {
+        ESP_DEBUGF(ESP_CFG_DBG_MQTT_TRACE_WARNING, "MQTT no memory to send PINGREQ packet\r\n");
     }
-    return 1;
 }
 
 /**
@@ -837,6 +841,7 @@ mqtt_poll_cb(mqtt_client_t* client) {
 static uint8_t
 mqtt_closed_cb(mqtt_client_t* client) {
     client->conn_state = MQTT_CONN_DISCONNECTED;/* Connection is disconnected, ready to be established again */
+    esp_timeout_stop(&client->keep_alive_timeout);  /* Stop keep alive */
     
     client->evt.type = MQTT_EVT_DISCONNECT;     /* Connection disconnected from server */
     client->evt_fn(client, &client->evt);       /* Notify upper layer about closed connection */
@@ -925,14 +930,6 @@ mqtt_conn_cb(esp_cb_t* cb) {
             break;
         }
         
-        /*
-         * Periodic poll for connection
-         */
-        case ESP_CB_CONN_POLL: {
-            mqtt_poll_cb(client);               /* Poll client */
-            break;
-        }
-        
         /*
          * Connection closed for some reason
          */
@@ -986,6 +983,7 @@ mqtt_client_new(size_t tx_buff_len, size_t rx_buff_len) {
 void
 mqtt_client_delete(mqtt_client_t* client) {
     if (client != NULL) {
+        esp_timeout_stop(&client->keep_alive_timeout);  /* Make sure timeout does not use client anymore */
         if (client->rx_buff != NULL) {
             esp_mem_free(client->rx_buff);      /* Free RX buffer memory */
             client->rx_buff = NULL;
@@ -87,6 +87,13 @@ esp_init(esp_cb_fn cb_func) {
     
     esp_sys_init();                             /* Init low-level system */
     esp_ll_init(&esp.ll, ESP_CFG_AT_PORT_BAUDRATE); /* Init low-level communication */
+    esp.baudrate = ESP_CFG_AT_PORT_BAUDRATE;
+#if ESP_CFG_PBUF_POOL
+    espi_pbuf_pool_init();                      /* Take memory for receive packet buffers, after memory is assigned */
+#endif /* ESP_CFG_PBUF_POOL */
+#if ESP_CFG_MSG_POOL
+    espi_msg_pool_init();                       /* Take memory for API messages, after memory is assigned */
+#endif /* ESP_CFG_MSG_POOL */
     
     esp_sys_sem_create(&esp.sem_sync, 1);       /* Create new semaphore with unlocked state */
     esp_sys_mbox_create(&esp.mbox_producer, ESP_CFG_THREAD_PRODUCER_MBOX_SIZE); /* Producer message queue */
@@ -238,6 +245,37 @@ esp_dns_getbyhostname(const char* host, void* ip, uint32_t blocking) {
     return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, blocking, 20000);   /* Send message to producer queue */
 }
 
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+
+/**
+ * \brief           Get IP address from host name in non-blocking way and get notified when it finishes
+ * \param[in]       host: Pointer to host name to get IP for. Must be valid until completion function is called
+ * \param[out]      ip: Pointer to output variable to save result. At least 4 bytes required
+ * \param[in]       evt_fn: Completion function called with final result of command.
+ *                      Set to `NULL` to use function set with \ref esp_set_cmd_evt_fn
+ * \param[in]       evt_arg: Custom user argument passed to completion function
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_dns_getbyhostname_ex(const char* host, void* ip, esp_cmd_evt_fn evt_fn, void* evt_arg) {
+    ESP_MSG_VAR_DEFINE(msg);                    /* Define variable for message */
+    
+    ESP_ASSERT("host != NULL", host != NULL);   /* Assert input parameters */
+    ESP_ASSERT("ip != NULL", ip != NULL);       /* Assert input parameters */
+    
+    ESP_MSG_VAR_ALLOC(msg);                     /* Allocate memory for variable */
+    ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_TCPIP_CIPDOMAIN;
+    ESP_MSG_VAR_REF(msg).msg.dns_getbyhostname.host = host;
+    ESP_MSG_VAR_REF(msg).msg.dns_getbyhostname.ip = ip;
+    ESP_MSG_VAR_REF(msg).evt_fn = evt_fn;
+    ESP_MSG_VAR_REF(msg).evt_arg = evt_arg;
+    ESP_MSG_VAR_REF(msg).evt_set = evt_fn != NULL;
+    
+    return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, 0, 20000);  /* Send message to producer queue */
+}
+
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
+
 #endif /* ESP_CFG_DNS || __DOXYGEN__ */
 
 /**
@@ -260,3 +298,83 @@ esp_core_unlock(void) {
     return espOK;
 }
 
+
+#if ESP_CFG_PRODUCER_PRIO || __DOXYGEN__
+
+/**
+ * \brief           Get statistics of producer priority lane
+ * \param[in]       prio: Priority lane, member of \ref esp_prio_t enumeration
+ * \param[out]      stats: Pointer to output structure
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_get_prio_stats(esp_prio_t prio, esp_prio_stats_t* stats) {
+    esp_prio_lane_t* lane;
+    
+    ESP_ASSERT("prio < ESP_PRIO_END", prio < ESP_PRIO_END); /* Assert input parameters */
+    ESP_ASSERT("stats != NULL", stats != NULL); /* Assert input parameters */
+    
+    ESP_CORE_PROTECT();
+    lane = &esp.prio[prio];
+    stats->queued = lane->queued;
+    stats->queued_max = lane->queued_max;
+    stats->executed = lane->executed;
+    stats->wait_avg = lane->executed ? lane->wait_total / lane->executed : 0;
+    stats->wait_max = lane->wait_max;
+    ESP_CORE_UNPROTECT();
+    return espOK;
+}
+
+#endif /* ESP_CFG_PRODUCER_PRIO || __DOXYGEN__ */
+
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+
+/**
+ * \brief           Set completion function for next command started by API function
+ *
+ *                  Function is attached to the first non-blocking command queued by application after this call
+ *                  and called from producer thread when command finishes.
+ *                  Output parameters passed to API function are valid at that time.
+ *                  Blocking commands and commands queued by stack itself,
+ *                  such as flush of data written with \ref esp_conn_write, leave it for next command
+ *
+ * \note            Use \ref esp_core_lock and \ref esp_core_unlock around this call
+ *                  and API function to prevent other threads taking the callback.
+ *                  Functions with `_ex` suffix, such as \ref esp_conn_send_ex, take completion function
+ *                  as parameter and do not need this
+ *
+ * \note            Completion function is called only when API function returned `espOK`.
+ *                  Clear setting after API function returned error before command was queued
+ *
+ * \param[in]       fn: Completion function or `NULL` to clear previous setting
+ * \param[in]       arg: Custom user argument passed to completion function
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_set_cmd_evt_fn(esp_cmd_evt_fn fn, void* arg) {
+    ESP_CORE_PROTECT();
+    esp.cmd_evt_fn = fn;
+    esp.cmd_evt_arg = arg;
+    ESP_CORE_UNPROTECT();
+    return espOK;
+}
+
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
+
+#if ESP_CFG_CMD_COALESCE || __DOXYGEN__
+
+/**
+ * \brief           Get number of requests served by result of the same query already queued
+ * \return          Number of AT commands saved by coalescing
+ */
+uint32_t
+esp_get_coalesced_count(void) {
+    uint32_t cnt;
+    
+    ESP_CORE_PROTECT();
+    cnt = esp.co_saved;
+    ESP_CORE_UNPROTECT();
+    return cnt;
+}
+
+#endif /* ESP_CFG_CMD_COALESCE || __DOXYGEN__ */
@@ -0,0 +1,200 @@
+/**	
+ * \file            esp_baudrate.c
+ * \brief           AT port baudrate negotiation API
+ */
+ 
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *  
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#define ESP_INTERNAL
+#include "esp/esp_private.h"
+#include "esp/esp_baudrate.h"
+#include "esp/esp_mem.h"
+#include "system/esp_ll.h"
+
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__
+
+/* Candidates used when application does not provide its own list */
+static const uint32_t
+bauds_def[ESP_BAUDRATE_DEFAULT_COUNT] = { 115200, 230400, 460800, 921600, 1500000, 2000000, 3000000 };
+
+/**
+ * \brief           Verify AT port at current baudrate with payload round trips
+ * \param[in]       rounds: Number of round trips. Use `0` to only test AT startup
+ * \param[out]      bytes_per_sec: Pointer to output variable for measured throughput. Set to `NULL` if not used
+ * \return          espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+baudrate_check(size_t rounds, uint32_t* bytes_per_sec) {
+    ESP_MSG_VAR_DEFINE(msg);                    /* Define variable for message */
+    uint32_t bytes;
+    
+    ESP_MSG_VAR_ALLOC(msg);                     /* Allocate memory for variable */
+    ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_UART_CHECK;
+    ESP_MSG_VAR_REF(msg).cmd = ESP_CMD_AT;
+    ESP_MSG_VAR_REF(msg).msg.uart_check.rounds = rounds;
+    ESP_MSG_VAR_REF(msg).msg.uart_check.bytes_per_sec = bytes_per_sec;
+    
+    /* Allow transfer time of all lines with 10 bits per byte on top of response time */
+    bytes = 64 + 2 * (uint32_t)rounds * (ESP_CFG_AT_BAUDRATE_CHECK_LEN + 32);
+    return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, 1,
+        1000 + (uint32_t)((uint64_t)bytes * 10000 / esp_baudrate_get()));  /* Send message to producer queue */
+}
+
+/**
+ * \brief           Change baudrate on host side of AT port only
+ * \param[in]       baud: New baudrate in units of bits per second
+ */
+static void
+baudrate_set_host(uint32_t baud) {
+    ESP_CORE_PROTECT();
+    if (esp.baudrate != baud) {
+        esp_ll_init(&esp.ll, baud);
+        esp.baudrate = baud;
+    }
+    ESP_CORE_UNPROTECT();
+}
+
+/**
+ * \brief           Bring both sides of AT port back to last working baudrate
+ *
+ *                  Depending on which bytes were corrupted, device may run at either baudrate
+ *                  or even at different one, therefore host tries to reach it at both and
+ *                  sets good baudrate again until round trips succeed
+ *
+ * \param[in]       good: Last baudrate which passed verification
+ * \param[in]       tried: Baudrate which failed verification
+ * \return          espOK when AT port works at good baudrate again, member of \ref espr_t otherwise
+ */
+static espr_t
+baudrate_restore(uint32_t good, uint32_t tried) {
+    uint32_t host[2];
+    size_t i, k;
+    
+    host[0] = esp_baudrate_get();
+    host[1] = host[0] == good ? tried : good;
+    for (i = 0; i < ESP_ARRAYSIZE(host); i++) {
+        baudrate_set_host(host[i]);
+        for (k = 0; k < 3; k++) {               /* Errors are expected at bad baudrate, try few times */
+            if (((!k && esp_baudrate_get() == good) || esp_set_at_baudrate(good, 1) == espOK)
+                && baudrate_check(ESP_CFG_AT_BAUDRATE_CHECK_ROUNDS, NULL) == espOK) {
+                return espOK;
+            }
+        }
+    }
+    return espERR;
+}
+
+/**
+ * \brief           Step through candidate baudrates of AT port and stay at the highest working one
+ *
+ *                  Every candidate is set with \ref esp_set_at_baudrate and verified
+ *                  with AT startup test and \ref ESP_CFG_AT_BAUDRATE_CHECK_ROUNDS round trips
+ *                  of \ref ESP_CFG_AT_BAUDRATE_CHECK_LEN bytes long payload, echoed back by device
+ *                  and compared by length and checksum.
+ *                  On first failed candidate, both sides go back to last working baudrate
+ *                  and negotiation stops.
+ *
+ * \note            Function is blocking and may not be called from callback function
+ * \param[in]       bauds: Candidate baudrates in ascending order.
+ *                      Set to `NULL` to use default list from `115200` to `3000000` with \ref ESP_BAUDRATE_DEFAULT_COUNT entries
+ * \param[in]       count: Number of candidates in list, ignored when default list is used
+ * \param[out]      steps: Pointer to array of `count` entries to save result of each step. Set to `NULL` if not used
+ * \param[out]      baudrate: Pointer to output variable to save final baudrate. Set to `NULL` if not used
+ * \return          espOK when AT port works at final baudrate, member of \ref espr_t otherwise.
+ *                  In case of error, device is not reachable any more and should be reset by hardware
+ */
+espr_t
+esp_baudrate_negotiate(const uint32_t* bauds, size_t count, esp_baudrate_step_t* steps, uint32_t* baudrate) {
+    uint32_t good, bps;
+    espr_t res = espOK;
+    size_t i;
+    
+    if (bauds == NULL) {
+        bauds = bauds_def;
+        count = ESP_ARRAYSIZE(bauds_def);
+    }
+    ESP_ASSERT("count > 0", count > 0);         /* Assert input parameters */
+    
+    if (steps != NULL) {
+        memset(steps, 0x00, count * sizeof(*steps));
+    }
+    good = esp_baudrate_get();
+    for (i = 0; i < count; i++) {
+        bps = 0;
+        if (bauds[i] != esp_baudrate_get()) {
+            res = esp_set_at_baudrate(bauds[i], 1); /* Both sides switch after OK */
+        }
+        if (res == espOK) {
+            res = baudrate_check(ESP_CFG_AT_BAUDRATE_CHECK_ROUNDS, &bps);
+        }
+        if (steps != NULL) {
+            steps[i].baudrate = bauds[i];
+            steps[i].res = res;
+            steps[i].bytes_per_sec = bps;
+        }
+        if (res != espOK) {
+            res = baudrate_restore(good, bauds[i]);
+            break;
+        }
+        good = bauds[i];
+    }
+    if (baudrate != NULL) {
+        *baudrate = esp_baudrate_get();
+    }
+    return res;
+}
+
+/**
+ * \brief           Verify AT port at current baudrate and measure its throughput
+ *
+ *                  The same payload round trips are used as for every step of \ref esp_baudrate_negotiate
+ *
+ * \note            Function is blocking and may not be called from callback function
+ * \param[out]      bytes_per_sec: Pointer to output variable for effective throughput in units of bytes per second. Set to `NULL` if not used
+ * \return          espOK when all round trips succeeded, member of \ref espr_t otherwise
+ */
+espr_t
+esp_baudrate_check(uint32_t* bytes_per_sec) {
+    return baudrate_check(ESP_CFG_AT_BAUDRATE_CHECK_ROUNDS, bytes_per_sec);
+}
+
+/**
+ * \brief           Get current baudrate of AT port
+ * \return          Baudrate in units of bits per second
+ */
+uint32_t
+esp_baudrate_get(void) {
+    uint32_t baud;
+    
+    ESP_CORE_PROTECT();
+    baud = esp.baudrate;
+    ESP_CORE_UNPROTECT();
+    return baud;
+}
+
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__ */
@@ -81,15 +81,16 @@ esp_buff_free(esp_buff_t* buff) {
 size_t
 esp_buff_write(esp_buff_t* buff, const void* data, size_t count) {
 	size_t i = 0;
-	size_t free;
+	size_t free, in;
     const uint8_t* d = data;
     size_t tocopy;
 
     if (buff == NULL || count == 0) {           /* Check buffer structure */
         return 0;
     }
-    if (buff->in >= buff->size) {               /* Check input pointer */
-        buff->in = 0;
+    in = buff->in;                              /* Input pointer is only modified by writer */
+    if (in >= buff->size) {                     /* Check input pointer */
+        in = 0;
     }
     free = esp_buff_get_free(buff);             /* Get free memory */
     if (free < count) {                         /* Check available memory */	
@@ -100,21 +101,22 @@ esp_buff_write(esp_buff_t* buff, const void* data, size_t count) {
     }
 
     /* We have calculated memory for write */
-    tocopy = buff->size - buff->in;             /* Calculate number of elements we can put at the end of buffer */
+    tocopy = buff->size - in;                   /* Calculate number of elements we can put at the end of buffer */
     if (tocopy > count) {                       /* Check for copy count */
         tocopy = count;
     }
-    memcpy(&buff->buff[buff->in], d, tocopy);   /* Copy content to buffer */
+    memcpy(&buff->buff[in], d, tocopy);         /* Copy content to buffer */
     i += tocopy;                                /* Increase number of bytes we copied already */
-    buff->in += tocopy;	
+    in += tocopy;
     count -= tocopy;
     if (count > 0) {                            /* Check if anything to write */	
         memcpy(buff->buff, (void *)&d[i], count);   /* Copy content */
-        buff->in = count;									/* Set input pointer */
+        in = count;                             /* Set input pointer */
     }
-    if (buff->in >= buff->size) {               /* Check input overflow */
-        buff->in = 0;
+    if (in >= buff->size) {                     /* Check input overflow */
+        in = 0;
     }
+    ESP_BUFF_STORE(buff->in, in);               /* Publish data to reader after it is copied */
     return (i + count);                         /* Return number of elements stored in memory */
 }
 
@@ -128,14 +130,15 @@ esp_buff_write(esp_buff_t* buff, const void* data, size_t count) {
 size_t
 esp_buff_read(esp_buff_t* buff, void* data, size_t count) {
     uint8_t *d = data;
-    size_t i = 0, full;
+    size_t i = 0, full, out;
     size_t tocopy;
 
     if (buff == NULL || count == 0) {           /* Check buffer structure */
         return 0;
     }
-    if (buff->out >= buff->size) {              /* Check output pointer */
-        buff->out = 0;
+    out = buff->out;                            /* Output pointer is only modified by reader */
+    if (out >= buff->size) {                    /* Check output pointer */
+        out = 0;
     }
     full = esp_buff_get_full(buff);             /* Get free memory */
     if (full < count) {                         /* Check available memory */
@@ -145,21 +148,22 @@ esp_buff_read(esp_buff_t* buff, void* data, size_t count) {
         count = full;                           /* Set values for write */
     }
 
-    tocopy = buff->size - buff->out;            /* Calculate number of elements we can read from end of buffer */
+    tocopy = buff->size - out;                  /* Calculate number of elements we can read from end of buffer */
     if (tocopy > count) {                       /* Check for copy count */
         tocopy = count;
     }
-    memcpy(d, &buff->buff[buff->out], tocopy);  /* Copy content from buffer */
+    memcpy(d, &buff->buff[out], tocopy);        /* Copy content from buffer */
     i += tocopy;                                /* Increase number of bytes we copied already */
-    buff->out += tocopy;
+    out += tocopy;
     count -= tocopy;
     if (count > 0) {                            /* Check if anything to read */
         memcpy(&d[i], buff->buff, count);       /* Copy content */
-        buff->out = count;                      /* Set input pointer */
+        out = count;                            /* Set output pointer */
     }
-    if (buff->out >= buff->size) {              /* Check output overflow */
-        buff->out = 0;
+    if (out >= buff->size) {                    /* Check output overflow */
+        out = 0;
     }
+    ESP_BUFF_STORE(buff->out, out);             /* Give memory back to writer after it is copied */
     return i + count;                           /* Return number of elements stored in memory */
 }
 
@@ -180,8 +184,8 @@ esp_buff_peek(esp_buff_t* buff, size_t skip_count, void* data, size_t count) {
         return 0;
     }
     out = buff->out;
-    if (buff->out >= buff->size) {              /* Check output pointer */
-        buff->out = 0;
+    if (out >= buff->size) {                    /* Check output pointer */
+        out = 0;
     }
     full = esp_buff_get_full(buff);             /* Get free memory */
     if (skip_count >= full) {                   /* We cannot skip for more than we have in buffer */
@@ -224,8 +228,8 @@ esp_buff_get_free(esp_buff_t* buff) {
     if (buff == NULL) {                         /* Check buffer structure */
         return 0;
     }
-    in = buff->in;                              /* Save values */
-    out = buff->out;
+    in = ESP_BUFF_LOAD(buff->in);               /* Save values */
+    out = ESP_BUFF_LOAD(buff->out);
     if (in == out) {                            /* Check if the same */
         size = buff->size;
     } else if (out > in) {                      /* Check normal mode */
@@ -248,8 +252,8 @@ esp_buff_get_full(esp_buff_t* buff) {
     if (buff == NULL) {                         /* Check buffer structure */
         return 0;
     }
-    in = buff->in;                              /* Save values */
-    out = buff->out;
+    in = ESP_BUFF_LOAD(buff->in);               /* Save values */
+    out = ESP_BUFF_LOAD(buff->out);
     if (in == out) {                            /* Pointer are same? */
         size = 0;
     } else if (in > out) {                      /* buff is not in overflow mode */
@@ -262,6 +266,7 @@ esp_buff_get_full(esp_buff_t* buff) {
 
 /**
  * \brief           Resets and clears buffer
+ * \note            Writer and reader must not access buffer at the same time
  * \param[in]       buff: Pointer to buffer structure
  */
 void
@@ -290,11 +295,13 @@ esp_buff_get_linear_block_address(esp_buff_t* buff) {
  */
 size_t
 esp_buff_get_linear_block_length(esp_buff_t* buff) {
-    size_t len;
-    if (buff->in > buff->out) {
-        len = buff->in - buff->out;
-    } else if (buff->out > buff->in) {
-        len = buff->size - buff->out;
+    size_t len, in, out;
+    in = ESP_BUFF_LOAD(buff->in);
+    out = buff->out;
+    if (in > out) {
+        len = in - out;
+    } else if (out > in) {
+        len = buff->size - out;
     } else {
         len = 0;
     }
@@ -310,14 +317,72 @@ esp_buff_get_linear_block_length(esp_buff_t* buff) {
  */
 size_t
 esp_buff_skip(esp_buff_t* buff, size_t len) {
-    size_t full;
+    size_t full, out;
     full = esp_buff_get_full(buff);             /* Get buffer used length */
     if (len > full) {
         len = full;
     }
-    buff->out += len;                           /* Advance buffer */
-    if (buff->out >= buff->size) {              /* Subtract possible overflow */
-        buff->out -= buff->size;                /* Do subtract */
+    out = buff->out + len;                      /* Advance buffer */
+    if (out >= buff->size) {                    /* Subtract possible overflow */
+        out -= buff->size;                      /* Do subtract */
+    }
+    ESP_BUFF_STORE(buff->out, out);
+    return len;
+}
+
+/**
+ * \brief           Get linear address for buffer for fast write
+ *
+ *                  Writer (DMA or read function) may put data directly to this memory
+ *                  and call \ref esp_buff_advance afterwards to make them available for reader
+ *
+ * \param[in]       buff: Pointer to buffer
+ * \return          Pointer to start of linear address for write
+ */
+void *
+esp_buff_get_linear_block_write_address(esp_buff_t* buff) {
+    return &buff->buff[buff->in];               /* Return write address */
+}
+
+/**
+ * \brief           Get length of linear block address for write before it overflows
+ * \param[in]       buff: Pointer to buffer
+ * \return          Length of linear address for write
+ */
+size_t
+esp_buff_get_linear_block_write_length(esp_buff_t* buff) {
+    size_t len, in, out;
+    in = buff->in;
+    out = ESP_BUFF_LOAD(buff->out);
+    if (in >= out) {
+        len = buff->size - in;
+        if (out == 0) {                         /* One byte must stay empty to not overwrite unread data */
+            len--;
+        }
+    } else {
+        len = out - in - 1;
+    }
+    return len;
+}
+
+/**
+ * \brief           Advance write pointer after data were written directly to buffer memory
+ * \note            Useful at the end of streaming transfer such as DMA
+ * \param[in]       buff: Pointer to buffer structure
+ * \param[in]       len: Number of bytes written to linear block for write
+ * \return          Number of bytes added to buffer
+ */
+size_t
+esp_buff_advance(esp_buff_t* buff, size_t len) {
+    size_t free, in;
+    free = esp_buff_get_free(buff);             /* Get buffer free length */
+    if (len > free) {
+        len = free;
+    }
+    in = buff->in + len;                        /* Advance buffer */
+    if (in >= buff->size) {                     /* Subtract possible overflow */
+        in -= buff->size;                       /* Do subtract */
     }
+    ESP_BUFF_STORE(buff->in, in);               /* Publish data to reader */
     return len;
 }
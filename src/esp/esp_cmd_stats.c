@@ -0,0 +1,271 @@
+/**	
+ * \file            esp_cmd_stats.c
+ * \brief           Command latency statistics and tracing
+ */
+ 
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *  
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#define ESP_INTERNAL
+#include "esp/esp_private.h"
+#include "esp/esp_cmd_stats.h"
+#include "stdarg.h"
+
+#if ESP_CFG_CMD_STATS || __DOXYGEN__
+
+/**
+ * \brief           Collected statistics of single command
+ */
+typedef struct {
+    uint32_t count;                             /*!< Number of finished commands */
+    uint32_t errors;                            /*!< Number of commands finished with error */
+    uint32_t timeouts;                          /*!< Number of commands finished with timeout */
+    uint32_t resp;                              /*!< Number of commands with at least one response byte */
+    uint32_t queue_sum;                         /*!< Sum of times in producer queue */
+    uint32_t first_sum;                         /*!< Sum of times to first response byte */
+    uint32_t exec_sum;                          /*!< Sum of execution times */
+    uint32_t exec_max;                          /*!< Maximal execution time */
+    uint32_t hist[ESP_CFG_CMD_STATS_BUCKETS];   /*!< Log2 histogram of execution times */
+} cmd_stats_t;
+
+static cmd_stats_t cmd_stats[ESP_CMD_END];
+#if ESP_CFG_CMD_STATS_TRACE_LEN
+static esp_cmd_trace_t cmd_trace[ESP_CFG_CMD_STATS_TRACE_LEN];
+static size_t cmd_trace_w;                      /* Index of next entry to write */
+static size_t cmd_trace_cnt;                    /* Number of valid entries */
+#endif /* ESP_CFG_CMD_STATS_TRACE_LEN */
+
+/**
+ * \brief           Get histogram bucket for execution time
+ * \param[in]       ms: Execution time in units of milliseconds
+ * \return          Bucket index
+ */
+static size_t
+hist_bucket(uint32_t ms) {
+    size_t b = 0;
+    for (; ms; ms >>= 1) {                      /* Number of significant bits is log2 + 1 */
+        b++;
+    }
+    return ESP_MIN(b, ESP_CFG_CMD_STATS_BUCKETS - 1);
+}
+
+/**
+ * \brief           Add finished command to statistics and trace
+ * \note            Function must be called from protected area when command is finished
+ * \param[in]       msg: Finished message
+ */
+void
+espi_cmd_stats_finish(esp_msg_t* msg) {
+    cmd_stats_t* s;
+    uint32_t now, exec;
+    
+    if (msg->cmd_def >= ESP_CMD_END) {
+        return;
+    }
+    now = esp_sys_now();
+    if (!msg->t_started) {                      /* Command finished without being started */
+        msg->t_start = now;
+    }
+    exec = now - msg->t_start;
+    
+    s = &cmd_stats[msg->cmd_def];
+    s->count++;
+    if (msg->res == espTIMEOUT) {
+        s->timeouts++;
+    } else if (msg->res != espOK) {
+        s->errors++;
+    }
+    s->queue_sum += msg->t_start - msg->t_enqueue;
+    if (msg->t_resp) {
+        s->resp++;
+        s->first_sum += msg->t_first - msg->t_start;
+    }
+    s->exec_sum += exec;
+    if (exec > s->exec_max) {
+        s->exec_max = exec;
+    }
+    s->hist[hist_bucket(exec)]++;
+    
+#if ESP_CFG_CMD_STATS_TRACE_LEN
+    cmd_trace[cmd_trace_w].cmd = (uint16_t)msg->cmd_def;
+    cmd_trace[cmd_trace_w].res = msg->res;
+    cmd_trace[cmd_trace_w].t_enqueue = msg->t_enqueue;
+    cmd_trace[cmd_trace_w].t_start = msg->t_start;
+    cmd_trace[cmd_trace_w].t_first = msg->t_resp ? msg->t_first : now;
+    cmd_trace[cmd_trace_w].t_end = now;
+    cmd_trace_w = (cmd_trace_w + 1) % ESP_CFG_CMD_STATS_TRACE_LEN;
+    if (cmd_trace_cnt < ESP_CFG_CMD_STATS_TRACE_LEN) {
+        cmd_trace_cnt++;
+    }
+#endif /* ESP_CFG_CMD_STATS_TRACE_LEN */
+}
+
+/**
+ * \brief           Get name of command
+ * \param[in]       cmd: Command number, as used in \ref esp_cmd_trace_t and \ref esp_cmd_stats_get
+ * \return          Name of AT command, such as `TCPIP_CIPSEND`, or `UNKNOWN` for invalid number
+ */
+const char *
+esp_cmd_stats_name(uint16_t cmd) {
+    if (cmd >= ESP_CMD_END) {
+        return "UNKNOWN";
+    }
+    return espi_dbg_msg_to_string((esp_cmd_t)cmd);
+}
+
+/**
+ * \brief           Get statistics of command
+ * \param[in]       cmd: Command number
+ * \param[out]      stats: Pointer to output structure
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_cmd_stats_get(uint16_t cmd, esp_cmd_stats_t* stats) {
+    cmd_stats_t* s;
+    
+    ESP_ASSERT("cmd < ESP_CMD_END", cmd < ESP_CMD_END); /* Assert input parameters */
+    ESP_ASSERT("stats != NULL", stats != NULL); /* Assert input parameters */
+    
+    ESP_CORE_PROTECT();
+    s = &cmd_stats[cmd];
+    stats->count = s->count;
+    stats->errors = s->errors;
+    stats->timeouts = s->timeouts;
+    stats->queue_avg = s->count ? s->queue_sum / s->count : 0;
+    stats->first_avg = s->resp ? s->first_sum / s->resp : 0;
+    stats->exec_avg = s->count ? s->exec_sum / s->count : 0;
+    stats->exec_max = s->exec_max;
+    memcpy(stats->hist, s->hist, sizeof(stats->hist));
+    ESP_CORE_UNPROTECT();
+    return espOK;
+}
+
+/**
+ * \brief           Clear statistics and trace of all commands
+ */
+void
+esp_cmd_stats_reset(void) {
+    ESP_CORE_PROTECT();
+    memset(cmd_stats, 0x00, sizeof(cmd_stats));
+#if ESP_CFG_CMD_STATS_TRACE_LEN
+    cmd_trace_w = 0;
+    cmd_trace_cnt = 0;
+#endif /* ESP_CFG_CMD_STATS_TRACE_LEN */
+    ESP_CORE_UNPROTECT();
+}
+
+/**
+ * \brief           Get last finished commands
+ * \param[out]      trace: Array to write entries to, newest command first
+ * \param[in]       len: Number of entries in array
+ * \return          Number of entries written
+ */
+size_t
+esp_cmd_stats_trace(esp_cmd_trace_t* trace, size_t len) {
+    size_t cnt = 0;
+#if ESP_CFG_CMD_STATS_TRACE_LEN
+    size_t i = 0;
+    
+    ESP_CORE_PROTECT();
+    for (; trace != NULL && cnt < len && cnt < cmd_trace_cnt; cnt++) {
+        i = (cmd_trace_w + ESP_CFG_CMD_STATS_TRACE_LEN - 1 - cnt) % ESP_CFG_CMD_STATS_TRACE_LEN;
+        trace[cnt] = cmd_trace[i];
+    }
+    ESP_CORE_UNPROTECT();
+#else /* ESP_CFG_CMD_STATS_TRACE_LEN */
+    ESP_UNUSED(trace);
+    ESP_UNUSED(len);
+#endif /* !ESP_CFG_CMD_STATS_TRACE_LEN */
+    return cnt;
+}
+
+/**
+ * \brief           Append formatted text to dump buffer
+ * \param[in]       buff: Output buffer
+ * \param[in]       len: Length of output buffer
+ * \param[in,out]   w: Number of characters already written, updated by function
+ * \param[in]       fmt: Format string
+ */
+static void
+dump_add(char* buff, size_t len, size_t* w, const char* fmt, ...) {
+    va_list args;
+    int n;
+    
+    if (*w + 1 >= len) {                        /* Buffer is full already */
+        return;
+    }
+    va_start(args, fmt);
+    n = vsnprintf(&buff[*w], len - *w, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        *w = ESP_MIN(*w + (size_t)n, len - 1);  /* Output is truncated when it does not fit */
+    }
+}
+
+/**
+ * \brief           Write statistics of all executed commands as text
+ *
+ *                  Each executed command is written in separate line with number of commands,
+ *                  errors and timeouts, average queue time, time to first response byte,
+ *                  average and maximal execution time in milliseconds
+ *                  and histogram buckets up to the last non-empty one
+ *
+ * \param[out]      buff: Buffer to write text to
+ * \param[in]       len: Length of buffer in units of bytes, including `NULL` termination
+ * \return          Length of text written to buffer
+ */
+size_t
+esp_cmd_stats_dump(char* buff, size_t len) {
+    size_t cmd, b, last, w = 0;
+    cmd_stats_t* s;
+    
+    if (buff == NULL || len == 0) {
+        return 0;
+    }
+    buff[0] = 0;
+    ESP_CORE_PROTECT();
+    for (cmd = 0; cmd < ESP_CMD_END; cmd++) {
+        s = &cmd_stats[cmd];
+        if (!s->count) {
+            continue;
+        }
+        dump_add(buff, len, &w, "%s:", espi_dbg_msg_to_string((esp_cmd_t)cmd));
+        dump_add(buff, len, &w, " n=%u err=%u tmo=%u q=%u f=%u e=%u/%u h=",
+            (unsigned)s->count, (unsigned)s->errors, (unsigned)s->timeouts,
+            (unsigned)(s->queue_sum / s->count), (unsigned)(s->resp ? s->first_sum / s->resp : 0),
+            (unsigned)(s->exec_sum / s->count), (unsigned)s->exec_max);
+        for (last = ESP_CFG_CMD_STATS_BUCKETS - 1; last > 0 && !s->hist[last]; last--) {}
+        for (b = 0; b <= last; b++) {
+            dump_add(buff, len, &w, b ? ",%u" : "%u", (unsigned)s->hist[b]);
+        }
+        dump_add(buff, len, &w, "\r\n");
+    }
+    ESP_CORE_UNPROTECT();
+    return w;
+}
+
+#endif /* ESP_CFG_CMD_STATS || __DOXYGEN__ */
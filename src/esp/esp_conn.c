@@ -51,22 +51,31 @@ conn_get_val_id(esp_conn_p conn) {
     return val_id;
 }
 
+static esp_timeout_t conn_poll_timeout;
+
 /**
  * \brief           Timeout callback for connection
  * \param[in]       arg: Timeout callback custom argument
  */
 static void
 conn_timeout_cb(void* arg) {
-    uint16_t i;
+    size_t i;
+    uint8_t active = 0;
 
     esp.cb.type = ESP_CB_CONN_POLL;             /* Set polling callback type */
-    for (i = 0; i < ESP_CFG_MAX_CONNS; i++) {   /* Scan all connections */
-        if (esp.conns[i].status.f.active) {     /* If connection is active */
-            esp.cb.cb.conn_poll.conn = &esp.conns[i];   /* Set connection pointer */
-            espi_send_conn_cb(&esp.conns[i], NULL); /* Send connection callback */
+    ESP_CONN_MAP_FOR_EACH(&esp.conns_open, i) { /* Scan active connections only */
+        esp.cb.cb.conn_poll.conn = &esp.conns[i];   /* Set connection pointer */
+        espi_send_conn_cb(&esp.conns[i], NULL); /* Send connection callback */
+#if ESP_CFG_CONN_RECV_PASSIVE
+        if (esp.conns[i].recv_retry) {
+            espi_conn_recv_pull(&esp.conns[i]); /* Previous read could not be queued */
         }
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
+        active = 1;
+    }
+    if (!active) {                              /* Do not wake up when there is nothing to poll */
+        esp_timeout_stop(&conn_poll_timeout);
     }
-    esp_timeout_add(ESP_CFG_CONN_POLL_INTERVAL, conn_timeout_cb, NULL);/* Schedule timeout again */
 }
 
 /**
@@ -79,20 +88,36 @@ conn_timeout_cb(void* arg) {
  * \param[in]       btw: Number of bytes to send
  * \param[out]      bw: Pointer to output variable to save number of sent data when successfully sent
  * \param[in]       fau: "Free After Use" flag. Set to 1 if stack should free the memory after data sent
+ * \param[in]       pbuf: Packet buffer chain to send instead of `data`. Set to `NULL` when not used
  * \param[in]       blocking: Status whether command should be blocking or not
+ * \param[in]       evt_fn: Completion function of non-blocking command. Set to `NULL` when not used
+ * \param[in]       evt_arg: Custom user argument for completion function
  * \return          espOK on success, member of \ref espr_t enumeration otherwise
  */
 static espr_t
-conn_send(esp_conn_p conn, const void* ip, uint16_t port, const void* data, size_t btw, size_t* bw, uint8_t fau, uint32_t blocking) {
+conn_send(esp_conn_p conn, const void* ip, uint16_t port, const void* data, size_t btw, size_t* bw, uint8_t fau, esp_pbuf_p pbuf, uint32_t blocking,
+            esp_cmd_evt_fn evt_fn, void* evt_arg) {
+    espr_t res;
+#if ESP_CFG_TRANSPARENT
+    uint8_t active;
+#endif /* ESP_CFG_TRANSPARENT */
     ESP_MSG_VAR_DEFINE(msg);                    /* Define variable for message */
     
     ESP_ASSERT("conn != NULL", conn != NULL);   /* Assert input parameters */
-    ESP_ASSERT("data != NULL", data != NULL);   /* Assert input parameters */
+    ESP_ASSERT("data != NULL", data != NULL || pbuf != NULL);   /* Assert input parameters */
     ESP_ASSERT("btw > 0", btw > 0);             /* Assert input parameters */
     
     if (bw != NULL) {
         *bw = 0;
     }
+#if ESP_CFG_TRANSPARENT
+    ESP_CORE_PROTECT();
+    active = esp.trans.active;
+    ESP_CORE_UNPROTECT();
+    if (active) {
+        return espERR;                          /* Data would be rejected by producer */
+    }
+#endif /* ESP_CFG_TRANSPARENT */
     
     ESP_MSG_VAR_ALLOC(msg);                     /* Allocate memory for variable */
     ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_TCPIP_CIPSEND;
@@ -105,8 +130,24 @@ conn_send(esp_conn_p conn, const void* ip, uint16_t port, const void* data, size
     ESP_MSG_VAR_REF(msg).msg.conn_send.remote_port = port;
     ESP_MSG_VAR_REF(msg).msg.conn_send.fau = fau;
     ESP_MSG_VAR_REF(msg).msg.conn_send.val_id = conn_get_val_id(conn);
+    if (pbuf != NULL) {
+        esp_pbuf_ref(pbuf);                     /* Keep packet buffer until data are sent */
+        ESP_MSG_VAR_REF(msg).msg.conn_send.pbuf = pbuf;
+    }
+#if ESP_CFG_CMD_EVT
+    ESP_MSG_VAR_REF(msg).evt_fn = evt_fn;
+    ESP_MSG_VAR_REF(msg).evt_arg = evt_arg;
+    ESP_MSG_VAR_REF(msg).evt_set = fau || evt_fn != NULL;  /* Stack buffers are sent on behalf of earlier writes */
+#else /* ESP_CFG_CMD_EVT */
+    ESP_UNUSED(evt_fn);
+    ESP_UNUSED(evt_arg);
+#endif /* !ESP_CFG_CMD_EVT */
     
-    return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, blocking, 60000);   /* Send message to producer queue */
+    res = espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, blocking, 60000);    /* Send message to producer queue */
+    if (res != espOK && !blocking && pbuf != NULL) {
+        esp_pbuf_free(pbuf);                    /* Message was not queued, release reference */
+    }
+    return res;
 }
 
 /**
@@ -120,7 +161,7 @@ flush_buff(esp_conn_p conn) {
          * If there is nothing to write or if write was not successful,
          * simply free the memory and stop execution
          */
-        if (conn->buff_ptr == 0 || conn_send(conn, NULL, 0, conn->buff, conn->buff_ptr, NULL, 1, 0) != espOK) {
+        if (conn->buff_ptr == 0 || conn_send(conn, NULL, 0, conn->buff, conn->buff_ptr, NULL, 1, NULL, 0, NULL, NULL) != espOK) {
             esp_mem_free(conn->buff);           /* Free memory manually */
         }
         conn->buff = NULL;
@@ -133,9 +174,133 @@ flush_buff(esp_conn_p conn) {
  */
 void
 espi_conn_init(void) {
-    esp_timeout_add(ESP_CFG_CONN_POLL_INTERVAL, conn_timeout_cb, NULL); /* Add connection timeout */
+    size_t i;
+    
+    for (i = 0; i < ESP_CFG_MAX_CONNS; i++) {   /* Connection number is index in array */
+        esp.conns[i].num = i;
+    }
+    espi_conn_poll_start();
 }
 
+/**
+ * \brief           Set or clear active flag of connection
+ * \note            Flag must be changed only with this function to keep \ref esp_t.conns_open in sync
+ * \param[in]       conn: Connection handle
+ * \param[in]       active: Set to `1` when connection is active, `0` otherwise
+ */
+void
+espi_conn_set_active(esp_conn_t* conn, uint8_t active) {
+    conn->status.f.active = !!active;
+    if (conn->status.f.active) {
+        ESP_CONN_MAP_SET(&esp.conns_open, conn->num);
+    } else {
+        ESP_CONN_MAP_CLR(&esp.conns_open, conn->num);
+    }
+}
+
+/**
+ * \brief           Find first connection number set in bitmap, starting at specific number
+ * \param[in]       map: Bitmap of connections
+ * \param[in]       from: First connection number to check
+ * \return          Connection number or `ESP_CFG_MAX_CONNS` if no bit is set from this position on
+ */
+size_t
+espi_conn_map_next(const esp_conn_map_t* map, size_t from) {
+    static const uint8_t debruijn_pos[32] = {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+    size_t i;
+    uint32_t w;
+
+    if (from >= ESP_CFG_MAX_CONNS) {
+        return ESP_CFG_MAX_CONNS;
+    }
+    i = from >> 5;
+    w = map->w[i] & (0xFFFFFFFFUL << (from & 0x1F));    /* Ignore bits below start position */
+    while (w == 0) {
+        if (++i >= ESP_CONN_MAP_WORDS) {
+            return ESP_CFG_MAX_CONNS;
+        }
+        w = map->w[i];
+    }
+    /* Isolate lowest set bit and get its position with de Bruijn multiplication */
+    i = (i << 5) + debruijn_pos[(uint32_t)((w & (0UL - w)) * 0x077CB531UL) >> 27];
+    return i < ESP_CFG_MAX_CONNS ? i : ESP_CFG_MAX_CONNS;
+}
+
+/**
+ * \brief           Start periodic poll of active connections if not running already
+ * \note            Poll stops by itself when there is no active connection
+ */
+void
+espi_conn_poll_start(void) {
+    if (!esp_timeout_is_active(&conn_poll_timeout)) {
+        esp_timeout_start(&conn_poll_timeout, ESP_CFG_CONN_POLL_INTERVAL,
+            ESP_CFG_CONN_POLL_INTERVAL, conn_timeout_cb, NULL); /* Start periodic connection timeout */
+    }
+}
+
+#if ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__
+
+/**
+ * \brief           Queue read of data held by device when receive window of connection allows it
+ * \note            Function must be called with core protected
+ * \param[in]       conn: Connection to read data for
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+espi_conn_recv_pull(esp_conn_t* conn) {
+    espr_t res;
+    ESP_MSG_VAR_DEFINE(msg);                    /* Define variable for message */
+
+    conn->recv_retry = 0;
+    if (!conn->status.f.active || conn->recv_queued || !conn->recv_avail
+        || conn->recv_unacked >= ESP_CFG_CONN_RECV_WINDOW) {
+        return espOK;                           /* Nothing to read or application is too slow */
+    }
+#if ESP_CFG_PBUF_POOL
+    if (!espi_pbuf_pool_free()) {               /* Data would go to heap or be lost */
+        esp.recv_pool_wait = 1;                 /* Read when buffer is returned to pool */
+        return espOK;
+    }
+#endif /* ESP_CFG_PBUF_POOL */
+
+    conn->recv_retry = 1;                       /* Device will not notify again, poll retries until read is queued */
+    ESP_MSG_VAR_ALLOC(msg);                     /* Allocate memory for variable */
+    ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_TCPIP_CIPRECVDATA;
+    ESP_MSG_VAR_REF(msg).msg.conn_recv.conn = conn;
+    ESP_MSG_VAR_REF(msg).msg.conn_recv.val_id = conn->val_id;
+#if ESP_CFG_CMD_EVT
+    ESP_MSG_VAR_REF(msg).evt_set = 1;           /* Read is not started by application */
+#endif /* ESP_CFG_CMD_EVT */
+
+    conn->recv_queued = 1;                      /* Only one read per connection at a time */
+    res = espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, 0, 1000);    /* Send message to producer queue */
+    if (res == espOK) {
+        conn->recv_retry = 0;
+    } else {
+        conn->recv_queued = 0;                  /* Try again on next poll, notification or confirmation */
+    }
+    return res;
+}
+
+/**
+ * \brief           Queue read of data for all active connections
+ * \note            Used when reads were postponed for all connections at once, such as on empty receive pool.
+ *                  Function must be called with core protected
+ */
+void
+espi_conn_recv_pull_all(void) {
+    size_t i;
+
+    ESP_CONN_MAP_FOR_EACH(&esp.conns_open, i) {
+        espi_conn_recv_pull(&esp.conns[i]);
+    }
+}
+
+#endif /* ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__ */
+
 /**
  * \brief           Starts a new connection of specific type
  * \param[out]      conn: Pointer to connection handle to set new connection reference in case of successful connection
@@ -200,7 +365,7 @@ esp_conn_close(esp_conn_p conn, uint32_t blocking) {
 espr_t
 esp_conn_sendto(esp_conn_p conn, const void* ip, uint16_t port, const void* data, size_t btw, size_t* bw, uint32_t blocking) {
     flush_buff(conn);                           /* Flush currently written memory if exists */
-    return conn_send(conn, ip, port, data, btw, bw, 0, blocking);
+    return conn_send(conn, ip, port, data, btw, bw, 0, NULL, blocking, NULL, NULL);
 }
 
 /**
@@ -215,18 +380,61 @@ esp_conn_sendto(esp_conn_p conn, const void* ip, uint16_t port, const void* data
 espr_t
 esp_conn_send(esp_conn_p conn, const void* data, size_t btw, size_t* bw, uint32_t blocking) {
     flush_buff(conn);                           /* Flush currently written memory if exists */
-    return conn_send(conn, NULL, 0, data, btw, bw, 0, blocking);
+    return conn_send(conn, NULL, 0, data, btw, bw, 0, NULL, blocking, NULL, NULL);
+}
+
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+
+/**
+ * \brief           Send data on active connection in non-blocking way and get notified when it finishes
+ *
+ *                  Completion function is attached directly to send command,
+ *                  data written with \ref esp_conn_write before are flushed without it
+ *
+ * \param[in]       conn: Connection handle to send data
+ * \param[in]       data: Data to send, must be valid until completion function is called
+ * \param[in]       btw: Number of bytes to send
+ * \param[out]      bw: Pointer to output variable to save number of sent data when successfully sent
+ * \param[in]       evt_fn: Completion function called with final result of command.
+ *                      Set to `NULL` to use function set with \ref esp_set_cmd_evt_fn
+ * \param[in]       evt_arg: Custom user argument passed to completion function
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_conn_send_ex(esp_conn_p conn, const void* data, size_t btw, size_t* bw, esp_cmd_evt_fn evt_fn, void* evt_arg) {
+    flush_buff(conn);                           /* Flush currently written memory if exists */
+    return conn_send(conn, NULL, 0, data, btw, bw, 0, NULL, 0, evt_fn, evt_arg);
+}
+
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
+
+/**
+ * \brief           Send packet buffer chain on already active connection either as client or server
+ * \note            Segments of chain are sent one after another without copying them to linear memory.
+ *                  Stack holds its own reference until data are sent, application may free packet buffer after function returns
+ * \param[in]       conn: Connection handle to send data
+ * \param[in]       pbuf: Packet buffer chain to send
+ * \param[out]      bw: Pointer to output variable to save number of sent data when successfully sent
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_conn_send_pbuf(esp_conn_p conn, esp_pbuf_p pbuf, size_t* bw, uint32_t blocking) {
+    ESP_ASSERT("pbuf != NULL", pbuf != NULL);   /* Assert input parameters */
+    
+    flush_buff(conn);                           /* Flush currently written memory if exists */
+    return conn_send(conn, NULL, 0, NULL, esp_pbuf_length(pbuf, 1), bw, 0, pbuf, blocking, NULL, NULL);
 }
 
 /**
  * \brief           Notify connection about received data which means connection is ready to accept more data
  * 
  *                  Once data reception is confirmed, stack will try to send more data to user.
- * 
- * \note            Since this feature is not supported yet by AT commands, function is only prototype
- *                  and should be used in connection callback when data are received
+ *                  With \ref ESP_CFG_CONN_RECV_PASSIVE enabled, packet buffer length is released
+ *                  from receive window of connection and more data are read from device.
+ *                  Otherwise function has no effect.
  *
- * \note            Function is not thread safe and may only be called from callback function
+ * \note            Function may be called from any thread, but before packet buffer is freed
  *
  * \param[in]       conn: Connection hande
  * \param[in]       pbuf: Packet buffer received on connection
@@ -234,8 +442,21 @@ esp_conn_send(esp_conn_p conn, const void* data, size_t btw, size_t* bw, uint32_
  */
 espr_t
 esp_conn_recved(esp_conn_p conn, esp_pbuf_p pbuf) {
+#if ESP_CFG_CONN_RECV_PASSIVE
+    size_t len;
+
+    ESP_ASSERT("conn != NULL", conn != NULL);   /* Assert input parameters */
+    ESP_ASSERT("pbuf != NULL", pbuf != NULL);   /* Assert input parameters */
+
+    len = esp_pbuf_length(pbuf, 1);             /* Get length of entire chain */
+    ESP_CORE_PROTECT();
+    conn->recv_unacked -= ESP_MIN(len, conn->recv_unacked);
+    espi_conn_recv_pull(conn);                  /* Read more data if available */
+    ESP_CORE_UNPROTECT();
+#else /* ESP_CFG_CONN_RECV_PASSIVE */
     ESP_UNUSED(conn);
     ESP_UNUSED(pbuf);
+#endif /* !ESP_CFG_CONN_RECV_PASSIVE */
     return espOK;
 }
 
@@ -363,6 +584,40 @@ esp_conn_getnum(esp_conn_p conn) {
     return res;
 }
 
+#if ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__
+
+/**
+ * \brief           Get send scheduler statistics of connection
+ * \note            Use it to check fairness between connections under load.
+ *                  Statistics are reset when new connection is established
+ * \param[in]       conn: Connection handle
+ * \param[out]      stats: Pointer to output structure
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_conn_get_send_stats(esp_conn_p conn, esp_conn_send_stats_t* stats) {
+    esp_msg_t* msg;
+    
+    ESP_ASSERT("conn != NULL", conn != NULL);   /* Assert input parameters */
+    ESP_ASSERT("stats != NULL", stats != NULL); /* Assert input parameters */
+    
+    memset(stats, 0x00, sizeof(*stats));
+    ESP_CORE_PROTECT();
+    for (msg = esp.send_q[conn->num]; msg != NULL; msg = msg->next) {
+        stats->queued++;
+        if (msg->cmd_def == ESP_CMD_TCPIP_CIPSEND) {
+            stats->queued_bytes += msg->msg.conn_send.btw;
+        }
+    }
+    stats->chunks = conn->send_chunks;
+    stats->wait_avg = conn->send_chunks ? conn->send_wait_total / conn->send_chunks : 0;
+    stats->wait_max = conn->send_wait_max;
+    ESP_CORE_UNPROTECT();
+    return espOK;
+}
+
+#endif /* ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__ */
+
 /**
  * \brief           Set internal buffer size for SSL connection on ESP device
  * \note            Use this function first before you initialize first SSL connection
@@ -452,7 +707,7 @@ esp_conn_write(esp_conn_p conn, const void* data, size_t btw, uint8_t flush, siz
          */
         if (conn->buff_ptr == conn->buff_len || flush) {
             /* Try to send to processing queue in non-blocking way */
-            if (conn_send(conn, NULL, 0, conn->buff, conn->buff_ptr, NULL, 1, 0) != espOK) {
+            if (conn_send(conn, NULL, 0, conn->buff, conn->buff_ptr, NULL, 1, NULL, 0, NULL, NULL) != espOK) {
                 esp_mem_free(conn->buff);       /* Manually free memory */
             }
             conn->buff = NULL;                  /* Reset pointer */
@@ -467,7 +722,7 @@ esp_conn_write(esp_conn_p conn, const void* data, size_t btw, uint8_t flush, siz
         buff = esp_mem_alloc(ESP_CFG_CONN_MAX_DATA_LEN);    /* Allocate memory */
         if (buff != NULL) {
             memcpy(buff, d, ESP_CFG_CONN_MAX_DATA_LEN); /* Copy data to buffer */
-            if (conn_send(conn, NULL, 0, buff, ESP_CFG_CONN_MAX_DATA_LEN, NULL, 1, 0) != espOK) {
+            if (conn_send(conn, NULL, 0, buff, ESP_CFG_CONN_MAX_DATA_LEN, NULL, 1, NULL, 0, NULL, NULL) != espOK) {
                 esp_mem_free(buff);             /* Manually free memory */
                 return espERRMEM;
             }
@@ -35,16 +35,105 @@
 #include "esp/esp_debug.h"
 #include "esp/esp.h"
 
-#if ESP_CFG_DBG || __DOXYGEN__
-    
+#if ESP_CFG_DBG || ESP_CFG_CMD_STATS || __DOXYGEN__
+
+#define CMD_NAME(c)     case ESP_CMD_ ## c: return #c
+
+/**
+ * \brief           Get name of command for debug output and statistics
+ * \param[in]       cmd: Command to get name for
+ * \return          Name of command without `ESP_CMD_` prefix
+ */
 const char *
 espi_dbg_msg_to_string(esp_cmd_t cmd) {
-    static char tmp_arr[100];
-    if (cmd) {
-        sprintf(tmp_arr, "%d", (int)cmd);
-        return tmp_arr;
+    switch (cmd) {
+        CMD_NAME(IDLE);
+        CMD_NAME(RESET);
+        CMD_NAME(ATE0);
+        CMD_NAME(ATE1);
+        CMD_NAME(GMR);
+        CMD_NAME(GSLP);
+        CMD_NAME(RESTORE);
+        CMD_NAME(UART);
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__
+        CMD_NAME(AT);
+        CMD_NAME(UART_CHECK);
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__ */
+        CMD_NAME(SLEEP);
+        CMD_NAME(WAKEUPGPIO);
+        CMD_NAME(RFPOWER);
+        CMD_NAME(RFVDD);
+        CMD_NAME(RFAUTOTRACE);
+        CMD_NAME(SYSRAM);
+        CMD_NAME(SYSADC);
+        CMD_NAME(SYSIOSETCFG);
+        CMD_NAME(SYSIOGETCFG);
+        CMD_NAME(SYSGPIODIR);
+        CMD_NAME(SYSGPIOWRITE);
+        CMD_NAME(SYSGPIOREAD);
+        CMD_NAME(SYSMSG);
+        CMD_NAME(WIFI_CWMODE);
+#if ESP_CFG_MODE_STATION || __DOXYGEN__
+        CMD_NAME(WIFI_CWJAP);
+        CMD_NAME(WIFI_CWQAP);
+        CMD_NAME(WIFI_CWLAP);
+        CMD_NAME(WIFI_CIPSTAMAC_GET);
+        CMD_NAME(WIFI_CIPSTAMAC_SET);
+        CMD_NAME(WIFI_CIPSTA_GET);
+        CMD_NAME(WIFI_CIPSTA_SET);
+#endif /* ESP_CFG_MODE_STATION || __DOXYGEN__ */
+#if ESP_CFG_MODE_ACCESS_POINT || __DOXYGEN__
+        CMD_NAME(WIFI_CWSAP_GET);
+        CMD_NAME(WIFI_CWSAP_SET);
+        CMD_NAME(WIFI_CIPAPMAC_GET);
+        CMD_NAME(WIFI_CIPAPMAC_SET);
+        CMD_NAME(WIFI_CIPAP_GET);
+        CMD_NAME(WIFI_CIPAP_SET);
+        CMD_NAME(WIFI_CWLIF);
+#endif /* ESP_CFG_MODE_ACCESS_POINT || __DOXYGEN__ */
+        CMD_NAME(WIFI_WPS);
+        CMD_NAME(WIFI_MDNS);
+#if ESP_CFG_HOSTNAME || __DOXYGEN__
+        CMD_NAME(WIFI_CWHOSTNAME_SET);
+        CMD_NAME(WIFI_CWHOSTNAME_GET);
+#endif /* ESP_CFG_HOSTNAME || __DOXYGEN__ */
+        CMD_NAME(TCPIP_CIPSTATUS);
+#if ESP_CFG_DNS || __DOXYGEN__
+        CMD_NAME(TCPIP_CIPDOMAIN);
+#endif /* ESP_CFG_DNS || __DOXYGEN__ */
+        CMD_NAME(TCPIP_CIPSTART);
+        CMD_NAME(TCPIP_CIPSSLSIZE);
+        CMD_NAME(TCPIP_CIPSEND);
+        CMD_NAME(TCPIP_CIPCLOSE);
+        CMD_NAME(TCPIP_CIFSR);
+        CMD_NAME(TCPIP_CIPMUX);
+        CMD_NAME(TCPIP_CIPSERVER);
+        CMD_NAME(TCPIP_CIPSERVERMAXCONN);
+        CMD_NAME(TCPIP_CIPMODE);
+#if ESP_CFG_TRANSPARENT || __DOXYGEN__
+        CMD_NAME(TCPIP_CIPSTART_SINGLE);
+        CMD_NAME(TCPIP_CIPSEND_TRANSPARENT);
+        CMD_NAME(TCPIP_CIPCLOSE_SINGLE);
+#endif /* ESP_CFG_TRANSPARENT || __DOXYGEN__ */
+        CMD_NAME(TCPIP_CIPSTO);
+#if ESP_CFG_PING || __DOXYGEN__
+        CMD_NAME(TCPIP_PING);
+#endif /* ESP_CFG_PING || __DOXYGEN__ */
+        CMD_NAME(TCPIP_CIUPDATE);
+#if ESP_CFG_SNTP || __DOXYGEN__
+        CMD_NAME(TCPIP_CIPSNTPCFG);
+        CMD_NAME(TCPIP_CIPSNTPTIME);
+#endif /* ESP_CFG_SNTP || __DOXYGEN__ */
+        CMD_NAME(TCPIP_CIPDNS);
+        CMD_NAME(TCPIP_CIPDINFO);
+#if ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__
+        CMD_NAME(TCPIP_CIPRECVMODE);
+        CMD_NAME(TCPIP_CIPRECVDATA);
+#endif /* ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__ */
+        default: return "UNKNOWN";
     }
-    return "";
 }
-    
-#endif /* ESP_CFG_DBG || __DOXYGEN__ */
+
+#undef CMD_NAME
+
+#endif /* ESP_CFG_DBG || ESP_CFG_CMD_STATS || __DOXYGEN__ */
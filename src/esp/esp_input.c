@@ -60,6 +60,47 @@ esp_input(const void* data, size_t len) {
     return espOK;
 }
 
+/**
+ * \brief           Get linear memory in input buffer where received data can be written directly
+ *
+ *                  Use it with DMA or read function to avoid intermediate copy of received data.
+ *                  When data are written, call \ref esp_input_commit to pass them to processing thread
+ *
+ * \note            \ref ESP_CFG_INPUT_USE_PROCESS must be disabled to use this function
+ * \param[out]      len: Pointer to output variable to save number of bytes available for write
+ * \return          Pointer to memory for write or `NULL` if input buffer is full
+ */
+void*
+esp_input_reserve(size_t* len) {
+    if (len == NULL) {
+        return NULL;
+    }
+    *len = 0;
+    if (!esp.buff.buff) {
+        return NULL;
+    }
+    *len = esp_buff_get_linear_block_write_length(&esp.buff);
+    return *len ? esp_buff_get_linear_block_write_address(&esp.buff) : NULL;
+}
+
+/**
+ * \brief           Notify stack about data written to memory from \ref esp_input_reserve
+ * \note            \ref ESP_CFG_INPUT_USE_PROCESS must be disabled to use this function
+ * \param[in]       len: Number of bytes written, up to length returned by \ref esp_input_reserve
+ * \return          Member of \ref espr_t enumeration
+ */
+espr_t
+esp_input_commit(size_t len) {
+    if (!esp.buff.buff) {
+        return espERR;
+    }
+    esp_buff_advance(&esp.buff, len);           /* Make data available to processing thread */
+    esp_sys_mbox_putnow(&esp.mbox_process, NULL);   /* Write empty box */
+    esp_recv_total_len += len;                  /* Update total number of received bytes */
+    esp_recv_calls++;                           /* Update number of calls */
+    return espOK;
+}
+
 #endif /* !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
 
 #if ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
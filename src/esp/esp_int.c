@@ -46,16 +46,65 @@ typedef struct {
     uint8_t len;
 } esp_recv_t;
 static esp_recv_t recv;
+
+typedef enum {
+    RCV_UNKNOWN = 0x00,                         /* Line is processed by current command only */
+    RCV_OK,                                     /* "OK" */
+    RCV_ERROR,                                  /* "ERROR" or "FAIL" */
+    RCV_READY,                                  /* "ready" after reset */
+    RCV_IPD,                                    /* "+IPD" network data */
+    RCV_LINK_CONN,                              /* "+LINK_CONN:" connection status */
+    RCV_PLUS,                                   /* Other statement starting with '+' */
+    RCV_WIFI,                                   /* "WIFI ..." station status */
+    RCV_SEND_OK,                                /* "SEND OK" */
+    RCV_SEND_FAIL,                              /* "SEND FAIL" */
+    RCV_RECV,                                   /* "Recv x bytes" */
+    RCV_CONN_SEND_OK,                           /* "x,y,SEND OK" for buffered send */
+    RCV_CONN_SEND_FAIL,                         /* "x,y,SEND FAIL" for buffered send */
+    RCV_CONN_CLOSED,                            /* "x,CLOSED" */
+    RCV_CONN_FAIL,                              /* "x,CONNECT FAIL" */
+} esp_rcv_type_t;
 #endif /* !__DOXYGEN__ */
 
 #define RECV_ADD(ch)        do { recv.data[recv.len++] = ch; recv.data[recv.len] = 0; } while (0)
 #define RECV_RESET()        recv.data[(recv.len = 0)] = 0;
 #define RECV_LEN()          recv.len
 #define RECV_IDX(index)     recv.data[index]
+#define RECV_ADD_RUN(p, l)  do { size_t n = ESP_MIN((size_t)(l), sizeof(recv.data) - 1 - recv.len); \
+                                memcpy(&recv.data[recv.len], (p), n); recv.len += n; recv.data[recv.len] = 0; } while (0)
+
+#define RCV_IS(r, str)      ((r)->len == sizeof(str) - 1 && !memcmp((r)->data, (str), sizeof(str) - 1))
+#define RCV_STARTS(r, str)  ((r)->len >= sizeof(str) - 1 && !memcmp((r)->data, (str), sizeof(str) - 1))
+#define RCV_ENDS(r, str)    ((r)->len >= sizeof(str) - 1 && !memcmp(&(r)->data[(r)->len - (sizeof(str) - 1)], (str), sizeof(str) - 1))
+
+#define ESP_AT_PORT_SEND_STR(str)       at_port_send((const uint8_t *)(str), strlen(str))
+#define ESP_AT_PORT_SEND_CHR(str)       at_port_send((const uint8_t *)(str), 1)
+#define ESP_AT_PORT_SEND(d, l)          at_port_send((const uint8_t *)(d), l)
+#if ESP_CFG_AT_PORT_TX_BUFF_SIZE
+#define ESP_AT_PORT_FLUSH()             at_port_flush()
+#else /* ESP_CFG_AT_PORT_TX_BUFF_SIZE */
+#define ESP_AT_PORT_FLUSH()
+#endif /* !ESP_CFG_AT_PORT_TX_BUFF_SIZE */
+
+#if ESP_CFG_CONN_SENDBUF
+/* In buffered mode, chunk is done once device accepts it to send buffer */
+#define SEND_DONE_TYPE()                (esp.msg->msg.conn_send.buffered ? RCV_RECV : RCV_SEND_OK)
+#else /* ESP_CFG_CONN_SENDBUF */
+#define SEND_DONE_TYPE()                RCV_SEND_OK
+#endif /* !ESP_CFG_CONN_SENDBUF */
 
-#define ESP_AT_PORT_SEND_STR(str)       esp.ll.send_fn((const uint8_t *)(str), strlen(str))
-#define ESP_AT_PORT_SEND_CHR(str)       esp.ll.send_fn((const uint8_t *)(str), 1)
-#define ESP_AT_PORT_SEND(d, l)          esp.ll.send_fn((const uint8_t *)(d), l)
+#if ESP_CFG_CONN_SEND_SCHED
+#define CONN_SEND_YIELDED(m)            ((m)->msg.conn_send.yield)
+#else /* ESP_CFG_CONN_SEND_SCHED */
+#define CONN_SEND_YIELDED(m)            0
+#endif /* !ESP_CFG_CONN_SEND_SCHED */
+
+#if ESP_CFG_IPD_ZERO_COPY
+/* Data are already in place when packet buffer references input buffer */
+#define IPD_BUFF_NEEDS_COPY()           (esp.ipd.buff != NULL && !esp.ipd.buff->rx_hold)
+#else /* ESP_CFG_IPD_ZERO_COPY */
+#define IPD_BUFF_NEEDS_COPY()           (esp.ipd.buff != NULL)
+#endif /* !ESP_CFG_IPD_ZERO_COPY */
 
 static espr_t espi_process_sub_cmd(esp_msg_t* msg, uint8_t is_ok, uint8_t is_error, uint8_t is_ready);
 
@@ -66,37 +115,115 @@ static espr_t espi_process_sub_cmd(esp_msg_t* msg, uint8_t is_ok, uint8_t is_err
 #define CONN_SEND_DATA_FREE(m)    do {      \
     if ((m)->msg.conn_send.fau) {           \
         esp_mem_free((void *)(m)->msg.conn_send.data);    \
+        (m)->msg.conn_send.fau = 0;         \
+    }                                       \
+    if ((m)->msg.conn_send.pbuf != NULL) {  \
+        esp_pbuf_free((m)->msg.conn_send.pbuf);   \
+        (m)->msg.conn_send.pbuf = NULL;     \
     }                                       \
 } while (0)
 
+/**
+ * \brief           Call low-level send function and count number of calls for current message
+ * \param[in]       data: Pointer to data to send
+ * \param[in]       len: Number of bytes to send
+ */
+static void
+at_port_ll_send(const uint8_t* data, size_t len) {
+    esp.ll.send_fn(data, (uint16_t)len);        /* Send data to AT port */
+    if (esp.msg != NULL) {
+        esp.msg->send_calls++;                  /* Count transfers for current command */
+    }
+}
+
+#if ESP_CFG_AT_PORT_TX_BUFF_SIZE || __DOXYGEN__
+
+/**
+ * \brief           Send all data from TX staging buffer to AT port with single call
+ */
+static void
+at_port_flush(void) {
+    if (esp.tx_len) {
+        at_port_ll_send(esp.tx_buff, esp.tx_len);
+        esp.tx_len = 0;
+    }
+}
+
+/**
+ * \brief           Write data to TX staging buffer
+ * \note            Data which do not fit to empty buffer are sent directly
+ * \param[in]       data: Pointer to data to send
+ * \param[in]       len: Number of bytes to send
+ */
+static void
+at_port_send(const uint8_t* data, size_t len) {
+    if (len > sizeof(esp.tx_buff) - esp.tx_len) {   /* Not enough memory for new data? */
+        at_port_flush();
+    }
+    if (len >= sizeof(esp.tx_buff)) {           /* Data too big for buffer, send them directly */
+        at_port_ll_send(data, len);
+    } else {
+        memcpy(&esp.tx_buff[esp.tx_len], data, len);
+        esp.tx_len += len;
+    }
+}
+
+#else /* ESP_CFG_AT_PORT_TX_BUFF_SIZE || __DOXYGEN__ */
+#define at_port_send(d, l)              at_port_ll_send(d, l)
+#endif /* !(ESP_CFG_AT_PORT_TX_BUFF_SIZE || __DOXYGEN__) */
+
 /**
  * \brief           Create 2-characters long hex from byte
  * \param[in]       num: Number to convert to string
  * \param[out]      str: Pointer to string to save result to
+ * \return          Number of characters written, without `NULL` termination
  */
-static void
+static size_t
 byte_to_str(uint8_t num, char* str) {
-    sprintf(str, "%02X", (unsigned)num);        /* Currently use sprintf only */
+    static const char hex[] = "0123456789ABCDEF";
+
+    str[0] = hex[(num >> 4) & 0x0F];
+    str[1] = hex[num & 0x0F];
+    str[2] = 0;
+    return 2;
 }
 
 /**
  * \brief           Create string from number
  * \param[in]       num: Number to convert to string
  * \param[out]      str: Pointer to string to save result to
+ * \return          Number of characters written, without `NULL` termination
  */
-static void
+static size_t
 number_to_str(uint32_t num, char* str) {
-    sprintf(str, "%u", (unsigned)num);          /* Currently use sprintf only */
+    char tmp[10];
+    size_t i = 0, len;
+
+    do {                                        /* Create digits in reverse order */
+        tmp[i++] = (char)('0' + num % 10);
+        num /= 10;
+    } while (num);
+    len = i;
+    while (i) {                                 /* Copy them to output in correct order */
+        *str++ = tmp[--i];
+    }
+    *str = 0;
+    return len;
 }
 
 /**
  * \brief           Create string from signed number
  * \param[in]       num: Number to convert to string
  * \param[out]      str: Pointer to string to save result to
+ * \return          Number of characters written, without `NULL` termination
  */
-static void
+static size_t
 signed_number_to_str(int32_t num, char* str) {
-    sprintf(str, "%d", (signed)num);            /* Currently use sprintf only */
+    if (num < 0) {
+        *str = '-';
+        return 1 + number_to_str((uint32_t)0 - (uint32_t)num, str + 1);
+    }
+    return number_to_str((uint32_t)num, str);
 }
 
 /**
@@ -107,30 +234,31 @@ signed_number_to_str(int32_t num, char* str) {
  */
 static void
 send_ip_mac(const uint8_t* d, uint8_t is_ip, uint8_t q) {
-    uint8_t i, ch;
-    char str[4];
+    uint8_t i, cnt;
+    char str[20];
+    size_t len = 0;
     
     if (d == NULL) {
         return;
     }
     if (q) {
-        ESP_AT_PORT_SEND_STR("\"");             /* Send starting quote character */
+        str[len++] = '"';                       /* Add starting quote character */
     }
-    ch = is_ip ? '.' : ':';                     /* Get delimiter character */
-    for (i = 0; i < (is_ip ? 4 : 6); i++) {     /* Process byte by byte */
+    cnt = is_ip ? 4 : 6;
+    for (i = 0; i < cnt; i++) {                 /* Process byte by byte */
         if (is_ip) {                            /* In case of IP ... */
-            number_to_str(d[i], str);           /* ... go to decimal format ... */
+            len += number_to_str(d[i], &str[len]);  /* ... go to decimal format ... */
         } else {                                /* ... in case of MAC ... */
-            byte_to_str(d[i], str);             /* ... go to HEX format */
+            len += byte_to_str(d[i], &str[len]);    /* ... go to HEX format */
         }
-        ESP_AT_PORT_SEND_STR(str);              /* Send str */
-        if (i < (is_ip ? 4 : 6) - 1) {          /* Check end if characters */
-            ESP_AT_PORT_SEND_CHR(&ch);          /* Send character */
+        if (i < cnt - 1) {                      /* Check end if characters */
+            str[len++] = is_ip ? '.' : ':';     /* Add delimiter character */
         }
     }
     if (q) {
-        ESP_AT_PORT_SEND_STR("\"");             /* Send ending quote character */
+        str[len++] = '"';                       /* Add ending quote character */
     }
+    ESP_AT_PORT_SEND(str, len);                 /* Send address at once */
 }
 
 /**
@@ -141,18 +269,25 @@ send_ip_mac(const uint8_t* d, uint8_t is_ip, uint8_t q) {
  */
 static void
 send_string(const char* str, uint8_t e, uint8_t q) {
-    char special = '\\';
+    char special[2] = { '\\' };
+    size_t len;
+
     if (q) {
         ESP_AT_PORT_SEND_STR("\"");
     }
     if (str != NULL) {
         if (e) {                                /* Do we have to escape string? */
             while (*str) {                      /* Go through string */
-                if (*str == ',' || *str == '"' || *str == '\\') {   /* Check for special character */    
-                    ESP_AT_PORT_SEND_CHR(&special); /* Send special character */
+                /* Send characters up to next special character at once */
+                for (len = 0; str[len] && str[len] != ',' && str[len] != '"' && str[len] != '\\'; len++) {}
+                if (len) {
+                    ESP_AT_PORT_SEND(str, len);
+                    str += len;
+                }
+                if (*str) {                     /* Escape special character */
+                    special[1] = *str++;
+                    ESP_AT_PORT_SEND(special, 2);
                 }
-                ESP_AT_PORT_SEND_CHR(str);      /* Send character */
-                str++;
             }
         } else {
             ESP_AT_PORT_SEND_STR(str);          /* Send plain string */
@@ -170,16 +305,17 @@ send_string(const char* str, uint8_t e, uint8_t q) {
  */
 static void
 send_number(uint32_t num, uint8_t q) {
-    char str[11];
+    char str[13];
+    size_t len = 0;
     
-    number_to_str(num, str);                    /* Convert digit to decimal string */
     if (q) {
-        ESP_AT_PORT_SEND_STR("\"");
+        str[len++] = '"';
     }
-    ESP_AT_PORT_SEND_STR(str);                  /* Send string with number */
+    len += number_to_str(num, &str[len]);       /* Convert digit to decimal string */
     if (q) {
-        ESP_AT_PORT_SEND_STR("\"");
+        str[len++] = '"';
     }
+    ESP_AT_PORT_SEND(str, len);                 /* Send string with number */
 }
 
 /**
@@ -189,18 +325,72 @@ send_number(uint32_t num, uint8_t q) {
  */
 static void
 send_signed_number(int32_t num, uint8_t q) {
-    char str[11];
+    char str[14];
+    size_t len = 0;
     
-    signed_number_to_str(num, str);             /* Convert digit to decimal string */
     if (q) {
-        ESP_AT_PORT_SEND_STR("\"");
+        str[len++] = '"';
     }
-    ESP_AT_PORT_SEND_STR(str);                  /* Send string with number */
+    len += signed_number_to_str(num, &str[len]);    /* Convert digit to decimal string */
     if (q) {
-        ESP_AT_PORT_SEND_STR("\"");
+        str[len++] = '"';
+    }
+    ESP_AT_PORT_SEND(str, len);                 /* Send string with number */
+}
+
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__
+
+/* Command line carrying payload to verify AT port, device echoes it and replies with error */
+#define UART_CHECK_PREFIX               "AT+UARTCHK="
+
+/**
+ * \brief           Update Fletcher-16 checksum with data
+ * \param[in]       chk: Current checksum, use `0` for first block
+ * \param[in]       data: Data to add to checksum
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Updated checksum
+ */
+static uint16_t
+uart_check_sum(uint16_t chk, const void* data, size_t len) {
+    const uint8_t* d = data;
+    uint16_t s1 = chk & 0xFF, s2 = chk >> 8;
+    
+    for (; len; len--, d++) {
+        s1 = (s1 + *d) % 255;
+        s2 = (s2 + s1) % 255;
     }
+    return (uint16_t)((s2 << 8) | s1);
 }
 
+/**
+ * \brief           Send command line with pseudo random payload to verify AT port
+ * \param[in]       msg: Message with \ref ESP_CMD_UART_CHECK command
+ */
+static void
+send_uart_check(esp_msg_t* msg) {
+    static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    uint32_t r = esp_sys_now() ^ ((uint32_t)msg->msg.uart_check.round * 0x9E3779B9UL);
+    char str[32];
+    size_t i, n, len;
+    uint16_t chk = 0;
+    
+    ESP_AT_PORT_SEND_STR(UART_CHECK_PREFIX);
+    for (len = ESP_CFG_AT_BAUDRATE_CHECK_LEN; len; len -= n) {
+        n = ESP_MIN(len, sizeof(str));
+        for (i = 0; i < n; i++) {
+            r = r * 1103515245UL + 12345UL;     /* Different payload on every round trip */
+            str[i] = chars[(r >> 16) & 0x3F];
+        }
+        chk = uart_check_sum(chk, str, n);
+        ESP_AT_PORT_SEND(str, n);
+    }
+    ESP_AT_PORT_SEND_STR("\r\n");
+    msg->msg.uart_check.chk = chk;
+    msg->msg.uart_check.echo_ok = 0;
+}
+
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__ */
+
 /**
  * \brief           Reset all connections
  * \note            Used to notify upper layer stack to close everything and reset the memory if necessary
@@ -213,14 +403,12 @@ reset_connections(uint8_t forced) {
     esp.cb.type = ESP_CB_CONN_CLOSED;
     esp.cb.cb.conn_active_closed.forced = forced;
     
-    for (i = 0; i < ESP_CFG_MAX_CONNS; i++) {   /* Check all connections */
-        if (esp.conns[i].status.f.active) {
-            esp.conns[i].status.f.active = 0;
-            
-            esp.cb.cb.conn_active_closed.conn = &esp.conns[i];
-            esp.cb.cb.conn_active_closed.client = esp.conns[i].status.f.client;
-            espi_send_conn_cb(&esp.conns[i], NULL); /* Send callback function */
-        }
+    ESP_CONN_MAP_FOR_EACH(&esp.conns_open, i) { /* Check active connections only */
+        espi_conn_set_active(&esp.conns[i], 0);
+        
+        esp.cb.cb.conn_active_closed.conn = &esp.conns[i];
+        esp.cb.cb.conn_active_closed.client = esp.conns[i].status.f.client;
+        espi_send_conn_cb(&esp.conns[i], NULL); /* Send callback function */
     }
 }
 
@@ -273,6 +461,16 @@ espi_send_conn_cb(esp_conn_t* conn, esp_cb_fn cb) {
     }
 }
 
+/**
+ * \brief           Free data of send message which finished without `SEND OK` or `SEND FAIL`
+ * \note            Function must be called with core protected
+ * \param[in]       msg: Send message, data are released only once
+ */
+void
+espi_conn_send_data_free(esp_msg_t* msg) {
+    CONN_SEND_DATA_FREE(msg);
+}
+
 /**
  * \brief           Process and send data from device buffer
  * \return          Member of \ref espr_t enumeration
@@ -285,7 +483,26 @@ espi_tcpip_process_send_data(void) {
         CONN_SEND_DATA_FREE(esp.msg);           /* Free message data */
         return espERR;
     }
+#if ESP_CFG_CONN_SEND_SCHED
+    esp.msg->msg.conn_send.yield = 0;           /* Start of new chunk */
+#endif /* ESP_CFG_CONN_SEND_SCHED */
+#if ESP_CFG_CONN_SENDBUF
+    /*
+     * TCP data are written to device send buffer,
+     * as long as there are not too many segments waiting for SEND OK
+     */
+    esp.msg->msg.conn_send.buffered = esp.msg->msg.conn_send.conn->type == ESP_CONN_TYPE_TCP;
+    if (esp.msg->msg.conn_send.buffered) {
+        esp_conn_t* c = esp.msg->msg.conn_send.conn;
+        if ((uint16_t)(c->seg_id - c->seg_id_ok) >= ESP_CFG_CONN_SENDBUF_SEGMENTS) {
+            esp.msg->msg.conn_send.wait_seg = 1;/* Continue when oldest segment is finished */
+            return espOK;
+        }
+    }
+    ESP_AT_PORT_SEND_STR(esp.msg->msg.conn_send.buffered ? "AT+CIPSENDBUF=" : "AT+CIPSEND=");
+#else /* ESP_CFG_CONN_SENDBUF */
     ESP_AT_PORT_SEND_STR("AT+CIPSEND=");
+#endif /* !ESP_CFG_CONN_SENDBUF */
     send_number(esp.msg->msg.conn_send.conn->num, 0);
     ESP_AT_PORT_SEND_STR(",");
     esp.msg->msg.conn_send.sent = esp.msg->msg.conn_send.btw > ESP_CFG_CONN_MAX_DATA_LEN ? ESP_CFG_CONN_MAX_DATA_LEN : esp.msg->msg.conn_send.btw;
@@ -303,9 +520,34 @@ espi_tcpip_process_send_data(void) {
         }
     }
     ESP_AT_PORT_SEND_STR("\r\n");
+    ESP_AT_PORT_FLUSH();                        /* Function is also called to send next chunk from processing thread */
     return espOK;
 }
 
+/**
+ * \brief           Send current chunk of data after device replied with `> `
+ *
+ * Packet buffer chain is written segment by segment within single `AT+CIPSEND` length,
+ * without copying it to linear memory first
+ */
+static void
+espi_tcpip_send_chunk(void) {
+    if (esp.msg->msg.conn_send.pbuf != NULL) {
+        const uint8_t* d;
+        size_t off = esp.msg->msg.conn_send.ptr, rem = esp.msg->msg.conn_send.sent, len;
+        
+        while (rem && (d = esp_pbuf_get_linear_addr(esp.msg->msg.conn_send.pbuf, off, &len)) != NULL && len) {
+            len = ESP_MIN(len, rem);
+            ESP_AT_PORT_SEND(d, len);           /* Send segment memory directly */
+            off += len;
+            rem -= len;
+        }
+    } else {
+        ESP_AT_PORT_SEND(&esp.msg->msg.conn_send.data[esp.msg->msg.conn_send.ptr], esp.msg->msg.conn_send.sent);
+    }
+    ESP_AT_PORT_FLUSH();
+}
+
 /**
  * \brief           Process data sent and send remaining
  * \param[in]       sent: Status whether data were sent or not, info received from ESP with "SEND OK" or "SEND FAIL" 
@@ -328,6 +570,12 @@ espi_tcpip_process_data_sent(uint8_t sent) {
         }
     }
     if (esp.msg->msg.conn_send.btw) {           /* Do we still have data to send? */
+#if ESP_CFG_CONN_SEND_SCHED
+        if (sent) {                             /* Give other connections a chance, scheduler will continue later */
+            esp.msg->msg.conn_send.yield = 1;
+            return 1;
+        }
+#endif /* ESP_CFG_CONN_SEND_SCHED */
         if (espi_tcpip_process_send_data() != espOK) {  /* Check if we can continue */
             return 1;                           /* Finish at this point */
         }
@@ -336,6 +584,47 @@ espi_tcpip_process_data_sent(uint8_t sent) {
     return 1;                                   /* Everything was sent, we can stop execution */
 }
 
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+
+/**
+ * \brief           Process `x,y,SEND OK` or `x,y,SEND FAIL` for segment written with `AT+CIPSENDBUF`
+ * \param[in]       str: Received string starting with connection number
+ * \param[in]       ok: Set to `1` when segment was sent successfully
+ * \return          `1` if current send command must be stopped with error, `0` otherwise
+ */
+static uint8_t
+espi_tcpip_process_seg_sent(const char* str, uint8_t ok) {
+    esp_conn_t* conn;
+    uint32_t num;
+    
+    num = espi_parse_number(&str);              /* Parse connection number */
+    if (num >= ESP_CFG_MAX_CONNS) {
+        return 0;
+    }
+    conn = &esp.conns[num];
+    conn->seg_id_ok = (uint16_t)espi_parse_number(&str);    /* Oldest segment has been finished */
+    if (!ok && conn->status.f.active) {         /* Data in device buffer were lost */
+        esp.cb.type = ESP_CB_CONN_DATA_SEND_ERR;
+        esp.cb.cb.conn_data_send_err.conn = conn;
+        esp.cb.cb.conn_data_send_err.sent = 0;
+        espi_send_conn_cb(conn, NULL);          /* Send connection callback */
+    }
+    
+    /*
+     * Continue with data waiting for free segment
+     */
+    if (IS_CURR_CMD(ESP_CMD_TCPIP_CIPSEND) && esp.msg->msg.conn_send.conn == conn
+        && esp.msg->msg.conn_send.wait_seg) {
+        esp.msg->msg.conn_send.wait_seg = 0;
+        if (espi_tcpip_process_send_data() != espOK) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
+
 /**
  * \brief           Send error event to application layer
  * \param[in]       msg: Message from user with connection start
@@ -351,6 +640,79 @@ espi_send_conn_error_cb(esp_msg_t* msg) {
     espi_send_conn_cb(conn, esp.msg->msg.conn_start.cb_func);   /* Send event */
 }
 
+/**
+ * \brief           Classify received line with single look at first character and length
+ *
+ *                  Connection statements like "x,CLOSED" carry number in front
+ *                  and are recognized by their fixed ending instead
+ *
+ * \param[in]       rcv: Received line
+ * \return          Type of received line
+ */
+static esp_rcv_type_t
+espi_classify_received(const esp_recv_t* rcv) {
+    switch (rcv->data[0]) {
+        case 'O':
+            if (RCV_IS(rcv, "OK\r\n")) {
+                return RCV_OK;
+            }
+            break;
+        case 'E':
+            if (RCV_IS(rcv, "ERROR\r\n")) {
+                return RCV_ERROR;
+            }
+            break;
+        case 'F':
+            if (RCV_IS(rcv, "FAIL\r\n")) {
+                return RCV_ERROR;
+            }
+            break;
+        case 'r':
+            if (RCV_IS(rcv, "ready\r\n")) {
+                return RCV_READY;
+            }
+            break;
+        case '+':
+            if (RCV_STARTS(rcv, "+IPD")) {
+                return RCV_IPD;
+            } else if (rcv->len > 20 && RCV_STARTS(rcv, "+LINK_CONN:")) {
+                return RCV_LINK_CONN;
+            }
+            return RCV_PLUS;
+        case 'W':
+            if (RCV_STARTS(rcv, "WIFI ")) {
+                return RCV_WIFI;
+            }
+            break;
+        case 'S':
+            if (RCV_STARTS(rcv, "SEND OK")) {
+                return RCV_SEND_OK;
+            } else if (RCV_STARTS(rcv, "SEND FAIL")) {
+                return RCV_SEND_FAIL;
+            }
+            break;
+        case 'R':
+            if (RCV_STARTS(rcv, "Recv ")) {
+                return RCV_RECV;
+            }
+            break;
+        default:
+            break;
+    }
+    if (RCV_ENDS(rcv, ",CLOSED\r\n")) {
+        return RCV_CONN_CLOSED;
+    } else if (RCV_ENDS(rcv, ",CONNECT FAIL\r\n")) {
+        return RCV_CONN_FAIL;
+    } else if (ESP_CHARISNUM(rcv->data[0])) {
+        if (RCV_ENDS(rcv, ",SEND OK\r\n")) {
+            return RCV_CONN_SEND_OK;
+        } else if (RCV_ENDS(rcv, ",SEND FAIL\r\n")) {
+            return RCV_CONN_SEND_FAIL;
+        }
+    }
+    return RCV_UNKNOWN;
+}
+
 /**
  * \brief           Process received string from ESP 
  * \param[in]       recv: Pointer to \ref esp_rect_t structure with input string
@@ -358,7 +720,19 @@ espi_send_conn_error_cb(esp_msg_t* msg) {
 static void
 espi_parse_received(esp_recv_t* rcv) {
     uint8_t is_ok = 0, is_error = 0, is_ready = 0;
-    const char* s;
+    esp_rcv_type_t type;
+    
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE
+    /* Echo of verification payload must have the same length and checksum */
+    if (IS_CURR_CMD(ESP_CMD_UART_CHECK) && !strncmp(rcv->data, UART_CHECK_PREFIX, sizeof(UART_CHECK_PREFIX) - 1)) {
+        const char* d = &rcv->data[sizeof(UART_CHECK_PREFIX) - 1];
+        size_t len = strcspn(d, "\r\n");
+        
+        esp.msg->msg.uart_check.echo_ok = len == ESP_CFG_AT_BAUDRATE_CHECK_LEN
+            && uart_check_sum(0, d, len) == esp.msg->msg.uart_check.chk;
+        return;
+    }
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE */
     
     /* Try to remove non-parsable strings */
     if ((rcv->len == 2 && rcv->data[0] == '\r' && rcv->data[1] == '\n') ||
@@ -367,13 +741,10 @@ espi_parse_received(esp_recv_t* rcv) {
     }
     
     /* Detect most common responses from device */
-    is_ok = !strcmp(rcv->data, "OK\r\n");       /* Check if received string is OK */
-    if (!is_ok) {
-        is_error = !strcmp(rcv->data, "ERROR\r\n") || !strcmp(rcv->data, "FAIL\r\n");   /* Check if received string is error */
-        if (!is_error) {
-            is_ready = !strcmp(rcv->data, "ready\r\n"); /* Check if received string is ready */
-        }
-    }
+    type = espi_classify_received(rcv);
+    is_ok = type == RCV_OK;
+    is_error = type == RCV_ERROR;
+    is_ready = type == RCV_READY;
     
     /*
      * In case ready is received, there was a reset on device,
@@ -391,8 +762,8 @@ espi_parse_received(esp_recv_t* rcv) {
     /*
      * Read and process statements starting with '+' character
      */
-    if (rcv->data[0] == '+') {
-        if (!strncmp("+IPD", rcv->data, 4)) {   /* Check received network data */
+    if (type == RCV_IPD || type == RCV_LINK_CONN || type == RCV_PLUS) {
+        if (type == RCV_IPD) {                  /* Check received network data */
             espi_parse_ipd(rcv->data + 5);      /* Parse IPD statement and start receiving network data */
         } else if (esp.msg) {
             if (
@@ -487,6 +858,10 @@ espi_parse_received(esp_recv_t* rcv) {
                         memcpy(b, ip, 4);       /* Copy to user variable */
                     }
                 }
+#if ESP_CFG_CONN_RECV_PASSIVE
+            } else if (IS_CURR_CMD(ESP_CMD_TCPIP_CIPRECVDATA) && !strncmp(rcv->data, "+CIPRECVDATA", 12)) {
+                espi_parse_ciprecvdata(&rcv->data[13], esp.msg);    /* Parse length and start reading data */
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
 #if ESP_CFG_MODE_STATION
             } else if (IS_CURR_CMD(ESP_CMD_WIFI_CWLAP) && !strncmp(rcv->data, "+CWLAP", 6)) {
                 espi_parse_cwlap(rcv->data, esp.msg);   /* Parse CWLAP entry */
@@ -513,7 +888,11 @@ espi_parse_received(esp_recv_t* rcv) {
 #endif /* ESP_CFG_HOSTNAME */
             }
         }
-    } else if (!strncmp(rcv->data, "WIFI", 4)) {
+#if ESP_CFG_CONN_SENDBUF
+    } else if (type == RCV_CONN_SEND_OK || type == RCV_CONN_SEND_FAIL) {
+        is_error = espi_tcpip_process_seg_sent(rcv->data, type == RCV_CONN_SEND_OK);
+#endif /* ESP_CFG_CONN_SENDBUF */
+    } else if (type == RCV_WIFI) {
         if (!strncmp(&rcv->data[5], "CONNECTED", 9)) {
             esp.status.f.r_w_conn = 1;          /* Wifi is connected */
             espi_send_cb(ESP_CB_WIFI_CONNECTED);/* Call user callback function */
@@ -543,9 +922,17 @@ espi_parse_received(esp_recv_t* rcv) {
             if (!strncmp(rcv->data, "+CIPSTATUS", 10)) {
                 espi_parse_cipstatus(rcv->data + 11);   /* Parse CIPSTATUS response */
             } else if (is_ok) {
-                uint8_t i;
-                for (i = 0; i < ESP_CFG_MAX_CONNS; i++) {   /* Set current connection statuses */
-                    esp.conns[i].status.f.active = !!(esp.active_conns & (1 << i));
+                size_t i;
+                ESP_CONN_MAP_FOR_EACH(&esp.conns_open, i) { /* Clear connections not reported anymore */
+                    if (!ESP_CONN_MAP_IS_SET(&esp.active_conns, i)) {
+                        espi_conn_set_active(&esp.conns[i], 0);
+                    }
+                }
+                ESP_CONN_MAP_FOR_EACH(&esp.active_conns, i) {   /* Set reported connections active */
+                    espi_conn_set_active(&esp.conns[i], 1);
+                }
+                if (espi_conn_map_next(&esp.conns_open, 0) < ESP_CFG_MAX_CONNS) {
+                    espi_conn_poll_start();     /* Poll connections found active */
                 }
             }
         } else if (IS_CURR_CMD(ESP_CMD_TCPIP_CIPSEND)) {
@@ -553,34 +940,75 @@ espi_parse_received(esp_recv_t* rcv) {
                 is_ok = 0;                      /* Do not reach on OK */
             }
             if (esp.msg->msg.conn_send.wait_send_ok_err) {
-                if (!strncmp("SEND OK", rcv->data, 7)) {    /* Data were sent successfully */
+                if (type == SEND_DONE_TYPE()) { /* Data were sent successfully */
                     esp.msg->msg.conn_send.wait_send_ok_err = 0;
                     is_ok = espi_tcpip_process_data_sent(1);    /* Process as data were sent */
-                    if (is_ok && esp.msg->msg.conn_send.conn->status.f.active) {
+                    if (is_ok && !CONN_SEND_YIELDED(esp.msg)) {
                         CONN_SEND_DATA_FREE(esp.msg);   /* Free message data */
-                        esp.cb.type = ESP_CB_CONN_DATA_SENT;    /* Data were fully sent */
-                        esp.cb.cb.conn_data_sent.conn = esp.msg->msg.conn_send.conn;
-                        esp.cb.cb.conn_data_sent.sent = esp.msg->msg.conn_send.sent_all;
-                        espi_send_conn_cb(esp.msg->msg.conn_send.conn, NULL);   /* Send connection callback */
+                        if (esp.msg->msg.conn_send.conn->status.f.active) {
+                            esp.cb.type = ESP_CB_CONN_DATA_SENT;    /* Data were fully sent */
+                            esp.cb.cb.conn_data_sent.conn = esp.msg->msg.conn_send.conn;
+                            esp.cb.cb.conn_data_sent.sent = esp.msg->msg.conn_send.sent_all;
+                            espi_send_conn_cb(esp.msg->msg.conn_send.conn, NULL);   /* Send connection callback */
+                        }
                     }
-                } else if (is_error || !strncmp("SEND FAIL", rcv->data, 9)) {
+                } else if (is_error || type == RCV_SEND_FAIL) {
                     esp.msg->msg.conn_send.wait_send_ok_err = 0;
                     is_error = espi_tcpip_process_data_sent(0); /* Data were not sent due to SEND FAIL or command didn't even start */
-                    if (is_error && esp.msg->msg.conn_send.conn->status.f.active) {
+                    if (is_error) {
                         CONN_SEND_DATA_FREE(esp.msg);   /* Free message data */
-                        esp.cb.type = ESP_CB_CONN_DATA_SEND_ERR;/* Error sending data */
-                        esp.cb.cb.conn_data_send_err.conn = esp.msg->msg.conn_send.conn;
-                        esp.cb.cb.conn_data_send_err.sent = esp.msg->msg.conn_send.sent_all;
-                        espi_send_conn_cb(esp.ipd.conn, NULL);  /* Send connection callback */
+                        if (esp.msg->msg.conn_send.conn->status.f.active) {
+                            esp.cb.type = ESP_CB_CONN_DATA_SEND_ERR;/* Error sending data */
+                            esp.cb.cb.conn_data_send_err.conn = esp.msg->msg.conn_send.conn;
+                            esp.cb.cb.conn_data_send_err.sent = esp.msg->msg.conn_send.sent_all;
+                            espi_send_conn_cb(esp.ipd.conn, NULL);  /* Send connection callback */
+                        }
                     }
                 }
+#if ESP_CFG_CONN_SENDBUF
+            } else if (esp.msg->msg.conn_send.buffered && ESP_CHARISNUM(rcv->data[0])) {
+                const char* tmp = rcv->data;    /* Response is "<segment ID>,<segment ID sent successfully>" */
+                uint16_t seg_id, seg_id_ok;
+                
+                seg_id = (uint16_t)espi_parse_number(&tmp);
+                seg_id_ok = (uint16_t)espi_parse_number(&tmp);
+                if (*tmp == '\r') {            /* Ignore "x,y,SEND OK" and "x,CLOSED" */
+                    esp.msg->msg.conn_send.conn->seg_id = seg_id;
+                    esp.msg->msg.conn_send.conn->seg_id_ok = seg_id_ok;
+                }
+#endif /* ESP_CFG_CONN_SENDBUF */
             } else if (is_error) {
                 CONN_SEND_DATA_FREE(esp.msg);   /* Free message data */
             }
+#if ESP_CFG_TRANSPARENT
+        } else if (IS_CURR_CMD(ESP_CMD_TCPIP_CIPSEND_TRANSPARENT)) {
+            is_ok = 0;                          /* Command finishes with "> ", not with OK */
+#endif /* ESP_CFG_TRANSPARENT */
         } else if (IS_CURR_CMD(ESP_CMD_UART)) { /* In case of UART command */
             if (is_ok) {                        /* We have valid OK result */
                 esp_ll_init(&esp.ll, esp.msg->msg.uart.baudrate);   /* Set new baudrate */
+                esp.baudrate = esp.msg->msg.uart.baudrate;
+            }
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE
+        } else if (IS_CURR_CMD(ESP_CMD_UART_CHECK)) {
+            if (is_ok || is_error) {            /* Device does not know the command, only echo matters */
+                is_ok = esp.msg->msg.uart_check.echo_ok;
+                is_error = !is_ok;
+            }
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE */
+#if ESP_CFG_CONN_RECV_PASSIVE
+        } else if (IS_CURR_CMD(ESP_CMD_TCPIP_CIPRECVDATA)) {
+            esp_conn_t* c = esp.msg->msg.conn_recv.conn;
+            if ((is_ok || is_error) && esp.msg->msg.conn_recv.val_id == c->val_id) {
+                if (is_error || esp.msg->msg.conn_recv.read < esp.msg->msg.conn_recv.len) {
+                    c->recv_avail = 0;          /* Device has no more data for connection */
+                } else {
+                    c->recv_avail -= ESP_MIN(c->recv_avail, esp.msg->msg.conn_recv.read);
+                }
+                c->recv_queued = 0;
+                espi_conn_recv_pull(c);         /* Continue reading if window allows */
             }
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
 #if ESP_CFG_MODE_ACCESS_POINT
         } else if (IS_CURR_CMD(ESP_CMD_WIFI_CWLIF) && ESP_CHARISNUM(rcv->data[0])) {
             espi_parse_cwlif(rcv->data, esp.msg);   /* Parse CWLIF entry */
@@ -596,12 +1024,12 @@ espi_parse_received(esp_recv_t* rcv) {
      *
      * Check LINK_CONN and x,CONNECT messages
      */
-    if (rcv->len > 20 && (s = strstr(rcv->data, "+LINK_CONN:")) != NULL) {
-        if (espi_parse_link_conn(s) && esp.link_conn.num < ESP_CFG_MAX_CONNS) {
+    if (type == RCV_LINK_CONN) {
+        if (espi_parse_link_conn(rcv->data) && esp.link_conn.num < ESP_CFG_MAX_CONNS) {
             uint8_t id;
             esp_conn_t* conn = &esp.conns[esp.link_conn.num];   /* Get connection pointer */
             if (esp.link_conn.failed && conn->status.f.active) {/* Connection failed and now closed? */
-                conn->status.f.active = 0;      /* Connection was just closed */
+                espi_conn_set_active(conn, 0);  /* Connection was just closed */
                 
                 esp.cb.type = ESP_CB_CONN_CLOSED;   /* Connection just active */
                 esp.cb.cb.conn_active_closed.conn = conn;   /* Set connection */
@@ -619,8 +1047,9 @@ espi_parse_received(esp_recv_t* rcv) {
                 id = conn->val_id;
                 memset(conn, 0x00, sizeof(*conn));  /* Reset connection parameters */
                 conn->num = esp.link_conn.num;  /* Set connection number */
-                conn->status.f.active = !esp.link_conn.failed;  /* Check if connection active */
+                espi_conn_set_active(conn, !esp.link_conn.failed);  /* Check if connection active */
                 conn->val_id = ++id;            /* Set new validation ID */
+                espi_conn_poll_start();         /* Start polling of active connections */
                 
                 conn->type = esp.link_conn.type;/* Set connection type */
                 memcpy(conn->remote_ip, esp.link_conn.remote_ip, sizeof(conn->remote_ip));
@@ -650,11 +1079,10 @@ espi_parse_received(esp_recv_t* rcv) {
     /*
     } else if (!strncmp(",CLOSED", &rcv->data[1], 7)) {
         const char* tmp = rcv->data; */
-    } else if ( (rcv->len > 9  && (s = strstr(rcv->data, ",CLOSED\r\n")) != NULL) || 
-                (rcv->len > 15 && (s = strstr(rcv->data, ",CONNECT FAIL\r\n")) != NULL)) {
-        const char* tmp = s;
+    } else if (type == RCV_CONN_CLOSED || type == RCV_CONN_FAIL) {
+        const char* tmp = &rcv->data[rcv->len - (type == RCV_CONN_CLOSED ? 9 : 15)];   /* Position of comma before status */
         uint32_t num = 0;
-        while (tmp >= rcv->data && ESP_CHARISNUM(tmp[-1])) {
+        while (tmp > rcv->data && ESP_CHARISNUM(tmp[-1])) {
             tmp--;
         }
         num = espi_parse_number(&tmp);          /* Parse connection number */
@@ -662,7 +1090,7 @@ espi_parse_received(esp_recv_t* rcv) {
             esp_conn_t* conn = &esp.conns[num]; /* Parse received data */
             conn->num = num;                    /* Set connection number */
             if (conn->status.f.active) {        /* Is connection actually active? */
-                conn->status.f.active = 0;      /* Connection was just closed */
+                espi_conn_set_active(conn, 0);  /* Connection was just closed */
                 
                 esp.cb.type = ESP_CB_CONN_CLOSED;   /* Connection just active */
                 esp.cb.cb.conn_active_closed.conn = conn;   /* Set connection */
@@ -679,6 +1107,12 @@ espi_parse_received(esp_recv_t* rcv) {
                     if (esp.msg->msg.conn_send.conn == conn) {
                         /** \todo: Find better idea to handle what to do in this case */
                         //is_error = 1;           /* Set as error to stop processing or waiting for connection */
+#if ESP_CFG_CONN_SENDBUF
+                        if (esp.msg->msg.conn_send.wait_seg) {  /* No more responses will come for this connection */
+                            CONN_SEND_DATA_FREE(esp.msg);
+                            is_error = 1;
+                        }
+#endif /* ESP_CFG_CONN_SENDBUF */
                     }
                 }
             }
@@ -732,7 +1166,83 @@ espi_parse_received(esp_recv_t* rcv) {
     }
 }
 
+#if ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+
+/**
+ * \brief           Release input buffer memory up to oldest region still referenced by packet buffer
+ * \note            Core must be protected by caller
+ */
+static void
+rx_release_processed(void) {
+    while (esp.rx_holds_cnt && !esp.rx_holds[esp.rx_holds_r].used) {/* Remove released regions from front */
+        esp.rx_holds_r = (esp.rx_holds_r + 1) % ESP_CFG_IPD_ZERO_COPY_HOLDS;
+        esp.rx_holds_cnt--;
+    }
+    ESP_BUFF_STORE(esp.buff.out, esp.rx_holds_cnt ? esp.rx_holds[esp.rx_holds_r].pos : esp.rx_ptr);
+}
+
+/**
+ * \brief           Release input buffer region referenced by packet buffer
+ * \note            Function is called by \ref esp_pbuf_free when last reference is removed
+ * \param[in]       hold: Hold number plus 1, as saved in packet buffer
+ */
+void
+espi_rx_release(uint8_t hold) {
+    ESP_CORE_PROTECT();
+    esp.rx_holds[hold - 1].used = 0;
+    rx_release_processed();
+    ESP_CORE_UNPROTECT();
+}
+
+#endif /* ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
+
+/**
+ * \brief           Create packet buffer for +IPD data
+ *
+ *                  When \ref ESP_CFG_IPD_ZERO_COPY is enabled and payload is linear in input buffer,
+ *                  packet buffer references input buffer memory directly and no copy is necessary
+ *
+ * \param[in]       d: Pointer to first byte of payload in memory, received or not yet received
+ * \param[in]       len: Length of payload for packet buffer
+ * \return          Packet buffer on success, `NULL` otherwise
+ */
+static esp_pbuf_p
+ipd_pbuf_new(const uint8_t* d, size_t len) {
+#if ESP_CFG_IPD_ZERO_COPY
+    size_t pos;
+    esp_pbuf_p p;
+    uint8_t hold;
+    
+    if (d >= esp.buff.buff && d <= &esp.buff.buff[esp.buff.size]) {
+        pos = (size_t)(d - esp.buff.buff);
+        if (pos == esp.buff.size) {             /* Payload starts after overflow */
+            pos = 0;
+        }
+        if (len < esp.buff.size && pos + len <= esp.buff.size
+            && esp.rx_holds_cnt < ESP_CFG_IPD_ZERO_COPY_HOLDS) {
+            p = espi_pbuf_new_ref(&esp.buff.buff[pos], len);
+            if (p != NULL) {
+                hold = (esp.rx_holds_r + esp.rx_holds_cnt) % ESP_CFG_IPD_ZERO_COPY_HOLDS;
+                esp.rx_holds[hold].pos = pos;   /* Keep memory from this position */
+                esp.rx_holds[hold].used = 1;
+                esp.rx_holds_cnt++;
+                p->rx_hold = hold + 1;
+                return p;
+            }
+        }
+    }
+#else /* ESP_CFG_IPD_ZERO_COPY */
+    ESP_UNUSED(d);
+#endif /* !ESP_CFG_IPD_ZERO_COPY */
+#if ESP_CFG_PBUF_POOL
+    return espi_pbuf_pool_new(len);             /* Take packet buffer from receive pool */
+#else /* ESP_CFG_PBUF_POOL */
+    return esp_pbuf_new(len);                   /* Allocate new packet buffer with memory */
+#endif /* !ESP_CFG_PBUF_POOL */
+}
+
 #if !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
+
 /**
  * \brief           Process data from input buffer
  * \return          espOK on success, member of \ref espr_t otherwise
@@ -741,8 +1251,28 @@ espr_t
 espi_process_buffer(void) {
     void* data;
     size_t len;
+#if ESP_CFG_IPD_ZERO_COPY
+    size_t in;
+#endif /* ESP_CFG_IPD_ZERO_COPY */
     
     do {
+#if ESP_CFG_IPD_ZERO_COPY
+        /*
+         * Process from last processed position
+         * as memory before may still be referenced by packet buffers
+         */
+        in = ESP_BUFF_LOAD(esp.buff.in);
+        len = in >= esp.rx_ptr ? (in - esp.rx_ptr) : (esp.buff.size - esp.rx_ptr);
+        if (len) {
+            data = &esp.buff.buff[esp.rx_ptr];
+            espi_process(data, len);
+            esp.rx_ptr += len;
+            if (esp.rx_ptr >= esp.buff.size) {
+                esp.rx_ptr = 0;
+            }
+            rx_release_processed();             /* Release memory not referenced anymore */
+        }
+#else /* ESP_CFG_IPD_ZERO_COPY */
         /*
          * Get length of linear memory in buffer
          * we can process directly as memory
@@ -766,11 +1296,46 @@ espi_process_buffer(void) {
              */
             esp_buff_skip(&esp.buff, len);
         }
+#endif /* !ESP_CFG_IPD_ZERO_COPY */
     } while (len);
     return espOK;
 }
 #endif /* !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
 
+/* Word-at-a-time helpers, each byte of word is checked in parallel */
+#define WORD_ONES                       ((size_t)-1 / 0xFF)
+#define WORD_HIGHS                      (WORD_ONES * 0x80)
+#define WORD_HAS_LESS(x, n)             (((x) - WORD_ONES * (n)) & ~(x) & WORD_HIGHS)
+#define WORD_HAS_BYTE(x, b)             WORD_HAS_LESS((x) ^ (WORD_ONES * (b)), 1)
+
+/* Character which has no meaning for command mode state machine and can be copied as is */
+#define IS_PLAIN_CHAR(c)                ((c) >= ' ' && (c) <= '~' && (c) != ':' && (c) != '>')
+
+/**
+ * \brief           Get number of plain characters at the beginning of block
+ * 
+ *                  Plain characters are printable ASCII characters except ':' and '>'.
+ *                  Block is scanned word by word until word with special character is found
+ *
+ * \param[in]       d: Data to scan
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of plain characters before first special character
+ */
+static size_t
+espi_scan_plain(const uint8_t* d, size_t len) {
+    size_t i = 0, w;
+    
+    for (; i + sizeof(w) <= len; i += sizeof(w)) {
+        memcpy(&w, &d[i], sizeof(w));           /* Memory may not be aligned */
+        if ((w & WORD_HIGHS) || WORD_HAS_LESS(w, ' ') || WORD_HAS_BYTE(w, 0x7F)
+            || WORD_HAS_BYTE(w, ':') || WORD_HAS_BYTE(w, '>')) {
+            break;                              /* Find exact position in this word below */
+        }
+    }
+    for (; i < len && IS_PLAIN_CHAR(d[i]); i++) {}
+    return i;
+}
+
 /**
  * \brief           Process input data received from ESP device
  * \param[in]       data: Pointer to data to process
@@ -787,7 +1352,21 @@ espi_process(const void* data, size_t data_len) {
     
     d = data;                                   /* Go to byte format */
     d_len = data_len;
+#if ESP_CFG_CMD_STATS
+    if (d_len > 0 && esp.msg != NULL && !esp.msg->t_resp) {
+        esp.msg->t_first = esp_sys_now();       /* First response byte for active command */
+        esp.msg->t_resp = 1;
+    }
+#endif /* ESP_CFG_CMD_STATS */
     while (d_len) {                             /* Read entire set of characters from buffer */
+#if ESP_CFG_TRANSPARENT
+        if (esp.trans.raw) {                    /* In transparent mode, all data belong to application */
+            if (esp.trans.recv_fn != NULL) {
+                esp.trans.recv_fn(d, d_len, esp.trans.arg);
+            }
+            break;
+        }
+#endif /* ESP_CFG_TRANSPARENT */
         ch = *d++;                              /* Get next character */
         d_len--;                                /* Decrease remaining length */
         
@@ -798,7 +1377,7 @@ espi_process(const void* data, size_t data_len) {
         if (esp.ipd.read) {                     /* Do we have to read incoming IPD data? */
             size_t len;
             
-            if (esp.ipd.buff != NULL) {         /* Do we have active buffer? */
+            if (IPD_BUFF_NEEDS_COPY()) {        /* Do we have active buffer? */
                 esp.ipd.buff->payload[esp.ipd.buff_ptr] = ch;   /* Save data character */
             }
             esp.ipd.buff_ptr++;
@@ -815,7 +1394,7 @@ espi_process(const void* data, size_t data_len) {
             }
             ESP_DEBUGF(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE, "IPD: New length: %d bytes\r\n", (int)len);
             if (len) {
-                if (esp.ipd.buff != NULL) {     /* Is buffer valid? */
+                if (IPD_BUFF_NEEDS_COPY()) {    /* Is buffer valid? */
                     /* 
                      * Copy data to connection payload buffer.
                      * Call if ok, even if new length is 0
@@ -849,6 +1428,9 @@ espi_process(const void* data, size_t data_len) {
                      * From this moment, user is responsible for packet
                      * buffer and must free it manually
                      */
+#if ESP_CFG_CONN_RECV_PASSIVE
+                    esp.ipd.conn->recv_unacked += esp.ipd.buff->tot_len;    /* Data now occupy receive window */
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
                     esp.cb.type = ESP_CB_CONN_DATA_RECV;/* We have received data */
                     esp.cb.cb.conn_data_recv.buff = esp.ipd.buff;
                     esp.cb.cb.conn_data_recv.conn = esp.ipd.conn;
@@ -863,7 +1445,7 @@ espi_process(const void* data, size_t data_len) {
                     if (esp.ipd.buff != NULL && esp.ipd.rem_len) {  /* Anything more to read? */
                         size_t new_len = ESP_MIN(esp.ipd.rem_len, ESP_CFG_IPD_MAX_BUFF_SIZE);   /* Calculate new buffer length */
                         ESP_DEBUGF(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE, "IPD: Allocating new packet buffer of size: %d bytes\r\n", (int)new_len);
-                        esp.ipd.buff = esp_pbuf_new(new_len);   /* Allocate new packet buffer */
+                        esp.ipd.buff = ipd_pbuf_new(d, new_len);/* Allocate new packet buffer */
                         ESP_DEBUGW(ESP_CFG_DBG_IPD | ESP_DBG_TYPE_TRACE | ESP_DBG_LVL_WARNING,
                             esp.ipd.buff == NULL, "IPD: Buffer allocation failed for %d bytes\r\n", (int)new_len);
                         
@@ -885,6 +1467,22 @@ espi_process(const void* data, size_t data_len) {
          */
         } else {
             espr_t res = espERR;
+            
+            /*
+             * Fast path: copy run of plain characters to receive buffer at once.
+             * Line endings, "+IPD" colon, "\n> " prompt and unicode go through state machine below
+             */
+            if (IS_PLAIN_CHAR(ch) && !unicode.r && ch_prev1 != '>') {
+                size_t len = 1 + espi_scan_plain(d, d_len); /* Current character is plain too */
+                
+                RECV_ADD_RUN(d - 1, len);
+                d += len - 1;
+                d_len -= len - 1;
+                ch_prev2 = len > 1 ? d[-2] : ch_prev1;
+                ch_prev1 = d[-1];
+                continue;
+            }
+            
             if (ESP_ISVALIDASCII(ch)) {         /* Manually check if valid ASCII character */
                 res = espOK;
                 unicode.t = 1;                  /* Manually set total to 1 */
@@ -919,16 +1517,36 @@ espi_process(const void* data, size_t data_len) {
                             /**
                              * Now actually send the data prepared before
                              */
-                            ESP_AT_PORT_SEND(&esp.msg->msg.conn_send.data[esp.msg->msg.conn_send.ptr], esp.msg->msg.conn_send.sent);
+                            espi_tcpip_send_chunk();
                             esp.msg->msg.conn_send.wait_send_ok_err = 1;    /* Now we are waiting for "SEND OK" or "SEND ERROR" */
                         }
                     }
+#if ESP_CFG_TRANSPARENT
+                    /*
+                     * After "\n> " in transparent mode, AT port carries raw data
+                     * and there is no other response to finish the command
+                     */
+                    if (IS_CURR_CMD(ESP_CMD_TCPIP_CIPSEND_TRANSPARENT)
+                        && ch_prev2 == '\n' && ch_prev1 == '>' && ch == ' ') {
+                        RECV_RESET();           /* Reset received object */
+                        esp.trans.recv_fn = esp.msg->msg.tcpip_mode.recv_fn;
+                        esp.trans.arg = esp.msg->msg.tcpip_mode.arg;
+                        esp.trans.active = 1;
+                        esp.trans.raw = 1;      /* Next bytes are data from remote side */
+                        esp.msg->res = espOK;
+                        esp_sys_sem_release(&esp.sem_sync); /* Command is finished */
+                    }
+#endif /* ESP_CFG_TRANSPARENT */
                     
                     /*
                      * Check if "+IPD" statement is in array and now we received colon,
                      * indicating end of +IPD and start of actual data
                      */
-                    if (ch == ':' && RECV_LEN() > 4 && RECV_IDX(0) == '+' && !strncmp(recv.data, "+IPD", 4)) {
+                    if (ch == ':' && RECV_LEN() > 4 && RECV_IDX(0) == '+' && (!strncmp(recv.data, "+IPD", 4)
+#if ESP_CFG_CONN_RECV_PASSIVE
+                        || (RECV_LEN() > 12 && !strncmp(recv.data, "+CIPRECVDATA", 12))
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
+                        )) {
                         espi_parse_received(&recv); /* Parse received string */
                         if (esp.ipd.read) {     /* Are we going into read mode? */
                             size_t len;
@@ -937,7 +1555,7 @@ espi_process(const void* data, size_t data_len) {
                             
                             len = ESP_MIN(esp.ipd.rem_len, ESP_CFG_IPD_MAX_BUFF_SIZE);
                             if (esp.ipd.conn->status.f.active) {    /* If connection is not active, doesn't make sense to read anything */
-                                esp.ipd.buff = esp_pbuf_new(len);   /* Allocate new packet buffer */
+                                esp.ipd.buff = ipd_pbuf_new(d, len);/* Allocate new packet buffer */
                                 if (esp.ipd.buff != NULL) {
                                     esp_pbuf_set_ip(esp.ipd.buff, esp.ipd.ip, esp.ipd.port);    /* Set IP and port for received data */
                                 }
@@ -1107,10 +1725,21 @@ espi_process_sub_cmd(esp_msg_t* msg, uint8_t is_ok, uint8_t is_error, uint8_t is
                 n_cmd = ESP_CMD_TCPIP_CIPDINFO; /* Set data info */
                 break;
             }
+#if ESP_CFG_CONN_RECV_PASSIVE
+            case ESP_CMD_TCPIP_CIPDINFO: {
+                n_cmd = ESP_CMD_TCPIP_CIPRECVMODE;  /* Set passive receive mode */
+                break;
+            }
+            case ESP_CMD_TCPIP_CIPRECVMODE: {
+                n_cmd = ESP_CMD_TCPIP_CIPSTATUS;/* Get connection status */
+                break;
+            }
+#else
             case ESP_CMD_TCPIP_CIPDINFO: {
                 n_cmd = ESP_CMD_TCPIP_CIPSTATUS;/* Get connection status */
                 break;
             }
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
 #if ESP_CFG_MODE_ACCESS_POINT
             case ESP_CMD_TCPIP_CIPSTATUS: {
                 n_cmd = ESP_CMD_WIFI_CIPAP_GET; /* Get access point IP */
@@ -1151,16 +1780,106 @@ espi_process_sub_cmd(esp_msg_t* msg, uint8_t is_ok, uint8_t is_error, uint8_t is
             }
         }
     }
+    
+#if ESP_CFG_TRANSPARENT
+    /*
+     * Enter transparent mode with single connection or go back to multiple connections
+     */
+    if (msg->cmd_def == ESP_CMD_TCPIP_CIPMODE) {
+        esp_cmd_t n_cmd = ESP_CMD_IDLE;
+        if (msg->msg.tcpip_mode.mode) {
+            if (!is_ok) {
+                if (msg->cmd != ESP_CMD_TCPIP_CIPMUX) {
+                    espi_transparent_restore(); /* Go back to multiple connections with new command */
+                }
+                return espERR;
+            }
+            switch (msg->cmd) {
+                case ESP_CMD_TCPIP_CIPMUX: n_cmd = ESP_CMD_TCPIP_CIPSTART_SINGLE; break;
+                case ESP_CMD_TCPIP_CIPSTART_SINGLE: n_cmd = ESP_CMD_TCPIP_CIPMODE; break;
+                case ESP_CMD_TCPIP_CIPMODE: n_cmd = ESP_CMD_TCPIP_CIPSEND_TRANSPARENT; break;
+                default: break;
+            }
+        } else {                                /* Results are ignored, connection may already be closed */
+            switch (msg->cmd) {
+                case ESP_CMD_TCPIP_CIPMODE: n_cmd = ESP_CMD_TCPIP_CIPCLOSE_SINGLE; break;
+                case ESP_CMD_TCPIP_CIPCLOSE_SINGLE: n_cmd = ESP_CMD_TCPIP_CIPMUX; break;
+                default: esp.trans.active = 0; break;   /* Other commands are allowed again */
+            }
+        }
+        if (n_cmd != ESP_CMD_IDLE) {
+            msg->cmd = n_cmd;
+            if (espi_initiate_cmd(msg) == espOK) {
+                return espCONT;
+            }
+            if (msg->msg.tcpip_mode.mode) {
+                espi_transparent_restore();
+            } else {
+                esp.trans.active = 0;
+            }
+            return espERR;
+        }
+        return espOK;
+    }
+#endif /* ESP_CFG_TRANSPARENT */
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE
+    /*
+     * Verify AT port with startup test and payload round trips,
+     * device must echo payload while they are running
+     */
+    if (msg->cmd_def == ESP_CMD_UART_CHECK) {
+        esp_cmd_t n_cmd = ESP_CMD_IDLE;
+        if (!is_ok) {
+            return espERR;
+        }
+        switch (msg->cmd) {
+#if !ESP_CFG_AT_ECHO
+            case ESP_CMD_AT: n_cmd = ESP_CMD_ATE1; break;   /* Enable echo for round trips */
+            case ESP_CMD_ATE0: break;           /* Echo is disabled again */
+#endif /* !ESP_CFG_AT_ECHO */
+            default: {
+                if (msg->cmd == ESP_CMD_UART_CHECK) {
+                    msg->msg.uart_check.round++;
+                } else {
+                    msg->msg.uart_check.time = esp_sys_now();   /* Round trips start now */
+                }
+                if (msg->msg.uart_check.round < msg->msg.uart_check.rounds) {
+                    n_cmd = ESP_CMD_UART_CHECK;
+                    break;
+                }
+                if (msg->msg.uart_check.bytes_per_sec != NULL) {
+                    uint32_t bytes, time = esp_sys_now() - msg->msg.uart_check.time;
+                    
+                    /* Command line with CR LF was sent and echoed back */
+                    bytes = 2 * (uint32_t)msg->msg.uart_check.rounds * (sizeof(UART_CHECK_PREFIX) + 1 + ESP_CFG_AT_BAUDRATE_CHECK_LEN);
+                    *msg->msg.uart_check.bytes_per_sec = (uint32_t)((uint64_t)bytes * 1000 / (time ? time : 1));
+                }
+#if !ESP_CFG_AT_ECHO
+                n_cmd = ESP_CMD_ATE0;           /* Disable echo as before */
+#endif /* !ESP_CFG_AT_ECHO */
+                break;
+            }
+        }
+        if (n_cmd != ESP_CMD_IDLE) {
+            msg->cmd = n_cmd;
+            if (espi_initiate_cmd(msg) == espOK) {
+                return espCONT;
+            }
+            return espERR;
+        }
+        return espOK;
+    }
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE */
     return is_ok || is_ready ? espOK : espERR;
 }
 
 /**
- * \brief           Function to initialize every AT command
+ * \brief           Format AT command for message to AT port
  * \param[in]       msg: Pointer to \ref esp_msg_t with data
  * \return          Member of \ref espr_t enumeration
  */
-espr_t
-espi_initiate_cmd(esp_msg_t* msg) {
+static espr_t
+initiate_cmd(esp_msg_t* msg) {
     switch (msg->cmd) {                         /* Check current message we want to send over AT */
         case ESP_CMD_RESET: {                   /* Reset MCU with AT commands */
             ESP_AT_PORT_SEND_STR("AT+RST\r\n");
@@ -1189,6 +1908,16 @@ espi_initiate_cmd(esp_msg_t* msg) {
             ESP_AT_PORT_SEND_STR("\r\n");
             break;
         }
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE
+        case ESP_CMD_AT: {                      /* Test AT startup */
+            ESP_AT_PORT_SEND_STR("AT\r\n");
+            break;
+        }
+        case ESP_CMD_UART_CHECK: {              /* Send payload to be echoed */
+            send_uart_check(msg);
+            break;
+        }
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE */
         
         /*
          * WiFi related commands
@@ -1450,7 +2179,7 @@ espi_initiate_cmd(esp_msg_t* msg) {
         }
 #if ESP_CFG_MODE_STATION        
         case ESP_CMD_TCPIP_CIPSTART: {          /* Start a new connection */
-            int8_t i = 0;
+            int16_t i = 0;
             esp_conn_t* c = NULL;
             char str[6];
             
@@ -1462,7 +2191,7 @@ espi_initiate_cmd(esp_msg_t* msg) {
             
             msg->msg.conn_start.num = 0;        /* Reset to make sure default value is set */
             for (i = ESP_CFG_MAX_CONNS - 1; i >= 0; i--) {  /* Find available connection */
-                if (!esp.conns[i].status.f.active || !(esp.active_conns & (1 << i))) {
+                if (!esp.conns[i].status.f.active || !ESP_CONN_MAP_IS_SET(&esp.active_conns, i)) {
                     c = &esp.conns[i];
                     c->num = i;
                     msg->msg.conn_start.num = i;/* Set connection number for message structure */
@@ -1507,12 +2236,46 @@ espi_initiate_cmd(esp_msg_t* msg) {
             ESP_AT_PORT_SEND_STR("\r\n");
             break;
         }
+#if ESP_CFG_TRANSPARENT
+        case ESP_CMD_TCPIP_CIPSTART_SINGLE: {   /* Start single connection for transparent mode */
+            ESP_AT_PORT_SEND_STR("AT+CIPSTART=\"");
+            if (msg->msg.tcpip_mode.type == ESP_CONN_TYPE_SSL) {
+                ESP_AT_PORT_SEND_STR("SSL");
+            } else {
+                ESP_AT_PORT_SEND_STR("TCP");
+            }
+            ESP_AT_PORT_SEND_STR("\",");
+            send_string(msg->msg.tcpip_mode.host, 1, 1);
+            ESP_AT_PORT_SEND_STR(",");
+            send_number(msg->msg.tcpip_mode.port, 0);
+            ESP_AT_PORT_SEND_STR("\r\n");
+            break;
+        }
+        case ESP_CMD_TCPIP_CIPMODE: {           /* Set transmission mode */
+            if (!msg->msg.tcpip_mode.mode) {
+                esp.trans.raw = 0;              /* Escape sequence was sent, process AT responses again */
+                esp.trans.exiting = 0;
+            }
+            ESP_AT_PORT_SEND_STR("AT+CIPMODE=");
+            ESP_AT_PORT_SEND_STR(msg->msg.tcpip_mode.mode ? "1" : "0");
+            ESP_AT_PORT_SEND_STR("\r\n");
+            break;
+        }
+        case ESP_CMD_TCPIP_CIPSEND_TRANSPARENT: {   /* Start transparent transmission */
+            ESP_AT_PORT_SEND_STR("AT+CIPSEND\r\n");
+            break;
+        }
+        case ESP_CMD_TCPIP_CIPCLOSE_SINGLE: {   /* Close single connection */
+            ESP_AT_PORT_SEND_STR("AT+CIPCLOSE\r\n");
+            break;
+        }
+#endif /* ESP_CFG_TRANSPARENT */
         case ESP_CMD_TCPIP_CIPSEND: {           /* Send data to connection */
             return espi_tcpip_process_send_data();  /* Process send data */
         }
         case ESP_CMD_TCPIP_CIPSTATUS: {         /* Get status of device and all connections */
             esp.active_conns_last = esp.active_conns;   /* Save as last status */
-            esp.active_conns = 0;               /* Reset new status before parsing starts */
+            ESP_CONN_MAP_RESET(&esp.active_conns);  /* Reset new status before parsing starts */
             ESP_AT_PORT_SEND_STR("AT+CIPSTATUS\r\n");   /* Send command to AT port */
             break;
         }
@@ -1526,9 +2289,50 @@ espi_initiate_cmd(esp_msg_t* msg) {
             ESP_AT_PORT_SEND_STR("\r\n");
             break;
         }
+#if ESP_CFG_CONN_RECV_PASSIVE
+        case ESP_CMD_TCPIP_CIPRECVMODE: {       /* Set receive mode */
+            ESP_AT_PORT_SEND_STR("AT+CIPRECVMODE=1\r\n");
+            break;
+        }
+        case ESP_CMD_TCPIP_CIPRECVDATA: {       /* Read data held by device */
+            esp_conn_t* c = msg->msg.conn_recv.conn;
+            size_t len;
+
+            if (!c->status.f.active || msg->msg.conn_recv.val_id != c->val_id) {
+                return espERR;                  /* Connection was closed in the meantime */
+            }
+            len = ESP_MIN(c->recv_avail, ESP_CFG_CONN_RECV_WINDOW - ESP_MIN(c->recv_unacked, ESP_CFG_CONN_RECV_WINDOW));
+            len = ESP_MIN(len, ESP_CFG_IPD_MAX_BUFF_SIZE);
+#if ESP_CFG_PBUF_POOL
+            if (!espi_pbuf_pool_free()) {       /* Other connections took all buffers in the meantime */
+                esp.recv_pool_wait = 1;
+                len = 0;
+            }
+            len = ESP_MIN(len, ESP_CFG_PBUF_POOL_BUFF_SIZE);    /* Data must fit to single pool buffer */
+#endif /* ESP_CFG_PBUF_POOL */
+            if (!len) {
+                c->recv_queued = 0;             /* Nothing to read at the moment */
+                return espERR;
+            }
+            msg->msg.conn_recv.len = len;
+
+            ESP_AT_PORT_SEND_STR("AT+CIPRECVDATA=");
+            send_number(c->num, 0);
+            ESP_AT_PORT_SEND_STR(",");
+            send_number(len, 0);
+            ESP_AT_PORT_SEND_STR("\r\n");
+            break;
+        }
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
         case ESP_CMD_TCPIP_CIPMUX: {            /* Set multiple connections */
+            uint8_t mux = msg->cmd_def == ESP_CMD_RESET || msg->msg.tcpip_mux.mux;  /* If reset command is active, enable CIPMUX */
+#if ESP_CFG_TRANSPARENT
+            if (msg->cmd_def == ESP_CMD_TCPIP_CIPMODE) {
+                mux = !msg->msg.tcpip_mode.mode;/* Transparent mode works with single connection only */
+            }
+#endif /* ESP_CFG_TRANSPARENT */
             ESP_AT_PORT_SEND_STR("AT+CIPMUX=");
-            if (msg->cmd_def == ESP_CMD_RESET || msg->msg.tcpip_mux.mux) {  /* If reset command is active, enable CIPMUX */
+            if (mux) {
                 ESP_AT_PORT_SEND_STR("1");
             } else {
                 ESP_AT_PORT_SEND_STR("0");
@@ -1591,6 +2395,20 @@ espi_initiate_cmd(esp_msg_t* msg) {
     return espOK;                               /* Valid command */
 }
 
+/**
+ * \brief           Function to initialize every AT command
+ * \param[in]       msg: Pointer to \ref esp_msg_t with data
+ * \return          Member of \ref espr_t enumeration
+ */
+espr_t
+espi_initiate_cmd(esp_msg_t* msg) {
+    espr_t res;
+
+    res = initiate_cmd(msg);                    /* Format command */
+    ESP_AT_PORT_FLUSH();                        /* Send everything at once */
+    return res;
+}
+
 /**
  * \brief           Checks if connection pointer has valid address
  * \param[in]       conn: Address to check if valid connection ptr
@@ -1618,6 +2436,201 @@ espi_send_cb(esp_cb_type_t type) {
     return esp.cb_func(&esp.cb);                /* Call function and return status */
 }
 
+#if ESP_CFG_CMD_COALESCE || __DOXYGEN__
+
+/**
+ * \brief           Check if message is query other requests may share result with
+ * \param[in]       msg: Message to check
+ * \return          1 if message is query, 0 otherwise
+ */
+static uint8_t
+coalesce_is_query(esp_msg_t* msg) {
+    switch (msg->cmd_def) {
+        case ESP_CMD_TCPIP_CIPSTATUS:
+#if ESP_CFG_MODE_STATION
+        case ESP_CMD_WIFI_CWLAP:
+#endif /* ESP_CFG_MODE_STATION */
+            return 1;
+#if ESP_CFG_MODE_STATION
+        case ESP_CMD_WIFI_CIPSTA_GET:
+#endif /* ESP_CFG_MODE_STATION */
+#if ESP_CFG_MODE_ACCESS_POINT
+        case ESP_CMD_WIFI_CIPAP_GET:
+#endif /* ESP_CFG_MODE_ACCESS_POINT */
+            return !msg->msg.sta_ap_getip.def;  /* Only current settings are kept in stack */
+#if ESP_CFG_MODE_STATION
+        case ESP_CMD_WIFI_CIPSTAMAC_GET:
+#endif /* ESP_CFG_MODE_STATION */
+#if ESP_CFG_MODE_ACCESS_POINT
+        case ESP_CMD_WIFI_CIPAPMAC_GET:
+#endif /* ESP_CFG_MODE_ACCESS_POINT */
+            return !msg->msg.sta_ap_getmac.def; /* Only current settings are kept in stack */
+        default:
+            return 0;
+    }
+}
+
+/**
+ * \brief           Check if result of query can be used for another request
+ * \param[in]       q: Queued or executing query
+ * \param[in]       msg: New request
+ * \return          1 if request can wait for query, 0 otherwise
+ */
+static uint8_t
+coalesce_match(esp_msg_t* q, esp_msg_t* msg) {
+    if (q->cmd_def != msg->cmd_def) {
+        return 0;
+    }
+#if ESP_CFG_MODE_STATION
+    if (msg->cmd_def == ESP_CMD_WIFI_CWLAP) {
+        if ((q->msg.ap_list.ssid == NULL) != (msg->msg.ap_list.ssid == NULL)
+            || (q->msg.ap_list.ssid != NULL && strcmp(q->msg.ap_list.ssid, msg->msg.ap_list.ssid))) {
+            return 0;                           /* Different filter */
+        }
+        if (msg->msg.ap_list.aps != NULL
+            && (q->msg.ap_list.aps == NULL || msg->msg.ap_list.apsl > q->msg.ap_list.apsl)) {
+            return 0;                           /* Query does not keep enough access points */
+        }
+    }
+#endif /* ESP_CFG_MODE_STATION */
+    return 1;
+}
+
+/**
+ * \brief           Copy result of finished query to request waiting for it
+ * \param[in]       q: Finished query
+ * \param[in]       msg: Request waiting for query
+ */
+static void
+coalesce_copy(esp_msg_t* q, esp_msg_t* msg) {
+    esp_ip_mac_t* im;
+    
+    msg->res = q->res;
+    if (q->res != espOK) {
+        return;
+    }
+#if ESP_CFG_MODE_STATION_ACCESS_POINT
+    im = (msg->cmd_def == ESP_CMD_WIFI_CIPSTA_GET || msg->cmd_def == ESP_CMD_WIFI_CIPSTAMAC_GET) ? &esp.sta : &esp.ap;
+#elif ESP_CFG_MODE_STATION
+    im = &esp.sta;
+#else
+    im = &esp.ap;
+#endif /* ESP_CFG_MODE_STATION_ACCESS_POINT */
+    switch (msg->cmd_def) {
+#if ESP_CFG_MODE_STATION
+        case ESP_CMD_WIFI_CWLAP: {
+            size_t n = ESP_MIN(q->msg.ap_list.apsi, msg->msg.ap_list.apsl);
+            if (msg->msg.ap_list.aps != NULL && n > 0) {
+                memcpy(msg->msg.ap_list.aps, q->msg.ap_list.aps, n * sizeof(*msg->msg.ap_list.aps));
+            }
+            msg->msg.ap_list.apsi = n;
+            if (msg->msg.ap_list.apf != NULL) {
+                *msg->msg.ap_list.apf = n;
+            }
+            break;
+        }
+        case ESP_CMD_WIFI_CIPSTA_GET:
+#endif /* ESP_CFG_MODE_STATION */
+#if ESP_CFG_MODE_ACCESS_POINT
+        case ESP_CMD_WIFI_CIPAP_GET:
+#endif /* ESP_CFG_MODE_ACCESS_POINT */
+        {
+            if (msg->msg.sta_ap_getip.ip != NULL) {
+                memcpy(msg->msg.sta_ap_getip.ip, im->ip, 4);
+            }
+            if (msg->msg.sta_ap_getip.gw != NULL) {
+                memcpy(msg->msg.sta_ap_getip.gw, im->gw, 4);
+            }
+            if (msg->msg.sta_ap_getip.nm != NULL) {
+                memcpy(msg->msg.sta_ap_getip.nm, im->nm, 4);
+            }
+            break;
+        }
+#if ESP_CFG_MODE_STATION
+        case ESP_CMD_WIFI_CIPSTAMAC_GET:
+#endif /* ESP_CFG_MODE_STATION */
+#if ESP_CFG_MODE_ACCESS_POINT
+        case ESP_CMD_WIFI_CIPAPMAC_GET:
+#endif /* ESP_CFG_MODE_ACCESS_POINT */
+        {
+            if (msg->msg.sta_ap_getmac.mac != NULL) {
+                memcpy(msg->msg.sta_ap_getmac.mac, im->mac, 6);
+            }
+            break;
+        }
+        default:                                /* Connection status has no output */
+            break;
+    }
+}
+
+/**
+ * \brief           Attach request to the same query already queued or register it as new query
+ * \param[in]       msg: New request
+ * \return          1 if request waits for existing query and must not be queued, 0 otherwise
+ */
+static uint8_t
+coalesce_add(esp_msg_t* msg) {
+    esp_msg_t* q;
+    
+    if (!coalesce_is_query(msg)) {
+        return 0;
+    }
+    ESP_CORE_PROTECT();
+    for (q = esp.co_queries; q != NULL; q = q->co_next) {
+        if (coalesce_match(q, msg)) {
+            msg->co_next = q->co_waiters;       /* Wait for result of existing query */
+            q->co_waiters = msg;
+            esp.co_saved++;
+            ESP_CORE_UNPROTECT();
+            return 1;
+        }
+    }
+    msg->co_next = esp.co_queries;              /* New query, others may wait for it */
+    esp.co_queries = msg;
+    ESP_CORE_UNPROTECT();
+    return 0;
+}
+
+/**
+ * \brief           Remove query from list of queued queries
+ * \param[in]       msg: Query to remove
+ */
+static void
+coalesce_remove(esp_msg_t* msg) {
+    esp_msg_t** m;
+    
+    for (m = &esp.co_queries; *m != NULL; m = &(*m)->co_next) {
+        if (*m == msg) {
+            *m = msg->co_next;
+            break;
+        }
+    }
+}
+
+/**
+ * \brief           Finish query and give its result to requests waiting for it
+ * \note            Function must be called with core protected, before message is released
+ * \param[in]       msg: Finished message
+ * \return          List of requests linked with `co_next` member, to be released as finished messages
+ */
+esp_msg_t*
+espi_coalesce_finish(esp_msg_t* msg) {
+    esp_msg_t* w;
+    
+    if (!coalesce_is_query(msg)) {
+        return NULL;
+    }
+    coalesce_remove(msg);                       /* New requests must send their own query now */
+    for (w = msg->co_waiters; w != NULL; w = w->co_next) {
+        coalesce_copy(msg, w);
+    }
+    w = msg->co_waiters;
+    msg->co_waiters = NULL;
+    return w;
+}
+
+#endif /* ESP_CFG_CMD_COALESCE || __DOXYGEN__ */
+
 /**
  * \brief           Send message from API function to producer queue for further processing
  * \param[in]       msg: New message to process
@@ -1628,7 +2641,7 @@ espi_send_cb(esp_cb_type_t type) {
 espr_t
 espi_send_msg_to_producer_mbox(esp_msg_t* msg, espr_t (*process_fn)(esp_msg_t *), uint32_t block, uint32_t max_block_time) {
     espr_t res = msg->res = espOK;
-    if (block) {                                /* In case message is blocking */
+    if (block && !ESP_MSG_SEM_IS_POOLED(msg)) {/* In case message is blocking and has no semaphore yet */
         if (!esp_sys_sem_create(&msg->sem, 0)) {/* Create semaphore and lock it immediatelly */
             ESP_MSG_VAR_FREE(msg);              /* Release memory and return */
             return espERRMEM;
@@ -1640,12 +2653,45 @@ espi_send_msg_to_producer_mbox(esp_msg_t* msg, espr_t (*process_fn)(esp_msg_t *)
     msg->is_blocking = block;                   /* Set status if message is blocking */
     msg->block_time = max_block_time;           /* Set blocking status if necessary */
     msg->fn = process_fn;                       /* Save processing function to be called as callback */
+#if ESP_CFG_CMD_EVT
+    if (!block && !msg->evt_set) {              /* Blocking and internal commands leave it for next one */
+        ESP_CORE_PROTECT();
+        msg->evt_fn = esp.cmd_evt_fn;           /* Attach completion function set for this command */
+        msg->evt_arg = esp.cmd_evt_arg;
+        esp.cmd_evt_fn = NULL;                  /* It is used only once */
+        esp.cmd_evt_arg = NULL;
+        ESP_CORE_UNPROTECT();
+    }
+#endif /* ESP_CFG_CMD_EVT */
+#if ESP_CFG_PRODUCER_PRIO
+    msg->queue_time = esp_sys_now();            /* Wait time in lane starts now */
+#endif /* ESP_CFG_PRODUCER_PRIO */
+#if ESP_CFG_CMD_STATS
+    msg->t_enqueue = esp_sys_now();
+#endif /* ESP_CFG_CMD_STATS */
     if (block) {
-        esp_sys_mbox_put(&esp.mbox_producer, msg);  /* Write message to producer queue and wait forever */
+#if ESP_CFG_CMD_COALESCE
+        if (!coalesce_add(msg))                 /* Wait for result of the same query or queue new one */
+#endif /* ESP_CFG_CMD_COALESCE */
+        {
+            esp_sys_mbox_put(&esp.mbox_producer, msg);  /* Write message to producer queue and wait forever */
+        }
     } else {
+#if ESP_CFG_CMD_COALESCE
+        ESP_CORE_PROTECT();                     /* Nobody may wait for query until it is queued */
+        if (!coalesce_add(msg) && !esp_sys_mbox_putnow(&esp.mbox_producer, msg)) {
+            coalesce_remove(msg);
+            res = espERR;
+        }
+        ESP_CORE_UNPROTECT();
+#else /* ESP_CFG_CMD_COALESCE */
         if (!esp_sys_mbox_putnow(&esp.mbox_producer, msg)) {    /* Write message to producer queue immediatelly */
             res = espERR;
         }
+#endif /* !ESP_CFG_CMD_COALESCE */
+        if (res != espOK) {
+            ESP_MSG_VAR_FREE(msg);              /* Message was not queued, nobody else releases it */
+        }
     }
     if (block && res == espOK) {                /* In case we have blocking request */
         uint32_t time;
@@ -1655,10 +2701,31 @@ espi_send_msg_to_producer_mbox(esp_msg_t* msg, espr_t (*process_fn)(esp_msg_t *)
         } else {
             res = msg->res;                     /* Set response status from message response */
         }
-        if (esp_sys_sem_isvalid(&msg->sem)) {   /* In case we have valid semaphore */
-            esp_sys_sem_delete(&msg->sem);      /* Delete semaphore object */
+        if (ESP_SYS_TIMEOUT == time) {
+            /*
+             * Producer may still use the message.
+             * If it did not finish yet, leave message to producer
+             * to release it as non-blocking one, otherwise take
+             * semaphore released in the meantime to keep it locked
+             */
+            ESP_CORE_PROTECT();
+            if (!msg->finished) {
+                msg->is_blocking = 0;
+#if ESP_CFG_CMD_EVT
+                msg->evt_fn = NULL;
+#endif /* ESP_CFG_CMD_EVT */
+                msg = NULL;
+            } else {
+                esp_sys_sem_wait(&msg->sem, 0);
+            }
+            ESP_CORE_UNPROTECT();
+        }
+        if (msg != NULL) {
+            if (!ESP_MSG_SEM_IS_POOLED(msg) && esp_sys_sem_isvalid(&msg->sem)) {/* Pool message keeps its semaphore */
+                esp_sys_sem_delete(&msg->sem);  /* Delete semaphore object */
+            }
+            ESP_MSG_VAR_FREE(msg);              /* Release message */
         }
-        ESP_MSG_VAR_FREE(msg);                  /* Release message */
     }
     return res;
 }
@@ -60,6 +60,27 @@ static size_t MemTotalSize = 0;                     /* Size of memory in units o
 
 static uint32_t mem_allocations;
 
+#if ESP_CFG_MEM_SLAB || __DOXYGEN__
+#if !__DOXYGEN__
+typedef struct SlabBlock {
+    struct SlabBlock* NextFreeBlock;                /*!< Pointer to next free block in class */
+} SlabBlock_t;
+
+typedef struct {
+    uint8_t* Start;                                 /*!< Start address of class memory */
+    uint8_t* End;                                   /*!< End address of class memory */
+    SlabBlock_t* FreeList;                          /*!< List of free blocks */
+    esp_mem_slab_stats_t Stats;                     /*!< Class statistics */
+} SlabClass_t;
+#endif /* !__DOXYGEN__ */
+
+#define SLAB_SIZE(cls)              ((size_t)ESP_CFG_MEM_SLAB_MIN_SIZE << (cls))
+
+static SlabClass_t SlabClasses[ESP_CFG_MEM_SLAB_CLASSES];
+
+static void* mem_alloc(size_t size);
+#endif /* ESP_CFG_MEM_SLAB || __DOXYGEN__ */
+
 /* Insert block to list of free blocks */
 static void
 mem_insertfreeblock(MemBlock_t* newBlock) {
@@ -107,6 +128,102 @@ mem_insertfreeblock(MemBlock_t* newBlock) {
     }
 }
 
+#if ESP_CFG_MEM_SLAB || __DOXYGEN__
+
+/**
+ * \brief           Take memory for all slab classes from heap and build free lists
+ */
+static void
+slab_init(void) {
+    SlabClass_t* c;
+    SlabBlock_t* b;
+    size_t cls, i;
+    
+    for (cls = 0; cls < ESP_CFG_MEM_SLAB_CLASSES; cls++) {
+        c = &SlabClasses[cls];
+        c->Start = mem_alloc(SLAB_SIZE(cls) * ESP_CFG_MEM_SLAB_BLOCKS);
+        if (c->Start == NULL) {                     /* Class stays empty, heap is used instead */
+            continue;
+        }
+        c->End = c->Start + SLAB_SIZE(cls) * ESP_CFG_MEM_SLAB_BLOCKS;
+        c->Stats.size = SLAB_SIZE(cls);
+        c->Stats.blocks = ESP_CFG_MEM_SLAB_BLOCKS;
+        for (i = ESP_CFG_MEM_SLAB_BLOCKS; i > 0; i--) { /* Lowest address is first in list */
+            b = (SlabBlock_t *)(c->Start + (i - 1) * SLAB_SIZE(cls));
+            b->NextFreeBlock = c->FreeList;
+            c->FreeList = b;
+        }
+    }
+}
+
+/**
+ * \brief           Get slab class of allocated memory
+ * \param[in]       ptr: Memory pointer
+ * \return          Slab class or `NULL` if memory is from heap
+ */
+static SlabClass_t*
+slab_get_class(void* ptr) {
+    size_t cls;
+    
+    for (cls = 0; cls < ESP_CFG_MEM_SLAB_CLASSES; cls++) {
+        if ((uint8_t *)ptr >= SlabClasses[cls].Start && (uint8_t *)ptr < SlabClasses[cls].End) {
+            return &SlabClasses[cls];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Allocate memory from smallest slab class with free block
+ * \param[in]       size: Number of bytes to allocate
+ * \return          Pointer to allocated memory or `NULL` if heap must be used
+ */
+static void*
+slab_alloc(size_t size) {
+    SlabClass_t* c;
+    SlabBlock_t* b;
+    size_t cls;
+    
+    for (cls = 0; cls < ESP_CFG_MEM_SLAB_CLASSES; cls++) {
+        if (size > SLAB_SIZE(cls)) {
+            continue;
+        }
+        c = &SlabClasses[cls];
+        if (!c->Stats.blocks) {                     /* Class memory was not available */
+            continue;
+        }
+        if ((b = c->FreeList) == NULL) {
+            c->Stats.misses++;
+            return NULL;                            /* Do not waste larger class, use heap */
+        }
+        c->FreeList = b->NextFreeBlock;
+        c->Stats.allocs++;
+        if (++c->Stats.used > c->Stats.max_used) {
+            c->Stats.max_used = c->Stats.used;
+        }
+        mem_allocations++;
+        return b;
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Return block to its slab class
+ * \param[in]       c: Slab class of block
+ * \param[in]       ptr: Memory to free
+ */
+static void
+slab_free(SlabClass_t* c, void* ptr) {
+    SlabBlock_t* b = ptr;
+    
+    b->NextFreeBlock = c->FreeList;
+    c->FreeList = b;
+    c->Stats.used--;
+    mem_allocations--;
+}
+
+#endif /* ESP_CFG_MEM_SLAB || __DOXYGEN__ */
+
 static uint8_t
 mem_assignmem(const mem_region_t* regions, size_t len) {
     uint8_t* MemStartAddr;
@@ -211,6 +328,9 @@ mem_assignmem(const mem_region_t* regions, size_t len) {
      */
     MemAllocBit = (size_t)((size_t)1 << ((sizeof(size_t) * 8 - 1)));
     
+#if ESP_CFG_MEM_SLAB
+    slab_init();                                    /* Take memory for slab classes */
+#endif /* ESP_CFG_MEM_SLAB */
     return 1;                                       /* Regions set as expected */
 }
 
@@ -226,6 +346,11 @@ mem_alloc(size_t size) {
     if (!size || size >= MemAllocBit) {             /* Check input parameters */
         return 0;
     }
+#if ESP_CFG_MEM_SLAB
+    if ((retval = slab_alloc(size)) != NULL) {      /* Try constant time allocation first */
+        return retval;
+    }
+#endif /* ESP_CFG_MEM_SLAB */
 
     size = MEM_ALIGN(size) + MEMBLOCK_METASIZE;
     if (size > MemAvailableBytes) {                 /* Check if we have enough memory available */
@@ -270,10 +395,10 @@ mem_alloc(size_t size) {
              */
             mem_insertfreeblock(Next);              /* Insert free memory block to list of free memory blocks (linked list chain) */
         }
+        MemAvailableBytes -= Curr->Size;            /* Decrease available memory, block may be bigger than requested */
         Curr->Size |= MemAllocBit;                  /* Set allocated bit = memory is allocated */
         Curr->NextFreeBlock = NULL;                 /* Clear next free block pointer as there is no one */
 
-        MemAvailableBytes -= size;                  /* Decrease available memory */
         if (MemAvailableBytes < MemMinAvailableBytes) { /* Check if current available memory is less than ever before */
             MemMinAvailableBytes = MemAvailableBytes;   /* Update minimal available memory */
         }
@@ -292,6 +417,15 @@ mem_free(void* ptr) {
     if (!ptr) {                                     /* To be in compliance with C free function */
         return;
     }
+#if ESP_CFG_MEM_SLAB
+    {
+        SlabClass_t* c = slab_get_class(ptr);
+        if (c != NULL) {                            /* Block belongs to slab class */
+            slab_free(c, ptr);
+            return;
+        }
+    }
+#endif /* ESP_CFG_MEM_SLAB */
 
     block = (MemBlock_t *)(((uint8_t *)ptr) - MEMBLOCK_METASIZE);   /* Get block data pointer from input pointer */
 
@@ -320,6 +454,14 @@ mem_getusersize(void* ptr) {
     if (!ptr) {
         return 0;
     }
+#if ESP_CFG_MEM_SLAB
+    {
+        SlabClass_t* c = slab_get_class(ptr);
+        if (c != NULL) {
+            return c->Stats.size;
+        }
+    }
+#endif /* ESP_CFG_MEM_SLAB */
     block = (MemBlock_t *)(((uint8_t *)ptr) - MEMBLOCK_METASIZE);   /* Get block meta data pointer */
     if (block->Size & MemAllocBit) {                /* Memory is actually allocated */
         return (block->Size & ~MemAllocBit) - MEMBLOCK_METASIZE;    /* Return size of block */
@@ -483,3 +625,131 @@ esp_mem_assignmemory(const esp_mem_region_t* regions, size_t len) {
     ret = mem_assignmem(regions, len);              /* Assign memory */
     return ret;                                     
 }
+
+#if ESP_CFG_MEM_SLAB || __DOXYGEN__
+
+/**
+ * \brief           Get statistics of slab size class
+ * \param[in]       cls: Class number, from `0` for smallest block size to \ref ESP_CFG_MEM_SLAB_CLASSES - 1
+ * \param[out]      stats: Pointer to output structure
+ * \retval          1: Statistics are valid
+ * \retval          0: Class number is out of range
+ */
+uint8_t
+esp_mem_slab_get_stats(size_t cls, esp_mem_slab_stats_t* stats) {
+    if (cls >= ESP_CFG_MEM_SLAB_CLASSES || stats == NULL) {
+        return 0;
+    }
+    ESP_CORE_PROTECT();
+    *stats = SlabClasses[cls].Stats;
+    ESP_CORE_UNPROTECT();
+    return 1;
+}
+
+#endif /* ESP_CFG_MEM_SLAB || __DOXYGEN__ */
+
+#if ESP_CFG_MSG_POOL || __DOXYGEN__
+
+static esp_msg_t* msg_pool;                         /* Array of preallocated messages */
+static esp_msg_t* msg_pool_free;                    /* List of free messages in pool */
+static esp_mem_msg_pool_stats_t msg_pool_stats;     /* Pool statistics */
+
+/**
+ * \brief           Allocate messages for pool and create semaphore for each of them
+ * \note            Function must be called after memory is assigned and before any API call
+ */
+void
+espi_msg_pool_init(void) {
+    size_t i;
+
+    msg_pool = esp_mem_alloc(ESP_CFG_MSG_POOL_SIZE * sizeof(*msg_pool));
+    if (msg_pool == NULL) {
+        return;                                     /* Heap will be used for every message */
+    }
+    memset(msg_pool, 0x00, ESP_CFG_MSG_POOL_SIZE * sizeof(*msg_pool));
+    for (i = 0; i < ESP_CFG_MSG_POOL_SIZE; i++) {
+        if (!esp_sys_sem_create(&msg_pool[i].sem, 0)) { /* Create semaphore locked, as it is used by blocking calls */
+            break;
+        }
+        msg_pool[i].next = msg_pool_free;
+        msg_pool_free = &msg_pool[i];
+        msg_pool_stats.msgs++;
+    }
+}
+
+/**
+ * \brief           Get new message, from pool if available or from heap otherwise
+ * \note            Message from pool has semaphore created and locked, indicated by `pooled` field
+ * \return          Pointer to cleared message or `NULL` on failure
+ */
+esp_msg_t*
+espi_msg_alloc(void) {
+    esp_msg_t* msg;
+    esp_sys_sem_t sem;
+
+    ESP_CORE_PROTECT();
+    msg = msg_pool_free;
+    if (msg != NULL) {
+        msg_pool_free = msg->next;
+        msg_pool_stats.allocs++;
+        if (++msg_pool_stats.used > msg_pool_stats.max_used) {
+            msg_pool_stats.max_used = msg_pool_stats.used;
+        }
+    } else {
+        msg_pool_stats.misses++;
+    }
+    ESP_CORE_UNPROTECT();
+
+    if (msg != NULL) {
+        sem = msg->sem;                             /* Keep semaphore of pool message */
+        memset(msg, 0x00, sizeof(*msg));
+        msg->sem = sem;
+        msg->pooled = 1;
+    } else {
+        msg = esp_mem_alloc(sizeof(*msg));          /* Pool is exhausted, use heap */
+        if (msg != NULL) {
+            memset(msg, 0x00, sizeof(*msg));
+        }
+    }
+    return msg;
+}
+
+/**
+ * \brief           Free message, previously allocated with \ref espi_msg_alloc
+ * \note            Semaphore of pool message must be locked when message is freed
+ * \param[in]       msg: Message to free
+ */
+void
+espi_msg_free(esp_msg_t* msg) {
+    if (msg == NULL) {
+        return;
+    }
+    if (msg_pool != NULL && msg >= msg_pool && msg < &msg_pool[ESP_CFG_MSG_POOL_SIZE]) {
+        ESP_CORE_PROTECT();
+        msg->next = msg_pool_free;
+        msg_pool_free = msg;
+        msg_pool_stats.used--;
+        ESP_CORE_UNPROTECT();
+    } else {
+        esp_mem_free(msg);
+    }
+}
+
+/**
+ * \brief           Get statistics of message pool
+ * \param[out]      stats: Pointer to output structure
+ * \retval          1: Statistics are valid
+ * \retval          0: Invalid parameter
+ */
+uint8_t
+esp_mem_msg_pool_get_stats(esp_mem_msg_pool_stats_t* stats) {
+    if (stats == NULL) {
+        return 0;
+    }
+    ESP_CORE_PROTECT();
+    *stats = msg_pool_stats;
+    ESP_CORE_UNPROTECT();
+    return 1;
+}
+
+#endif /* ESP_CFG_MSG_POOL || __DOXYGEN__ */
@@ -212,7 +212,10 @@ espi_parse_cipstatus(const char* str) {
     uint8_t cn_num = 0, i;
     
     cn_num = espi_parse_number(&str);           /* Parse connection number */
-    esp.active_conns |= 1 << cn_num;            /* Set flag as active */
+    if (cn_num >= ESP_CFG_MAX_CONNS) {          /* Ignore connections we cannot track */
+        return espERR;
+    }
+    ESP_CONN_MAP_SET(&esp.active_conns, cn_num);/* Set flag as active */
     
     espi_parse_string(&str, NULL, 0, 1);        /* Parse string and ignore result */
     
@@ -239,6 +242,13 @@ espi_parse_ipd(const char* str) {
     
     conn = espi_parse_number(&str);             /* Parse number for connection number */
     len = espi_parse_number(&str);              /* Parse number for number of bytes to read */
+#if ESP_CFG_CONN_RECV_PASSIVE
+    if (*str == '\r') {                         /* No data follow in passive mode, device only reports length */
+        esp.conns[conn].recv_avail += len;      /* Device now holds more data for connection */
+        espi_conn_recv_pull(&esp.conns[conn]);  /* Read them if receive window allows */
+        return espOK;
+    }
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
     espi_parse_ip(&str, esp.ipd.ip);            /* Parse incoming packet IP */
     esp.ipd.port = espi_parse_number(&str);     /* Get port on IPD data */
     
@@ -253,6 +263,38 @@ espi_parse_ipd(const char* str) {
     return espOK;
 }
 
+#if ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__
+
+/**
+ * \brief           Parse +CIPRECVDATA statement and start reading data held by device
+ * \param[in]       str: Input string to parse, starting with number of bytes
+ * \param[in]       msg: Current `AT+CIPRECVDATA` message
+ * \return          Member of \ref espr_t enumeration
+ */
+espr_t
+espi_parse_ciprecvdata(const char* str, esp_msg_t* msg) {
+    esp_conn_t* conn = msg->msg.conn_recv.conn;
+    size_t len;
+
+    len = espi_parse_number(&str);              /* Parse number of bytes device returns */
+    msg->msg.conn_recv.read = len;
+    if (!len) {
+        return espOK;
+    }
+
+    memcpy(esp.ipd.ip, conn->remote_ip, sizeof(esp.ipd.ip));    /* Statement does not include remote address */
+    esp.ipd.port = conn->remote_port;
+
+    esp.ipd.read = 1;                           /* Start reading network data */
+    esp.ipd.tot_len = len;                      /* Total number of bytes in this received packet */
+    esp.ipd.rem_len = len;                      /* Number of remaining bytes to read */
+    esp.ipd.conn = conn;                        /* Pointer to connection we have data for */
+
+    return espOK;
+}
+
+#endif /* ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__ */
+
 /**
  * \brief           Parse AT and SDK versions from AT+GMR response
  * \param[in]       str: String starting with version numbers
@@ -38,6 +38,16 @@
 /* Set size of pbuf structure */
 #define SIZEOF_PBUF_STRUCT          ESP_MEM_ALIGN(sizeof(esp_pbuf_t))
 
+#if ESP_CFG_PBUF_POOL || __DOXYGEN__
+/* Size of pool entry with structure and payload */
+#define PBUF_POOL_ENTRY_SIZE        (SIZEOF_PBUF_STRUCT + ESP_MEM_ALIGN(ESP_CFG_PBUF_POOL_BUFF_SIZE))
+
+static uint8_t* pool_start;                     /* Start address of pool memory */
+static uint8_t* pool_end;                       /* End address of pool memory */
+static esp_pbuf_p pool_free_list;               /* Free packet buffers, linked with next member */
+static esp_pbuf_pool_stats_t pool_stats;        /* Pool statistics */
+#endif /* ESP_CFG_PBUF_POOL || __DOXYGEN__ */
+
 /**
  * \brief           Skip pbufs for desired offset
  * \param[in]       p: Source pbuf to skip
@@ -89,6 +99,160 @@ esp_pbuf_new(size_t len) {
     return p;
 }
 
+#if ESP_CFG_PBUF_POOL || __DOXYGEN__
+
+/**
+ * \brief           Take memory for receive pool from heap and build free list
+ * \note            Called once at stack init, before heap gets fragmented
+ */
+void
+espi_pbuf_pool_init(void) {
+    esp_pbuf_p p;
+    size_t i;
+    
+    if (pool_start != NULL) {                   /* Pool is already initialized */
+        return;
+    }
+    pool_start = esp_mem_alloc(PBUF_POOL_ENTRY_SIZE * ESP_CFG_PBUF_POOL_SIZE);
+    if (pool_start == NULL) {                   /* Pool stays empty, heap is used instead */
+        return;
+    }
+    pool_end = pool_start + PBUF_POOL_ENTRY_SIZE * ESP_CFG_PBUF_POOL_SIZE;
+    pool_stats.size = ESP_CFG_PBUF_POOL_BUFF_SIZE;
+    pool_stats.buffs = ESP_CFG_PBUF_POOL_SIZE;
+    for (i = ESP_CFG_PBUF_POOL_SIZE; i > 0; i--) {  /* Lowest address is first in list */
+        p = (esp_pbuf_p)(pool_start + (i - 1) * PBUF_POOL_ENTRY_SIZE);
+        p->next = pool_free_list;
+        pool_free_list = p;
+    }
+}
+
+/**
+ * \brief           Allocate packet buffer for received data from pool
+ * \note            When pool is empty or length is too big, packet buffer is allocated from heap
+ * \param[in]       len: Length of payload memory to allocate
+ * \return          Pointer to allocated memory or NULL in case of failure
+ */
+esp_pbuf_p
+espi_pbuf_pool_new(size_t len) {
+    esp_pbuf_p p = NULL;
+    
+    if (len <= ESP_CFG_PBUF_POOL_BUFF_SIZE && pool_stats.buffs) {
+        ESP_CORE_PROTECT();                     /* Buffers are returned from application threads */
+        if ((p = pool_free_list) != NULL) {
+            pool_free_list = p->next;
+            pool_stats.allocs++;
+            if (++pool_stats.used > pool_stats.max_used) {
+                pool_stats.max_used = pool_stats.used;
+            }
+        } else {
+            pool_stats.misses++;
+        }
+        ESP_CORE_UNPROTECT();
+    }
+    if (p == NULL) {
+        return esp_pbuf_new(len);               /* Use heap instead */
+    }
+    memset(p, 0x00, SIZEOF_PBUF_STRUCT);
+    p->tot_len = len;                           /* Set total length of pbuf chain */
+    p->len = len;                               /* Set payload length */
+    p->payload = (uint8_t *)(((char *)p) + SIZEOF_PBUF_STRUCT); /* Set pointer to payload data */
+    p->ref = 1;                                 /* Single reference is used on this pbuf */
+    return p;
+}
+
+/**
+ * \brief           Get number of free packet buffers in receive pool
+ * \return          Number of free buffers or `ESP_SIZET_MAX` when pool is not used and heap is the only source
+ */
+size_t
+espi_pbuf_pool_free(void) {
+    size_t cnt;
+
+    if (!pool_stats.buffs) {
+        return ESP_SIZET_MAX;
+    }
+    ESP_CORE_PROTECT();
+    cnt = pool_stats.buffs - pool_stats.used;
+    ESP_CORE_UNPROTECT();
+    return cnt;
+}
+
+/**
+ * \brief           Get statistics of receive packet buffer pool
+ * \param[out]      stats: Pointer to output structure
+ * \retval          1: Statistics are valid
+ * \retval          0: Invalid parameter
+ */
+uint8_t
+esp_pbuf_pool_get_stats(esp_pbuf_pool_stats_t* stats) {
+    if (stats == NULL) {
+        return 0;
+    }
+    ESP_CORE_PROTECT();
+    *stats = pool_stats;
+    ESP_CORE_UNPROTECT();
+    return 1;
+}
+
+#endif /* ESP_CFG_PBUF_POOL || __DOXYGEN__ */
+
+/**
+ * \brief           Release memory of packet buffer with reference count 0
+ * \param[in]       p: Packet buffer to release
+ */
+static void
+pbuf_mem_free(esp_pbuf_p p) {
+#if ESP_CFG_IPD_ZERO_COPY
+    if (p->rx_hold) {                           /* Does payload belong to input buffer? */
+        espi_rx_release(p->rx_hold);            /* Allow input buffer to reuse memory */
+    }
+#endif /* ESP_CFG_IPD_ZERO_COPY */
+#if ESP_CFG_PBUF_POOL
+    if ((uint8_t *)p >= pool_start && (uint8_t *)p < pool_end) {
+        ESP_CORE_PROTECT();
+        p->next = pool_free_list;               /* Return buffer to pool */
+        pool_free_list = p;
+        pool_stats.used--;
+#if ESP_CFG_CONN_RECV_PASSIVE
+        if (esp.recv_pool_wait) {               /* Some reads were postponed on empty pool */
+            esp.recv_pool_wait = 0;
+            espi_conn_recv_pull_all();
+        }
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
+        ESP_CORE_UNPROTECT();
+        return;
+    }
+#endif /* ESP_CFG_PBUF_POOL */
+    esp_mem_free(p);                            /* Free memory for pbuf */
+}
+
+#if ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+
+/**
+ * \brief           Allocate packet buffer structure only, referencing existing payload memory
+ * \note            Caller must make sure payload memory is valid until packet buffer is freed
+ * \param[in]       payload: Pointer to payload memory
+ * \param[in]       len: Length of payload memory
+ * \return          Pointer to allocated packet buffer or NULL in case of failure
+ */
+esp_pbuf_p
+espi_pbuf_new_ref(void* payload, size_t len) {
+    esp_pbuf_p p;
+    
+    p = esp_mem_calloc(1, SIZEOF_PBUF_STRUCT);  /* Allocate memory for structure only */
+    ESP_DEBUGW(ESP_CFG_DBG_PBUF | ESP_DBG_TYPE_TRACE, p == NULL, "PBUF: Failed to allocate reference to %d bytes\r\n", (int)len);
+    if (p != NULL) {
+        p->tot_len = len;                       /* Set total length of pbuf chain */
+        p->len = len;                           /* Set payload length */
+        p->payload = payload;                   /* Use memory provided by caller */
+        p->ref = 1;                             /* Single reference is used on this pbuf */
+    }
+    return p;
+}
+
+#endif /* ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
+
 /**
  * \brief           Free previously allocated packet buffer
  * \param[in]       pbuf: Packet buffer to free
@@ -112,7 +276,7 @@ esp_pbuf_free(esp_pbuf_p pbuf) {
             ESP_DEBUGF(ESP_CFG_DBG_PBUF | ESP_DBG_TYPE_TRACE,
                 "PBUF deallocating %p with len/tot_len: %d/%d\r\n", p, (int)p->len, (int)p->tot_len);
             pn = p->next;                       /* Save next entry */
-            esp_mem_free(p);                    /* Free memory for pbuf */
+            pbuf_mem_free(p);                   /* Free memory for pbuf */
             p = pn;                             /* Restore with next entry */
             cnt++;                              /* Increase number of freed pbufs */
         } else {
@@ -310,32 +474,140 @@ esp_pbuf_get_at(const esp_pbuf_p pbuf, size_t pos, uint8_t* el) {
     return 0;                                   /* Invalid character */
 }
 
+/* Lower case of ASCII character */
+#define PBUF_LOWER(c)               (((c) >= 'A' && (c) <= 'Z') ? ((c) + ('a' - 'A')) : (c))
+
 /**
- * \brief           Find desired needle in a haystack
+ * \brief           Position in pbuf chain, moving only forward
+ */
+typedef struct {
+    esp_pbuf_p p;                               /*!< Current pbuf in chain */
+    size_t base;                                /*!< Position of first byte of current pbuf in chain */
+} pbuf_cursor_t;
+
+/**
+ * \brief           Get byte at position, which must not be before current cursor pbuf
+ * \param[in,out]   c: Cursor to move forward
+ * \param[in]       pos: Absolute position in chain, must be less than total length
+ * \return          Byte value
+ */
+static uint8_t
+pbuf_cursor_get(pbuf_cursor_t* c, size_t pos) {
+    while (pos - c->base >= c->p->len) {        /* Skip pbufs before position */
+        c->base += c->p->len;
+        c->p = c->p->next;
+    }
+    return c->p->payload[pos - c->base];
+}
+
+/**
+ * \brief           Find needle in pbuf chain with Boyer-Moore-Horspool algorithm
+ *
+ *                  Window end and window start are tracked with separate cursors,
+ *                  so chain is walked only once regardless of needle length and number of pbufs
+ *
  * \param[in]       pbuf: Pbuf used as haystack
  * \param[in]       needle: Data memory used as needle
  * \param[in]       len: Length of needle memory
  * \param[in]       off: Starting offset in pbuf memory
+ * \param[in]       nocase: Set to `1` to ignore case of ASCII letters
  * \return          ESP_SIZET_MAX if no match or position where in pbuf we have a match
- * \sa              esp_pbuf_strfind
  */
-size_t
-esp_pbuf_memfind(const esp_pbuf_p pbuf, const void* needle, size_t len, size_t off) {
-    size_t i;
-    if (pbuf != NULL && needle != NULL && pbuf->tot_len >= (len + off)) {   /* Check if valid entries */
-        /*
-         * Try entire buffer element by element
-         * and in case we have a match, report it
-         */
-        for (i = off; i <= pbuf->tot_len - len; i++) {
-            if (!esp_pbuf_memcmp(pbuf, needle, len, i)) {   /* Check if identical */
-                return i;                       /* We have a match! */
+static size_t
+pbuf_find(const esp_pbuf_p pbuf, const void* needle, size_t len, size_t off, uint8_t nocase) {
+    const uint8_t* n = needle;
+    uint8_t skip[256], last, ch;
+    pbuf_cursor_t start, end, cmp;
+    const uint8_t* d;
+    size_t i, pos, e, lim, max_skip;
+    
+    if (pbuf == NULL || needle == NULL || !len || pbuf->tot_len < (len + off)) {   /* Check if valid entries */
+        return ESP_SIZET_MAX;
+    }
+    
+    /*
+     * Build table of shifts for last character of window.
+     * Shifts are limited to table element size, smaller shift is always safe
+     */
+    max_skip = len > 0xFF ? 0xFF : len;
+    memset(skip, (int)max_skip, sizeof(skip));
+    for (i = 0; i < len - 1; i++) {
+        ch = nocase ? PBUF_LOWER(n[i]) : n[i];
+        if (len - 1 - i < max_skip) {
+            skip[ch] = (uint8_t)(len - 1 - i);
+            if (nocase && ch >= 'a' && ch <= 'z') {
+                skip[ch - ('a' - 'A')] = skip[ch];
+            }
+        }
+    }
+    last = nocase ? PBUF_LOWER(n[len - 1]) : n[len - 1];
+    
+    start.p = end.p = pbuf;
+    start.base = end.base = 0;
+    pos = off;
+    while (pos <= pbuf->tot_len - len) {
+        e = pos + len - 1;                      /* Position of last character of window */
+        pbuf_cursor_get(&end, e);               /* Move cursor to pbuf with last character */
+        d = end.p->payload;
+        lim = end.base + end.p->len;
+        
+        /* Shift window while last character is in the same pbuf */
+        while (1) {
+            ch = d[e - end.base];
+            if ((nocase ? PBUF_LOWER(ch) : ch) == last || (e += skip[ch]) >= lim) {
+                break;
+            }
+        }
+        pos = e - (len - 1);
+        if (e >= lim) {                         /* Continue in next pbuf */
+            continue;
+        }
+        
+        /* Last character matches, compare the rest of window */
+        pbuf_cursor_get(&start, pos);           /* Move start cursor to window */
+        cmp = start;
+        for (i = 0; i < len - 1; i++) {
+            uint8_t c = pbuf_cursor_get(&cmp, pos + i);
+            if (nocase ? PBUF_LOWER(c) != PBUF_LOWER(n[i]) : c != n[i]) {
+                break;
             }
         }
+        if (i == len - 1) {
+            return pos;                         /* We have a match! */
+        }
+        pos += skip[ch];
     }
     return ESP_SIZET_MAX;                       /* Return maximal value of size_t variable to indicate error */
 }
 
+/**
+ * \brief           Find desired needle in a haystack
+ * \param[in]       pbuf: Pbuf used as haystack
+ * \param[in]       needle: Data memory used as needle
+ * \param[in]       len: Length of needle memory
+ * \param[in]       off: Starting offset in pbuf memory
+ * \return          ESP_SIZET_MAX if no match or position where in pbuf we have a match
+ * \sa              esp_pbuf_strfind, esp_pbuf_memfind_nocase
+ */
+size_t
+esp_pbuf_memfind(const esp_pbuf_p pbuf, const void* needle, size_t len, size_t off) {
+    return pbuf_find(pbuf, needle, len, off, 0);
+}
+
+/**
+ * \brief           Find desired needle in a haystack, ignoring case of ASCII letters
+ * \param[in]       pbuf: Pbuf used as haystack
+ * \param[in]       needle: Data memory used as needle
+ * \param[in]       len: Length of needle memory
+ * \param[in]       off: Starting offset in pbuf memory
+ * \return          ESP_SIZET_MAX if no match or position where in pbuf we have a match
+ * \sa              esp_pbuf_strfind_nocase, esp_pbuf_memfind
+ */
+size_t
+esp_pbuf_memfind_nocase(const esp_pbuf_p pbuf, const void* needle, size_t len, size_t off) {
+    return pbuf_find(pbuf, needle, len, off, 1);
+}
+
 /**
  * \brief           Find desired needle (str) in a haystack (pbuf)
  * \param[in]       pbuf: Pbuf used as haystack
@@ -349,6 +621,20 @@ esp_pbuf_strfind(const esp_pbuf_p pbuf, const char* str, size_t off) {
     return esp_pbuf_memfind(pbuf, str, strlen(str), off);
 }
 
+/**
+ * \brief           Find desired needle (str) in a haystack (pbuf), ignoring case of ASCII letters
+ * \note            Useful for HTTP header names, which are case insensitive
+ * \param[in]       pbuf: Pbuf used as haystack
+ * \param[in]       str: String to search for in pbuf
+ * \param[in]       off: Starting offset in pbuf memory
+ * \return          ESP_SIZET_MAX if no match or position where in pbuf we have a match
+ * \sa              esp_pbuf_memfind_nocase
+ */
+size_t
+esp_pbuf_strfind_nocase(const esp_pbuf_p pbuf, const char* str, size_t off) {
+    return esp_pbuf_memfind_nocase(pbuf, str, strlen(str), off);
+}
+
 /**
  * \brief           Compare pbuf memory with memory from data
  * \note            Compare is done on entire pbuf chain
@@ -362,8 +648,7 @@ esp_pbuf_strfind(const esp_pbuf_p pbuf, const char* str, size_t off) {
 size_t
 esp_pbuf_memcmp(const esp_pbuf_p pbuf, const void* data, size_t len, size_t offset) {
     esp_pbuf_p p;
-    size_t i;
-    uint8_t el;
+    size_t i, l;
     const uint8_t* d = data;
     
     if (pbuf == NULL || data == NULL || !len || /* Input parameters check */
@@ -381,13 +666,12 @@ esp_pbuf_memcmp(const esp_pbuf_p pbuf, const void* data, size_t len, size_t offs
     
     /*
      * We have known starting pbuf.
-     * Now it is time to check byte by byte from pbuf and memory
-     *
-     * Use byte by byte read function to inspect bytes separatelly
+     * Now compare linear part of each pbuf at a time
      */
-    for (i = 0; i < len; i++) {
-        if (!esp_pbuf_get_at(p, offset + i, &el) || el != d[i]) {   /* Get value from pbuf at specific offset */
-            return offset + 1;                  /* Return value from offset where it failed */
+    for (i = 0; i < len; i += l, p = p->next, offset = 0) {
+        l = ESP_MIN(p->len - offset, len - i);
+        if (memcmp(&p->payload[offset], &d[i], l)) {
+            return i + 1;                       /* Return non-zero value where compare failed */
         }
     }
     return 0;                                   /* Memory matches at this point */
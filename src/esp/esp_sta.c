@@ -77,6 +77,40 @@ esp_sta_join(const char* name, const char* pass, const uint8_t* mac, uint8_t def
     return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, blocking, 30000);   /* Send message to producer queue */
 }
 
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+
+/**
+ * \brief           Join as station to access point in non-blocking way and get notified when it finishes
+ * \param[in]       name: SSID of access point to connect to
+ * \param[in]       pass: Password of access point. Use NULL if AP does not have password
+ * \param[in]       mac: Pointer to MAC address of AP. If you have APs with same name, you can use MAC to select proper one. Use NULL if not needed
+ * \param[in]       def: Status whether this is default SSID or only current one
+ * \param[in]       evt_fn: Completion function called with final result of command.
+ *                      Set to `NULL` to use function set with \ref esp_set_cmd_evt_fn
+ * \param[in]       evt_arg: Custom user argument passed to completion function
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_sta_join_ex(const char* name, const char* pass, const uint8_t* mac, uint8_t def, esp_cmd_evt_fn evt_fn, void* evt_arg) {
+    ESP_MSG_VAR_DEFINE(msg);                    /* Define variable for message */
+    
+    ESP_ASSERT("name != NULL", name != NULL);   /* Assert input parameters */
+    
+    ESP_MSG_VAR_ALLOC(msg);                     /* Allocate memory for variable */
+    ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_WIFI_CWJAP;
+    ESP_MSG_VAR_REF(msg).msg.sta_join.def = def;
+    ESP_MSG_VAR_REF(msg).msg.sta_join.name = name;
+    ESP_MSG_VAR_REF(msg).msg.sta_join.pass = pass;
+    ESP_MSG_VAR_REF(msg).msg.sta_join.mac = mac;
+    ESP_MSG_VAR_REF(msg).evt_fn = evt_fn;
+    ESP_MSG_VAR_REF(msg).evt_arg = evt_arg;
+    ESP_MSG_VAR_REF(msg).evt_set = evt_fn != NULL;
+    
+    return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, 0, 30000);  /* Send message to producer queue */
+}
+
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
+
 /**
  * \brief           Get station IP address
  * \param[out]      ip: Pointer to variable to save IP address. Memory of at least 4 bytes is required
@@ -40,6 +40,309 @@
 #include "esp/esp_mem.h"
 #include "system/esp_sys.h"
 
+#if ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__
+
+/**
+ * \brief           Get connection whose send queue message belongs to
+ * \param[in]       msg: Message from producer queue
+ * \return          Connection handle or `NULL` if message is executed directly
+ */
+static esp_conn_t*
+sched_get_conn(esp_msg_t* msg) {
+    if (msg->cmd_def == ESP_CMD_TCPIP_CIPSEND) {
+        return msg->msg.conn_send.conn;
+    } else if (msg->cmd_def == ESP_CMD_TCPIP_CIPCLOSE
+        && esp.send_q[msg->msg.conn_close.conn->num] != NULL) {
+        return msg->msg.conn_close.conn;        /* Close after data already queued on connection */
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Add message to the end of connection send queue
+ * \param[in]       conn: Connection handle
+ * \param[in]       msg: Message to add
+ */
+static void
+sched_add(esp_conn_t* conn, esp_msg_t* msg) {
+    esp_msg_t** m;
+    
+    msg->next = NULL;
+    msg->sched_time = esp_sys_now();
+    for (m = &esp.send_q[conn->num]; *m != NULL; m = &(*m)->next) {}
+    *m = msg;
+    ESP_CONN_MAP_SET(&esp.send_q_map, conn->num);
+}
+
+/**
+ * \brief           Check if any connection has message in send queue
+ * \return          1 if there is at least one message waiting, 0 otherwise
+ */
+static uint8_t
+sched_is_pending(void) {
+    return espi_conn_map_next(&esp.send_q_map, 0) < ESP_CFG_MAX_CONNS;
+}
+
+/**
+ * \brief           Get next message to execute in round-robin order between connections
+ * \note            Message is left at the head of its connection queue
+ * \return          Message to execute or `NULL` if all queues are empty
+ */
+static esp_msg_t*
+sched_next(void) {
+    esp_msg_t* msg;
+    esp_conn_t* conn;
+    uint32_t wait;
+    size_t n;
+    
+    n = espi_conn_map_next(&esp.send_q_map, esp.send_q_next);
+    if (n >= ESP_CFG_MAX_CONNS) {               /* Wrap around to the beginning */
+        n = espi_conn_map_next(&esp.send_q_map, 0);
+        if (n >= ESP_CFG_MAX_CONNS) {
+            return NULL;
+        }
+    }
+    esp.send_q_next = (n + 1) % ESP_CFG_MAX_CONNS;  /* Start with next connection in next round */
+    
+    msg = esp.send_q[n];
+    conn = &esp.conns[n];
+    wait = esp_sys_now() - msg->sched_time;
+    conn->send_chunks++;
+    conn->send_wait_total += wait;
+    if (wait > conn->send_wait_max) {
+        conn->send_wait_max = wait;
+    }
+    return msg;
+}
+
+#endif /* ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__ */
+
+#if ESP_CFG_PRODUCER_PRIO || __DOXYGEN__
+
+/**
+ * \brief           Check if data lane has message waiting for execution
+ * \return          1 if there is at least one message waiting, 0 otherwise
+ */
+static uint8_t
+prio_data_is_pending(void) {
+#if ESP_CFG_CONN_SEND_SCHED
+    return sched_is_pending();                  /* Send scheduler keeps data lane messages */
+#else /* ESP_CFG_CONN_SEND_SCHED */
+    return esp.prio[ESP_PRIO_DATA].head != NULL;
+#endif /* !ESP_CFG_CONN_SEND_SCHED */
+}
+
+/**
+ * \brief           Check if any lane has message waiting for execution
+ * \return          1 if there is at least one message waiting, 0 otherwise
+ */
+static uint8_t
+prio_is_pending(void) {
+    return esp.prio[ESP_PRIO_CONTROL].head != NULL || prio_data_is_pending();
+}
+
+/**
+ * \brief           Add message from producer queue to its priority lane
+ * \param[in]       msg: Message to add
+ */
+static void
+prio_add(esp_msg_t* msg) {
+    esp_prio_lane_t* lane;
+#if ESP_CFG_CONN_SEND_SCHED
+    esp_conn_t* conn;
+#else /* ESP_CFG_CONN_SEND_SCHED */
+    esp_msg_t* m;
+#endif /* !ESP_CFG_CONN_SEND_SCHED */
+    
+    msg->prio = ESP_PRIO_CONTROL;
+#if ESP_CFG_CONN_SEND_SCHED
+    if ((conn = sched_get_conn(msg)) != NULL) { /* Data and close after data go to connection queue */
+        msg->prio = ESP_PRIO_DATA;
+        sched_add(conn, msg);
+    }
+#else /* ESP_CFG_CONN_SEND_SCHED */
+    if (msg->cmd_def == ESP_CMD_TCPIP_CIPSEND) {
+        msg->prio = ESP_PRIO_DATA;
+    } else if (msg->cmd_def == ESP_CMD_TCPIP_CIPCLOSE) {
+        for (m = esp.prio[ESP_PRIO_DATA].head; m != NULL; m = m->next) {
+            if (m->msg.conn_send.conn == msg->msg.conn_close.conn) {
+                msg->prio = ESP_PRIO_DATA;      /* Close after data already queued on connection */
+                break;
+            }
+        }
+    }
+#endif /* !ESP_CFG_CONN_SEND_SCHED */
+    
+    lane = &esp.prio[msg->prio];
+#if ESP_CFG_CONN_SEND_SCHED
+    if (msg->prio == ESP_PRIO_CONTROL)          /* Data lane is kept by send scheduler */
+#endif /* ESP_CFG_CONN_SEND_SCHED */
+    {
+        msg->next = NULL;
+        if (lane->tail != NULL) {
+            lane->tail->next = msg;
+        } else {
+            lane->head = msg;
+        }
+        lane->tail = msg;
+    }
+    if (++lane->queued > lane->queued_max) {
+        lane->queued_max = lane->queued;
+    }
+}
+
+/**
+ * \brief           Remove first message from lane list
+ * \param[in]       lane: Lane to get message from
+ * \return          Message or `NULL` if lane is empty
+ */
+static esp_msg_t*
+prio_lane_get(esp_prio_lane_t* lane) {
+    esp_msg_t* msg = lane->head;
+    
+    if (msg != NULL) {
+        lane->head = msg->next;
+        if (lane->head == NULL) {
+            lane->tail = NULL;
+        }
+        msg->next = NULL;
+    }
+    return msg;
+}
+
+/**
+ * \brief           Get next message to execute
+ * \note            Control lane has priority, data lane gets its turn
+ *                  after \ref ESP_CFG_PRODUCER_CONTROL_BURST control commands in a row
+ * \return          Message to execute or `NULL` if all lanes are empty
+ */
+static esp_msg_t*
+prio_next(void) {
+    esp_prio_lane_t* lane;
+    esp_msg_t* msg;
+    uint32_t wait;
+    
+    if (esp.prio[ESP_PRIO_CONTROL].head != NULL
+        && (esp.prio_burst < ESP_CFG_PRODUCER_CONTROL_BURST || !prio_data_is_pending())) {
+        msg = prio_lane_get(&esp.prio[ESP_PRIO_CONTROL]);
+        if (esp.prio_burst < ESP_CFG_PRODUCER_CONTROL_BURST) {
+            esp.prio_burst++;
+        }
+    } else {
+#if ESP_CFG_CONN_SEND_SCHED
+        msg = sched_next();                     /* Message is left in connection queue */
+#else /* ESP_CFG_CONN_SEND_SCHED */
+        msg = prio_lane_get(&esp.prio[ESP_PRIO_DATA]);
+#endif /* !ESP_CFG_CONN_SEND_SCHED */
+        esp.prio_burst = 0;
+    }
+    
+    if (msg != NULL && !msg->prio_started) {    /* Count wait time only once, data may be sent in chunks */
+        msg->prio_started = 1;
+        lane = &esp.prio[msg->prio];
+        wait = esp_sys_now() - msg->queue_time;
+        lane->executed++;
+        lane->wait_total += wait;
+        if (wait > lane->wait_max) {
+            lane->wait_max = wait;
+        }
+    }
+    return msg;
+}
+
+#endif /* ESP_CFG_PRODUCER_PRIO || __DOXYGEN__ */
+
+/**
+ * \brief           Execute message and wait for command to finish
+ * \param[in]       e: ESP main structure
+ * \param[in]       msg: Message to execute
+ * \return          Result of command execution
+ */
+static espr_t
+producer_exec(esp_t* e, esp_msg_t* msg) {
+    espr_t res;
+    uint32_t time;
+    
+#if ESP_CFG_TRANSPARENT
+    if (esp.trans.active && msg->cmd_def != ESP_CMD_TCPIP_CIPMODE) {
+        msg->res = espERR;                      /* Command would be sent to remote side as data */
+        return espERR;
+    }
+#endif /* ESP_CFG_TRANSPARENT */
+    
+    /*
+     * Try to call function to process this message
+     * Usually it should be function to transmit data to AT port
+     */
+    esp.msg = msg;
+#if ESP_CFG_CMD_STATS
+    if (!msg->t_started) {                      /* Data may be sent in chunks, count first start only */
+        msg->t_start = esp_sys_now();
+        msg->t_started = 1;
+    }
+#endif /* ESP_CFG_CMD_STATS */
+    if (msg->fn != NULL) {                      /* Check for callback processing function */
+        ESP_CORE_UNPROTECT();                   /* Release protection, think if this is necessary, probably shouldn't be here */
+        esp_sys_sem_wait(&e->sem_sync, 0000);   /* Lock semaphore, should be unlocked before! */
+        ESP_CORE_PROTECT();                     /* Protect system again, think if this is necessary, probably shouldn't be here */
+        res = msg->fn(msg);                     /* Process this message, check if command started at least */
+        if (res == espOK) {                     /* We have valid data and data were sent */
+            ESP_CORE_UNPROTECT();               /* Release protection */
+            time = esp_sys_sem_wait(&e->sem_sync, msg->block_time); /* Wait for synchronization semaphore */
+            ESP_CORE_PROTECT();                 /* Protect system again */
+            esp_sys_sem_release(&e->sem_sync);  /* Release protection and start over later */
+            if (time == ESP_SYS_TIMEOUT) {      /* Sync timeout occurred? */
+                res = msg->res = espTIMEOUT;    /* Timeout on command, do not report it as success */
+            }
+        } else {
+            esp_sys_sem_release(&e->sem_sync);  /* We failed, release semaphore automatically */
+            msg->res = res;                     /* Command did not start, report reason */
+        }
+    } else {
+        res = msg->res = espERR;                /* Simply set error message */
+    }
+#if ESP_CFG_CONN_RECV_PASSIVE
+    if (res == espTIMEOUT && msg->cmd_def == ESP_CMD_TCPIP_CIPRECVDATA
+        && msg->msg.conn_recv.val_id == msg->msg.conn_recv.conn->val_id) {
+        msg->msg.conn_recv.conn->recv_queued = 0;   /* Allow new read on next notification or confirmation */
+        msg->msg.conn_recv.conn->recv_retry = 1;    /* Device still holds data, read again from connection poll */
+    }
+#endif /* ESP_CFG_CONN_RECV_PASSIVE */
+    esp.msg = NULL;
+    return res;
+}
+
+/**
+ * \brief           Release finished message
+ * \param[in]       msg: Finished message
+ */
+static void
+producer_release(esp_msg_t* msg) {
+    /*
+     * In case message is blocking,
+     * release semaphore that we finished with processing
+     * otherwise directly free memory of message structure
+     */
+    ESP_CORE_PROTECT();                         /* Caller may give up waiting at the same time */
+    if (msg->is_blocking) {
+        msg->finished = 1;
+        esp_sys_sem_release(&msg->sem);         /* Release semaphore */
+        msg = NULL;
+    }
+    ESP_CORE_UNPROTECT();
+    if (msg != NULL) {
+#if ESP_CFG_CMD_EVT
+        if (msg->evt_fn != NULL) {
+            msg->evt_fn(msg->res, msg->evt_arg);/* Report final result of command */
+        }
+#endif /* ESP_CFG_CMD_EVT */
+        if (!ESP_MSG_SEM_IS_POOLED(msg) && esp_sys_sem_isvalid(&msg->sem)) {
+            esp_sys_sem_delete(&msg->sem);      /* Blocking message abandoned by caller after timeout */
+        }
+        ESP_MSG_VAR_FREE(msg);                  /* Release message structure */
+    }
+}
+
 /**
  * \brief           User input thread to process inputs packets from API functions
  */
@@ -49,55 +352,107 @@ esp_thread_producer(void* const arg) {
     esp_msg_t* msg;                             /* Message structure */
     espr_t res;
     uint32_t time;
+#if ESP_CFG_CONN_SEND_SCHED
+    esp_conn_t* conn;
+#endif /* ESP_CFG_CONN_SEND_SCHED */
+#if ESP_CFG_CONN_SEND_SCHED || ESP_CFG_PRODUCER_PRIO
+    uint8_t pending;
+#endif /* ESP_CFG_CONN_SEND_SCHED || ESP_CFG_PRODUCER_PRIO */
+#if ESP_CFG_CMD_COALESCE
+    esp_msg_t* waiters;
+#endif /* ESP_CFG_CMD_COALESCE */
     
     ESP_CORE_PROTECT();                         /* Protect system */
     while (1) {
+#if ESP_CFG_PRODUCER_PRIO
+        pending = prio_is_pending();            /* Do not block when there are messages in lanes */
+#elif ESP_CFG_CONN_SEND_SCHED
+        pending = sched_is_pending();           /* Do not block when there are data to send */
+#endif /* ESP_CFG_PRODUCER_PRIO */
         ESP_CORE_UNPROTECT();                   /* Unprotect system */
-        time = esp_sys_mbox_get(&esp.mbox_producer, (void **)&msg, 0);  /* Get message from queue */
+#if ESP_CFG_CONN_SEND_SCHED || ESP_CFG_PRODUCER_PRIO
+        if (pending) {
+            time = esp_sys_mbox_getnow(&esp.mbox_producer, (void **)&msg) ? 0 : ESP_SYS_TIMEOUT;
+        } else
+#endif /* ESP_CFG_CONN_SEND_SCHED || ESP_CFG_PRODUCER_PRIO */
+        {
+            time = esp_sys_mbox_get(&esp.mbox_producer, (void **)&msg, 0);  /* Get message from queue */
+        }
         ESP_CORE_PROTECT();                     /* Protect system */
-        if (time == ESP_SYS_TIMEOUT || !msg) {  /* Check valid message */
-            continue;
+        if (time == ESP_SYS_TIMEOUT) {
+            msg = NULL;
         }
-        
+#if ESP_CFG_PRODUCER_PRIO
         /*
-         * Try to call function to process this message
-         * Usually it should be function to transmit data to AT port
+         * Sort all messages waiting in producer queue to lanes,
+         * then execute the most important one
          */
-        esp.msg = msg;
-        if (msg->fn != NULL) {                  /* Check for callback processing function */
-            ESP_CORE_UNPROTECT();               /* Release protection, think if this is necessary, probably shouldn't be here */
-            esp_sys_sem_wait(&e->sem_sync, 0000);   /* Lock semaphore, should be unlocked before! */
-            ESP_CORE_PROTECT();                 /* Protect system again, think if this is necessary, probably shouldn't be here */
-            res = msg->fn(msg);                 /* Process this message, check if command started at least */
-            if (res == espOK) {                 /* We have valid data and data were sent */
-                ESP_CORE_UNPROTECT();           /* Release protection */
-                time = esp_sys_sem_wait(&e->sem_sync, msg->block_time); /* Wait for synchronization semaphore */
-                ESP_CORE_PROTECT();              /* Protect system again */
-                esp_sys_sem_release(&e->sem_sync);  /* Release protection and start over later */
-                if (time == ESP_SYS_TIMEOUT) {  /* Sync timeout occurred? */
-                    res = espTIMEOUT;           /* Timeout on command */
-                }
-            } else {
-                esp_sys_sem_release(&e->sem_sync);  /* We failed, release semaphore automatically */
+        while (msg != NULL) {
+            prio_add(msg);
+            if (!esp_sys_mbox_getnow(&esp.mbox_producer, (void **)&msg)) {
+                msg = NULL;
             }
-        } else {
-            res = espERR;                       /* Simply set error message */
         }
-        
+        msg = prio_next();
+#if ESP_CFG_CONN_SEND_SCHED
+        conn = msg != NULL && msg->prio == ESP_PRIO_DATA ? sched_get_conn(msg) : NULL;
+#endif /* ESP_CFG_CONN_SEND_SCHED */
+#elif ESP_CFG_CONN_SEND_SCHED
         /*
-         * In case message is blocking,
-         * release semaphore that we finished with processing
-         * otherwise directly free memory of message structure
+         * Other commands are executed immediately,
+         * data to send go to connection queue and are sent chunk by chunk
          */
-        if (msg->is_blocking) {
-            esp_sys_sem_release(&msg->sem);     /* Release semaphore */
-        } else {
-            /* TODO: Process callback what happened with result and then free message */
-            
-            
-            ESP_MSG_VAR_FREE(msg);              /* Release message structure */
+        conn = NULL;
+        if (msg != NULL && (conn = sched_get_conn(msg)) != NULL) {
+            sched_add(conn, msg);
+            msg = NULL;
+        }
+        if (msg == NULL && (msg = sched_next()) != NULL) {
+            conn = sched_get_conn(msg);
+        }
+#endif /* ESP_CFG_PRODUCER_PRIO */
+        if (msg == NULL) {                      /* Check valid message */
+            continue;
+        }
+        
+        res = producer_exec(e, msg);
+        if (res != espOK && msg->cmd_def == ESP_CMD_TCPIP_CIPSEND) {
+            espi_conn_send_data_free(msg);      /* Timeout or rejected command, device will not report result anymore */
+        }
+        
+#if ESP_CFG_CONN_SEND_SCHED
+        if (conn != NULL) {
+            if (res == espOK && msg->cmd_def == ESP_CMD_TCPIP_CIPSEND && msg->msg.conn_send.yield) {
+                msg->sched_time = esp_sys_now();/* Chunk sent, wait for next turn */
+                continue;
+            }
+            esp.send_q[conn->num] = msg->next;  /* Remove finished message from queue */
+            if (msg->next == NULL) {
+                ESP_CONN_MAP_CLR(&esp.send_q_map, conn->num);
+            }
+        }
+#endif /* ESP_CFG_CONN_SEND_SCHED */
+#if ESP_CFG_PRODUCER_PRIO
+        esp.prio[msg->prio].queued--;           /* Message finished, leaves its lane */
+#endif /* ESP_CFG_PRODUCER_PRIO */
+        
+        ESP_DEBUGF(ESP_CFG_DBG_THREAD | ESP_DBG_TYPE_TRACE,
+            "THREAD: Command %s finished with %d low-level send call(s)\r\n",
+            espi_dbg_msg_to_string(msg->cmd_def), (int)msg->send_calls);
+#if ESP_CFG_CMD_STATS
+        espi_cmd_stats_finish(msg);
+#endif /* ESP_CFG_CMD_STATS */
+        
+#if ESP_CFG_CMD_COALESCE
+        waiters = espi_coalesce_finish(msg);    /* Share result before message is released */
+#endif /* ESP_CFG_CMD_COALESCE */
+        producer_release(msg);
+#if ESP_CFG_CMD_COALESCE
+        for (; waiters != NULL; waiters = msg) {
+            msg = waiters->co_next;
+            producer_release(waiters);
         }
-        esp.msg = NULL;
+#endif /* ESP_CFG_CMD_COALESCE */
     }
 }
 
@@ -112,24 +467,23 @@ esp_thread_producer(void* const arg) {
 void
 esp_thread_process(void* const arg) {
     esp_msg_t* msg;
-    uint32_t time;
     
 #if !ESP_CFG_INPUT_USE_PROCESS
     ESP_CORE_PROTECT();                         /* Protect system */
     while (1) {
         ESP_CORE_UNPROTECT();                   /* Unprotect system */
-        time = espi_get_from_mbox_with_timeout_checks(&esp.mbox_process, (void **)&msg, 10);  /* Get message from queue */
-        ESP_CORE_PROTECT();                     /* Protect system */
         
-        if (time == ESP_SYS_TIMEOUT || msg == NULL) {
-            ESP_UNUSED(time);                   /* Unused variable */
-        }
+        /*
+         * Sleep until input function writes new data
+         * or until next timeout expires
+         */
+        espi_get_from_mbox_with_timeout_checks(&esp.mbox_process, (void **)&msg, 0);
+        ESP_CORE_PROTECT();                     /* Protect system */
         espi_process_buffer();                  /* Process input data */
 #else
     while (1) {
-        /* Check timeouts only */
-        time = espi_get_from_mbox_with_timeout_checks(&esp.mbox_process, (void **)&msg, 100);
-        ESP_UNUSED(time);
+        /* Sleep until next timeout expires */
+        espi_get_from_mbox_with_timeout_checks(&esp.mbox_process, (void **)&msg, 0);
 #endif /* !ESP_CFG_INPUT_USE_PROCESS */
     }
 }
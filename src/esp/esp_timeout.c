@@ -35,83 +35,304 @@
 #include "esp/esp_timeout.h"
 #include "esp/esp_mem.h"
 
-static esp_timeout_t* first_timeout;
-static uint32_t last_timeout_time;
+#define WHEEL_SLOTS             ((uint32_t)1 << ESP_CFG_TIMEOUT_WHEEL_BITS)
+#define WHEEL_MASK              (WHEEL_SLOTS - 1)
+#define WHEEL_SHIFT(level)      ((uint32_t)(level) * ESP_CFG_TIMEOUT_WHEEL_BITS)
+#define WHEEL_RANGE             ((uint32_t)1 << WHEEL_SHIFT(ESP_CFG_TIMEOUT_WHEEL_LEVELS))
+#define WHEEL_MAP_WORDS         ((WHEEL_SLOTS + 31) / 32)
+
+#define WHEEL_MAP_SET(l, s)     (wheel_map[(l)][(s) >> 5] |= (uint32_t)1 << ((s) & 0x1F))
+#define WHEEL_MAP_CLR(l, s)     (wheel_map[(l)][(s) >> 5] &= ~((uint32_t)1 << ((s) & 0x1F)))
+#define WHEEL_MAP_GET(l, s)     (wheel_map[(l)][(s) >> 5] & ((uint32_t)1 << ((s) & 0x1F)))
+
+static esp_timeout_t* wheel[ESP_CFG_TIMEOUT_WHEEL_LEVELS][WHEEL_SLOTS]; /* List of timeouts for each slot */
+static uint32_t wheel_map[ESP_CFG_TIMEOUT_WHEEL_LEVELS][WHEEL_MAP_WORDS];   /* Bit set for each non-empty slot */
+static uint32_t wheel_time;                     /* Time of next tick to process */
+static size_t active_cnt;                       /* Number of active timeouts */
+static uint8_t wheel_busy;                      /* Set to `1` while expired timeouts are processed */
+static uint8_t wheel_sleeping;                  /* Set to `1` while processing thread waits for message */
+static uint32_t wheel_wake_time;                /* Time when sleeping thread wakes up, if it is not `0xFFFFFFFF` */
+static esp_sys_mbox_t* wheel_mbox;              /* Message queue of sleeping thread */
+
+/**
+ * \brief           Check if any slot on wheel level has timeouts
+ * \param[in]       level: Wheel level
+ * \return          `1` if level is used, `0` otherwise
+ */
+static uint8_t
+wheel_level_used(uint32_t level) {
+    uint32_t i;
+    for (i = 0; i < WHEEL_MAP_WORDS; i++) {
+        if (wheel_map[level][i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Insert timeout to wheel slot according to its expiration time
+ * \param[in]       to: Timeout to insert
+ */
+static void
+wheel_link(esp_timeout_t* to) {
+    esp_timeout_t** head;
+    uint32_t delta, level = 0, slot;
+    
+    delta = to->time - wheel_time;
+    if ((int32_t)delta < 0) {                   /* Already expired, process on next tick */
+        delta = 0;
+    } else if (delta >= WHEEL_RANGE) {          /* Out of range, go through top level again */
+        delta = WHEEL_RANGE - 1;
+    }
+    while (level < ESP_CFG_TIMEOUT_WHEEL_LEVELS - 1 && delta >= ((uint32_t)1 << WHEEL_SHIFT(level + 1))) {
+        level++;
+    }
+    slot = ((wheel_time + delta) >> WHEEL_SHIFT(level)) & WHEEL_MASK;
+    
+    head = &wheel[level][slot];
+    to->next = *head;
+    if (to->next != NULL) {
+        to->next->pprev = &to->next;
+    }
+    to->pprev = head;
+    *head = to;
+    WHEEL_MAP_SET(level, slot);
+}
+
+/**
+ * \brief           Remove timeout from list it is currently on
+ * \param[in]       to: Timeout to remove
+ */
+static void
+wheel_unlink(esp_timeout_t* to) {
+    size_t idx;
+    
+    if (to->next != NULL) {
+        to->next->pprev = to->pprev;
+    }
+    *to->pprev = to->next;
+    if (to->next == NULL && to->pprev >= &wheel[0][0]
+        && to->pprev < &wheel[0][0] + ESP_CFG_TIMEOUT_WHEEL_LEVELS * WHEEL_SLOTS
+        && *to->pprev == NULL) {                /* Wheel slot is now empty */
+        idx = (size_t)(to->pprev - &wheel[0][0]);
+        WHEEL_MAP_CLR(idx / WHEEL_SLOTS, idx % WHEEL_SLOTS);
+    }
+    to->next = NULL;
+    to->pprev = NULL;
+}
+
+/**
+ * \brief           Move all timeouts from wheel slot to separate list
+ * \param[in]       level: Wheel level
+ * \param[in]       slot: Slot on level
+ * \param[out]      list: Pointer to list head
+ */
+static void
+wheel_detach(uint32_t level, uint32_t slot, esp_timeout_t** list) {
+    *list = wheel[level][slot];
+    wheel[level][slot] = NULL;
+    WHEEL_MAP_CLR(level, slot);
+    if (*list != NULL) {
+        (*list)->pprev = list;
+    }
+}
 
 /**
  * \brief           Get time we have to wait before we can process next timeout
+ * \note            Core must be protected by caller
  * \return          Time in units of milliseconds to wait
  */
 static uint32_t
 get_next_timeout_diff(void) {
-    uint32_t diff;
-    if (!first_timeout) {
+    uint32_t level, k, base, shift, diff, best = 0xFFFFFFFF, now;
+    
+    if (!active_cnt) {
         return 0xFFFFFFFF;
     }
-    diff = esp_sys_now() - last_timeout_time;   /* Get difference between current time and last process time */
-    if (diff >= first_timeout->time) {          /* Are we over already? */
-        return 0;                               /* We have to immediatelly process this timeout */
+    
+    /*
+     * Find first used slot on each level.
+     * For upper levels this is time when slot is cascaded to lower level,
+     * which is never later than expiration of any timeout in it
+     */
+    for (level = 0; level < ESP_CFG_TIMEOUT_WHEEL_LEVELS; level++) {
+        if (!wheel_level_used(level)) {
+            continue;
+        }
+        shift = WHEEL_SHIFT(level);
+        base = wheel_time >> shift;
+        if (wheel_time & (((uint32_t)1 << shift) - 1)) {    /* Next cascade of this level */
+            base++;
+        }
+        for (k = 0; k < WHEEL_SLOTS; k++) {
+            if (WHEEL_MAP_GET(level, (base + k) & WHEEL_MASK)) {
+                diff = ((base + k) << shift) - wheel_time;
+                if (diff < best) {
+                    best = diff;
+                }
+                break;
+            }
+        }
     }
-    return first_timeout->time - diff;          /* Return remaining time for sleep */
+    now = esp_sys_now();
+    diff = wheel_time + best - now;
+    return (int32_t)diff > 0 ? diff : 0;
 }
 
 /**
- * \brief           Process next timeout in a linked list
+ * \brief           Process all timeouts expired until current time
+ * \note            Core must be protected by caller
+ * \param[in]       now: Current time in units of milliseconds
  */
 static void
-process_next_timeout(void) {
-    uint32_t time;
+wheel_process(uint32_t now) {
+    esp_timeout_t *list, *to;
+    uint32_t tick, level, slot, next;
+    uint8_t dyn;
     
-    time = esp_sys_now();
-    
-    /*
-     * Before calling timeout callback, update variable
-     * to make sure we have correct timing in case 
-     * callback creates timeout value again
-     */
-    last_timeout_time = time;                   /* Reset variable when we were last processed */
-    
-    if (first_timeout != NULL) {
-        esp_timeout_t* to = first_timeout;
+    if (!active_cnt) {
+        wheel_time = now + 1;
+        return;
+    }
+    wheel_busy = 1;
+    while ((int32_t)(now - wheel_time) >= 0) {
+        tick = wheel_time;
+        
+        /* Move timeouts from upper levels when lower level wraps */
+        for (level = 1; level < ESP_CFG_TIMEOUT_WHEEL_LEVELS
+                && !(tick & (((uint32_t)1 << WHEEL_SHIFT(level)) - 1)); level++) {
+            wheel_detach(level, (tick >> WHEEL_SHIFT(level)) & WHEEL_MASK, &list);
+            while ((to = list) != NULL) {
+                wheel_unlink(to);
+                wheel_link(to);
+            }
+        }
+        
+        /* Nothing to do on lowest level, skip to its next wrap */
+        if (!wheel_level_used(0)) {
+            next = (tick | WHEEL_MASK) + 1;
+            if ((int32_t)(next - now) > 0) {
+                wheel_time = now + 1;
+                break;
+            }
+            wheel_time = next;
+            continue;
+        }
         
         /*
-         * Before calling callback remove current timeout from list
-         * to make sure we are safe in case callback function
-         * adds a new timeout entry to list
+         * Set next tick before calling callbacks,
+         * so timeouts added by callbacks are not put to slot being processed
          */
-        first_timeout = first_timeout->next;    /* Set next timeout on a list as first timeout */
-        to->fn(to->arg);                        /* Call user callback function */
-        esp_mem_free(to);                       /* Free timeout memory */
+        wheel_time = tick + 1;
+        slot = tick & WHEEL_MASK;
+        if (wheel[0][slot] == NULL) {
+            continue;
+        }
+        wheel_detach(0, slot, &list);
+        while ((to = list) != NULL) {
+            wheel_unlink(to);
+            if ((int32_t)(to->time - tick) > 0) {   /* Long timeout, not expired yet */
+                wheel_link(to);
+                continue;
+            }
+            dyn = to->dyn;
+            if (to->period) {                   /* Periodic timeout is scheduled again before callback */
+                to->time += to->period;
+                if ((int32_t)(to->time - tick) <= 0) {  /* Skip periods we missed */
+                    to->time = tick + to->period;
+                }
+                wheel_link(to);
+            } else {
+                active_cnt--;
+            }
+            to->fn(to->arg);                    /* Call user callback function */
+            if (dyn) {
+                esp_mem_free(to);               /* Free timeout memory */
+            }
+        }
+    }
+    wheel_busy = 0;
+}
+
+/**
+ * \brief           Start timeout
+ * \note            Core must be protected by caller
+ */
+static void
+timeout_start(esp_timeout_t* to, uint32_t time, uint32_t period, esp_timeout_fn_t fn, void* arg) {
+    uint32_t now = esp_sys_now();
+    
+    if (to->pprev != NULL) {                    /* Timeout is active, re-arm it */
+        wheel_unlink(to);
+    } else {
+        if (!active_cnt && !wheel_busy) {
+            wheel_time = now;                   /* Wheel was idle, continue from current time */
+        }
+        active_cnt++;
+    }
+    to->time = now + time;
+    to->period = period;
+    to->fn = fn;
+    to->arg = arg;
+    wheel_link(to);
+    
+    /*
+     * Processing thread sleeps until previously earliest timeout,
+     * wake it up to calculate new sleep time
+     */
+    if (wheel_sleeping && (wheel_wake_time == 0xFFFFFFFF || (int32_t)(to->time - wheel_wake_time) < 0)) {
+        wheel_sleeping = 0;
+        esp_sys_mbox_putnow(wheel_mbox, NULL);  /* Write empty box */
     }
 }
 
 /**
  * \brief           Get next entry from message queue
+ *
+ *                  Thread sleeps until message is received or until next timeout expires,
+ *                  whichever comes first. All expired timeouts are processed before function returns.
+ *                  When new timeout, which expires before current sleep time, is started from other thread,
+ *                  empty message is written to queue to wake up thread
+ *
  * \param[in]       b: Pointer to message queue to get element
  * \param[out]      m: Pointer to pointer to output variable
- * \param[in]       timeout: Maximal time to wait for message (0 = wait until message received)
- * \return          Time in milliseconds required for next message
+ * \param[in]       timeout: Maximal time to wait for message (0 = wait until message received or timeout expires)
+ * \return          Time in milliseconds waited for message or \ref ESP_SYS_TIMEOUT when no message was received
  */
 uint32_t
 espi_get_from_mbox_with_timeout_checks(esp_sys_mbox_t* b, void** m, uint32_t timeout) {
-    uint32_t wait_time;
-    do {
-        if (first_timeout == NULL) {            /* We have no timeouts ready? */
-            return esp_sys_mbox_get(b, m, timeout); /* Get entry from message queue */
-        }
-        wait_time = get_next_timeout_diff();    /* Get time to wait for next timeout execution */
-        if (wait_time == 0 || esp_sys_mbox_get(b, m, wait_time) == ESP_SYS_TIMEOUT) {
-            ESP_CORE_PROTECT();
-            process_next_timeout();             /* Process with next timeout */
-            ESP_CORE_UNPROTECT();
-        }
-        break;
-    } while (1);
-    return wait_time;
+    uint32_t wait_time, res;
+    
+    *m = NULL;
+    ESP_CORE_PROTECT();
+    wait_time = get_next_timeout_diff();        /* Get time to wait for next timeout execution */
+    if (timeout && wait_time > timeout) {       /* Limit sleep time to maximal time of caller */
+        wait_time = timeout;
+    }
+    if (wait_time) {
+        wheel_mbox = b;
+        wheel_wake_time = wait_time == 0xFFFFFFFF ? 0xFFFFFFFF : (esp_sys_now() + wait_time);
+        wheel_sleeping = 1;
+    }
+    ESP_CORE_UNPROTECT();
+    
+    res = wait_time;
+    if (wait_time) {
+        res = esp_sys_mbox_get(b, m, wait_time == 0xFFFFFFFF ? 0 : wait_time);
+    }
+    
+    ESP_CORE_PROTECT();
+    wheel_sleeping = 0;
+    wheel_process(esp_sys_now());               /* Process all expired timeouts */
+    ESP_CORE_UNPROTECT();
+    return res;
 }
 
 /**
  * \brief           Add new timeout to processing list
+ * \note            Memory for timeout is allocated and freed after timeout expires.
+ *                  Use \ref esp_timeout_start with own handle to avoid allocation
  * \param[in]       time: Time in units of milliseconds for timeout execution
  * \param[in]       fn: Callback function to call when timeout expires
  * \param[in]       arg: Pointer to user specific argument to call when timeout callback function is executed
@@ -120,105 +341,111 @@ espi_get_from_mbox_with_timeout_checks(esp_sys_mbox_t* b, void** m, uint32_t tim
 espr_t
 esp_timeout_add(uint32_t time, esp_timeout_fn_t fn, void* arg) {
     esp_timeout_t* to;
-    uint32_t now, diff = 0;
+    
+    ESP_ASSERT("fn != NULL", fn != NULL);       /* Assert input parameters */
     
     to = esp_mem_calloc(1, sizeof(*to));        /* Allocate memory for timeout structure */
     if (to == NULL) {
         return espERR;
     }
+    to->dyn = 1;
+    ESP_CORE_PROTECT();
+    timeout_start(to, time, 0, fn, arg);
+    ESP_CORE_UNPROTECT();
+    return espOK;
+}
+
+/**
+ * \brief           Remove callback from timeout list
+ * \note            Function searches complete wheel and removes first timeout with matching callback.
+ *                  Use \ref esp_timeout_stop to stop exact timeout in constant time
+ * \param[in]       fn: Callback function to identify timeout to remove
+ * \return          espOK on success, member of \ref espr_t otherwise
+ */
+espr_t
+esp_timeout_remove(esp_timeout_fn_t fn) {
+    esp_timeout_t* to;
+    uint32_t level, slot;
+    espr_t res = espERR;
     
-    now = esp_sys_now();                        /* Get current time */
-    if (first_timeout) {
-        diff = now - last_timeout_time;         /* Get difference between current and last processed time */
-    }
-    
-    /*
-     * Since we want timeout value to start from NOW,
-     * we have to add time when we last processed our timeouts
-     */
-    to->time = time + diff;
-    to->arg = arg;
-    to->fn = fn;
-    
-    /*
-     * Add new timeout to proper place on linked list
-     * and align times to have correct values between timeouts
-     */
-    if (first_timeout == NULL) {
-        first_timeout = to;                     /* Set as first element */
-        last_timeout_time = esp_sys_now();      /* Reset last timeout time to current time */
-    } else {                                    /* Find where to place a new timeout */
-        esp_timeout_t* t;
-        /*
-         * First check if we have to put new timeout
-         * to beginning of linked list.
-         * In this case just align new value for current first element
-         */
-        if (first_timeout->time > to->time) {
-            first_timeout->time -= time;        /* Decrease first timeout value to match difference */
-            to->next = first_timeout;           /* Set first timeout as next of new one */
-            first_timeout = to;                 /* Set new timeout as first */
-        } else {                                /* Go somewhere in between current list */
-            for (t = first_timeout; t != NULL; t = t->next) {
-                to->time -= t->time;            /* Decrease new timeout time by time in a linked list */
-                /*
-                 * Enter between 2 entries on a list in case:
-                 * 
-                 * - We reached end of linked list
-                 * - Our time is less than diff between 2 entries in list
-                 */
-                if (t->next == NULL || t->next->time > to->time) {
-                    if (t->next != NULL) {      /* Check if there is next element */
-                        t->next->time -= to->time;  /* Decrease difference time to next one */
-                    } else if (to->time > time) {
-                        to->time = time + first_timeout->time;
+    ESP_CORE_PROTECT();
+    for (level = 0; level < ESP_CFG_TIMEOUT_WHEEL_LEVELS && res != espOK; level++) {
+        for (slot = 0; slot < WHEEL_SLOTS && res != espOK; slot++) {
+            for (to = wheel[level][slot]; to != NULL; to = to->next) {
+                if (to->fn == fn) {             /* Do we have a match from callback point of view? */
+                    wheel_unlink(to);
+                    active_cnt--;
+                    if (to->dyn) {
+                        esp_mem_free(to);
                     }
-                    to->next = t->next;         /* Change order of elements */
-                    t->next = to;               /* Add new element to linked list */
+                    res = espOK;
                     break;
                 }
             }
         }
     }
+    ESP_CORE_UNPROTECT();
+    return res;
+}
+
+/**
+ * \brief           Start or restart timeout with user handle
+ *
+ *                  When timeout is already active, it is restarted with new parameters.
+ *                  Function executes in constant time, regardless of number of active timeouts
+ *
+ * \note            Handle must be set to zero before first use
+ * \param[in]       to: Timeout handle
+ * \param[in]       time: Time in units of milliseconds for first execution
+ * \param[in]       period: Period in units of milliseconds for next executions or `0` for one-shot timeout
+ * \param[in]       fn: Callback function to call when timeout expires
+ * \param[in]       arg: Pointer to user specific argument to call when timeout callback function is executed
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_timeout_start(esp_timeout_t* to, uint32_t time, uint32_t period, esp_timeout_fn_t fn, void* arg) {
+    ESP_ASSERT("to != NULL", to != NULL);       /* Assert input parameters */
+    ESP_ASSERT("fn != NULL", fn != NULL);       /* Assert input parameters */
+    
+    ESP_CORE_PROTECT();
+    timeout_start(to, time, period, fn, arg);
+    ESP_CORE_UNPROTECT();
     return espOK;
 }
 
 /**
- * \brief           Remove callback from timeout list
- * \param[in]       fn: Callback function to identify timeout to remove
- * \return          espOK on success, member of \ref espr_t otherwise
+ * \brief           Stop active timeout
+ * \note            Function may be called from timeout callback, also for timeout being executed
+ * \param[in]       to: Timeout handle
+ * \return          espOK on success, member of \ref espr_t enumeration otherwise
  */
 espr_t
-esp_timeout_remove(esp_timeout_fn_t fn) {
-    esp_timeout_t *t, *t_prev;
-    
-    for (t = first_timeout, t_prev = NULL; t != NULL;
-            t_prev = t, t = t->next) {          /* Check all entries */
-        if (t->fn == fn) {                      /* Do we have a match from callback point of view? */
-            
-            /*
-             * We have to first increase
-             * difference time between current and next one
-             * to be aligned for correct wait time
-             */
-            if (t->next != NULL) {              /* Do we have next element? */
-                t->next->time += t->time;       /* Increase timeout time for next element */
-            }
-            
-            /*
-             * In case we have previous element on a list,
-             * set next element of previous to next of current one
-             * otherwise we were first element so simply set 
-             * next of current as first one
-             */
-            if (t_prev != NULL) {
-                t_prev->next = t->next;
-            } else {
-                first_timeout = t->next;
-            }
-            esp_mem_free(t);
-            return espOK;
-        }
+esp_timeout_stop(esp_timeout_t* to) {
+    espr_t res = espERR;
+    
+    ESP_ASSERT("to != NULL", to != NULL);       /* Assert input parameters */
+    
+    ESP_CORE_PROTECT();
+    if (to->pprev != NULL) {
+        wheel_unlink(to);
+        active_cnt--;
+        res = espOK;
     }
-    return espERR;
+    ESP_CORE_UNPROTECT();
+    return res;
+}
+
+/**
+ * \brief           Check if timeout is active
+ * \param[in]       to: Timeout handle
+ * \return          `1` if active, `0` otherwise
+ */
+uint8_t
+esp_timeout_is_active(esp_timeout_t* to) {
+    uint8_t res;
+    
+    ESP_CORE_PROTECT();
+    res = to != NULL && to->pprev != NULL;
+    ESP_CORE_UNPROTECT();
+    return res;
 }
@@ -0,0 +1,226 @@
+/**	
+ * \file            esp_transparent.c
+ * \brief           Transparent transmission mode API
+ */
+ 
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *  
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#define ESP_INTERNAL
+#include "esp/esp_private.h"
+#include "esp/esp_transparent.h"
+#include "esp/esp_mem.h"
+
+#if ESP_CFG_TRANSPARENT || __DOXYGEN__
+
+/**
+ * \brief           Send message to enter or leave transparent mode
+ * \param[in]       mode: Enter (1) or leave (0) transparent mode
+ * \param[in]       type: Connection type when entering
+ * \param[in]       host: Remote host when entering
+ * \param[in]       port: Remote port when entering
+ * \param[in]       recv_fn: Function to receive raw data when entering
+ * \param[in]       arg: Custom argument for receive function
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          espOK on success, member of \ref espr_t otherwise
+ */
+static espr_t
+transparent_mode(uint8_t mode, esp_conn_type_t type, const char* host, uint16_t port,
+                    esp_transparent_recv_fn recv_fn, void* arg, uint32_t blocking) {
+    ESP_MSG_VAR_DEFINE(msg);                    /* Define variable for message */
+    
+    ESP_MSG_VAR_ALLOC(msg);                     /* Allocate memory for variable */
+    ESP_MSG_VAR_REF(msg).cmd_def = ESP_CMD_TCPIP_CIPMODE;
+    ESP_MSG_VAR_REF(msg).cmd = mode ? ESP_CMD_TCPIP_CIPMUX : ESP_CMD_TCPIP_CIPMODE;
+    ESP_MSG_VAR_REF(msg).msg.tcpip_mode.mode = mode;
+    ESP_MSG_VAR_REF(msg).msg.tcpip_mode.type = type;
+    ESP_MSG_VAR_REF(msg).msg.tcpip_mode.host = host;
+    ESP_MSG_VAR_REF(msg).msg.tcpip_mode.port = port;
+    ESP_MSG_VAR_REF(msg).msg.tcpip_mode.recv_fn = recv_fn;
+    ESP_MSG_VAR_REF(msg).msg.tcpip_mode.arg = arg;
+    
+    return espi_send_msg_to_producer_mbox(&ESP_MSG_VAR_REF(msg), espi_initiate_cmd, blocking, 60000);   /* Send message to producer queue */
+}
+
+/**
+ * \brief           Wait for guard time of escape sequence
+ */
+static void
+guard_delay(void) {
+    esp_sys_sem_t sem;
+    
+    if (esp_sys_sem_create(&sem, 0)) {          /* Create locked semaphore and wait for timeout */
+        esp_sys_sem_wait(&sem, ESP_CFG_TRANSPARENT_GUARD_TIME);
+        esp_sys_sem_delete(&sem);
+    }
+}
+
+/**
+ * \brief           Go back to multiple connections mode after transparent mode failed to start
+ * \note            Function must be called with core protected
+ * \return          espOK on success, member of \ref espr_t otherwise
+ */
+espr_t
+espi_transparent_restore(void) {
+    return transparent_mode(0, ESP_CONN_TYPE_TCP, NULL, 0, NULL, NULL, 0);
+}
+
+/**
+ * \brief           Open single connection and enter transparent transmission mode
+ *
+ *                  Device must not have any active connection or running server.
+ *                  Once in transparent mode, all other commands are rejected
+ *                  until \ref esp_transparent_stop is called.
+ *
+ * \param[in]       type: Connection type, \ref ESP_CONN_TYPE_TCP or \ref ESP_CONN_TYPE_SSL
+ * \param[in]       host: Remote host, either IP address or domain name
+ * \param[in]       port: Remote port
+ * \param[in]       recv_fn: Function called from processing thread with received raw data
+ * \param[in]       arg: Custom argument for receive function
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          espOK on success, member of \ref espr_t otherwise
+ */
+espr_t
+esp_transparent_start(esp_conn_type_t type, const char* host, uint16_t port,
+                        esp_transparent_recv_fn recv_fn, void* arg, uint32_t blocking) {
+    uint8_t active;
+    
+    ESP_ASSERT("type != ESP_CONN_TYPE_UDP", type != ESP_CONN_TYPE_UDP); /* Assert input parameters */
+    ESP_ASSERT("host != NULL", host != NULL);   /* Assert input parameters */
+    ESP_ASSERT("port > 0", port > 0);           /* Assert input parameters */
+    
+    ESP_CORE_PROTECT();
+    active = esp.trans.active;
+    ESP_CORE_UNPROTECT();
+    if (active) {
+        return espERR;
+    }
+    return transparent_mode(1, type, host, port, recv_fn, arg, blocking);
+}
+
+/**
+ * \brief           Send raw data in transparent mode
+ *
+ *                  Data are written directly to AT port, device forwards them
+ *                  to remote side once it receives 2048 bytes or after short pause.
+ *
+ * \note            Data are written to AT port without core protection,
+ *                  call function from one thread only
+ *
+ * \param[in]       data: Data to send
+ * \param[in]       btw: Number of bytes to send
+ * \return          espOK on success, member of \ref espr_t otherwise
+ */
+espr_t
+esp_transparent_send(const void* data, size_t btw) {
+    const uint8_t* d = data;
+    espr_t res = espOK;
+    size_t len;
+    
+    ESP_ASSERT("data != NULL", data != NULL);   /* Assert input parameters */
+    
+    ESP_CORE_PROTECT();
+    if (esp.trans.raw && !esp.trans.exiting) {
+        esp.trans.sending++;                    /* Escape sequence waits for data to be written */
+    } else {
+        res = espERR;                           /* Not in transparent mode */
+    }
+    ESP_CORE_UNPROTECT();
+    
+    if (res == espOK) {
+        for (; btw; btw -= len, d += len) {     /* Low-level function accepts 16-bit length */
+            len = ESP_MIN(btw, 0xFFFF);
+            esp.ll.send_fn(d, (uint16_t)len);
+        }
+        ESP_CORE_PROTECT();
+        esp.trans.sending--;
+        ESP_CORE_UNPROTECT();
+    }
+    return res;
+}
+
+/**
+ * \brief           Leave transparent mode, close connection and go back to multiple connections mode
+ *
+ *                  Escape sequence `+++` is sent with \ref ESP_CFG_TRANSPARENT_GUARD_TIME
+ *                  of silence before and after it, therefore function always waits
+ *                  for twice the guard time and may not be called from callback function.
+ *
+ *                  Raw mode ends when command to leave transparent mode is started.
+ *                  If the command could not be queued, function returns error and may be called again.
+ *
+ * \param[in]       blocking: Status whether command to close connection should be blocking or not
+ * \return          espOK on success, member of \ref espr_t otherwise
+ */
+espr_t
+esp_transparent_stop(uint32_t blocking) {
+    espr_t res;
+    uint8_t sending;
+    
+    ESP_CORE_PROTECT();
+    if (!esp.trans.raw || esp.trans.exiting) {
+        ESP_CORE_UNPROTECT();
+        return espERR;
+    }
+    esp.trans.exiting = 1;                      /* No more data from application */
+    ESP_CORE_UNPROTECT();
+    
+    do {                                        /* Guard time starts after last data are written */
+        guard_delay();
+        ESP_CORE_PROTECT();
+        sending = esp.trans.sending;
+        ESP_CORE_UNPROTECT();
+    } while (sending);
+    esp.ll.send_fn("+++", 3);                   /* Escape sequence as separate packet, nobody else writes to AT port now */
+    guard_delay();                              /* Device accepts commands after guard time */
+    
+    res = transparent_mode(0, ESP_CONN_TYPE_TCP, NULL, 0, NULL, NULL, blocking);
+    if (res != espOK) {
+        ESP_CORE_PROTECT();
+        if (esp.trans.raw) {                    /* Command did not start, allow another attempt */
+            esp.trans.exiting = 0;
+        }
+        ESP_CORE_UNPROTECT();
+    }
+    return res;
+}
+
+/**
+ * \brief           Check if transparent mode is active
+ * \return          `1` if raw data are exchanged with remote side, `0` otherwise
+ */
+uint8_t
+esp_transparent_is_active(void) {
+    uint8_t res;
+    
+    ESP_CORE_PROTECT();
+    res = esp.trans.raw;
+    ESP_CORE_UNPROTECT();
+    return res;
+}
+
+#endif /* ESP_CFG_TRANSPARENT || __DOXYGEN__ */
@@ -39,6 +39,7 @@ extern "C" {
 #endif
 
 #include "esp/esp.h"
+#include "esp/esp_timeout.h"
 
 /**
  * \addtogroup      ESP_APPS
@@ -176,7 +177,7 @@ typedef struct mqtt_client {
     const mqtt_client_info_t* info;             /*!< Connection info */
     mqtt_state_t conn_state;                    /*!< MQTT connection state */
     
-    uint32_t poll_time;                         /*!< Poll time, increased every 500ms */
+    esp_timeout_t keep_alive_timeout;           /*!< Keep-alive timeout, restarted on every packet sent or received */
     
     mqtt_evt_t evt;                             /*!< MQTT event callback */
     mqtt_evt_fn evt_fn;                         /*!< Event callback function */
@@ -115,6 +115,44 @@ struct esp_pbuf_t;
  */
 typedef struct esp_conn_t* esp_conn_p;
 
+#if ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__
+/**
+ * \brief           Send scheduler statistics of connection
+ * \sa              esp_conn_get_send_stats
+ */
+typedef struct {
+    size_t queued;                              /*!< Number of send commands waiting in connection queue */
+    size_t queued_bytes;                        /*!< Number of bytes waiting in connection queue */
+    uint32_t chunks;                            /*!< Number of chunks scheduled on connection */
+    uint32_t wait_avg;                          /*!< Average time chunk waited for its turn, in units of milliseconds */
+    uint32_t wait_max;                          /*!< Maximal time chunk waited for its turn, in units of milliseconds */
+} esp_conn_send_stats_t;
+#endif /* ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__ */
+
+#if ESP_CFG_PRODUCER_PRIO || __DOXYGEN__
+/**
+ * \brief           Priority lanes of producer thread
+ * \sa              ESP_CFG_PRODUCER_PRIO
+ */
+typedef enum {
+    ESP_PRIO_CONTROL = 0x00,                    /*!< Control commands, executed first */
+    ESP_PRIO_DATA,                              /*!< Data send commands */
+    ESP_PRIO_END,                               /*!< Number of lanes, not valid lane */
+} esp_prio_t;
+
+/**
+ * \brief           Statistics of producer priority lane
+ * \sa              esp_get_prio_stats
+ */
+typedef struct {
+    size_t queued;                              /*!< Number of commands currently waiting or executing in lane */
+    size_t queued_max;                          /*!< Maximal number of commands in lane at the same time */
+    uint32_t executed;                          /*!< Number of commands started from lane */
+    uint32_t wait_avg;                          /*!< Average time command waited before execution started, in units of milliseconds */
+    uint32_t wait_max;                          /*!< Maximal time command waited before execution started, in units of milliseconds */
+} esp_prio_stats_t;
+#endif /* ESP_CFG_PRODUCER_PRIO || __DOXYGEN__ */
+
 /**
  * \brief           Pointer to \ref esp_pbuf_t structure
  */
@@ -127,6 +165,23 @@ typedef struct esp_pbuf_t* esp_pbuf_p;
  */
 typedef espr_t  (*esp_cb_fn)(struct esp_cb_t* cb);
 
+/**
+ * \brief           Data type for function called when non-blocking command finishes
+ * \note            Function is called from producer thread with core protected.
+ *                  It may start other non-blocking commands, but must not use blocking ones
+ * \param[in]       res: Final result of command, member of \ref espr_t enumeration
+ * \param[in]       arg: Custom user argument
+ */
+typedef void    (*esp_cmd_evt_fn)(espr_t res, void* arg);
+
+/**
+ * \brief           Data type for function receiving raw data in transparent mode
+ * \param[in]       data: Received data
+ * \param[in]       len: Number of bytes received
+ * \param[in]       arg: Custom user argument
+ */
+typedef void    (*esp_transparent_recv_fn)(const void* data, size_t len, void* arg);
+
 /**
  * \brief           List of possible callback types received to user
  */
@@ -224,6 +279,21 @@ espr_t      esp_dns_getbyhostname(const char* host, void* ip, uint32_t blocking)
 espr_t      esp_core_lock(void);
 espr_t      esp_core_unlock(void);
 
+#if ESP_CFG_PRODUCER_PRIO || __DOXYGEN__
+espr_t      esp_get_prio_stats(esp_prio_t prio, esp_prio_stats_t* stats);
+#endif /* ESP_CFG_PRODUCER_PRIO || __DOXYGEN__ */
+
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+espr_t      esp_set_cmd_evt_fn(esp_cmd_evt_fn fn, void* arg);
+#if ESP_CFG_DNS || __DOXYGEN__
+espr_t      esp_dns_getbyhostname_ex(const char* host, void* ip, esp_cmd_evt_fn evt_fn, void* evt_arg);
+#endif /* ESP_CFG_DNS || __DOXYGEN__ */
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
+
+#if ESP_CFG_CMD_COALESCE || __DOXYGEN__
+uint32_t    esp_get_coalesced_count(void);
+#endif /* ESP_CFG_CMD_COALESCE || __DOXYGEN__ */
+
 /**
  * \}
  */
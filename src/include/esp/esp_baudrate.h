@@ -0,0 +1,86 @@
+/**	
+ * \file            esp_baudrate.h
+ * \brief           AT port baudrate negotiation API
+ */
+ 
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *  
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef __ESP_BAUDRATE_H
+#define __ESP_BAUDRATE_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp.h"
+
+/**
+ * \addtogroup      ESP
+ * \{
+ */
+    
+/**
+ * \defgroup        ESP_BAUDRATE AT port baudrate
+ * \brief           Find the highest working baudrate of AT port
+ * \{
+ */
+
+/**
+ * \brief           Number of baudrates in default candidate list
+ * \sa              esp_baudrate_negotiate
+ */
+#define ESP_BAUDRATE_DEFAULT_COUNT          7
+
+/**
+ * \brief           Result of single negotiation step
+ */
+typedef struct {
+    uint32_t baudrate;                          /*!< Tested baudrate, `0` if step was not executed */
+    espr_t res;                                 /*!< \ref espOK when all round trips succeeded, member of \ref espr_t otherwise */
+    uint32_t bytes_per_sec;                     /*!< Effective throughput of AT port measured with round trips */
+} esp_baudrate_step_t;
+
+espr_t      esp_baudrate_negotiate(const uint32_t* bauds, size_t count, esp_baudrate_step_t* steps, uint32_t* baudrate);
+espr_t      esp_baudrate_check(uint32_t* bytes_per_sec);
+uint32_t    esp_baudrate_get(void);
+ 
+/**
+ * \}
+ */
+    
+/**
+ * \}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ESP_BAUDRATE_H */
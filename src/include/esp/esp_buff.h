@@ -40,9 +40,44 @@ extern "C" {
 
 #include "stdint.h"
 #include "string.h"
-    
+
+/**
+ * \brief           Load buffer pointer written by other side with acquire semantics
+ *
+ *                  Data written before other side stored pointer are visible after this load.
+ *                  Define before including this file for compilers without GCC atomic built-in functions
+ */
+#ifndef ESP_BUFF_LOAD
+#if defined(__GNUC__) || defined(__clang__)
+#define ESP_BUFF_LOAD(var)              __atomic_load_n(&(var), __ATOMIC_ACQUIRE)
+#else
+#define ESP_BUFF_LOAD(var)              (*(volatile size_t *)&(var))
+#endif
+#endif /* ESP_BUFF_LOAD */
+
+/**
+ * \brief           Store buffer pointer for other side with release semantics
+ *
+ *                  All data accesses before store are completed before other side sees new pointer value
+ */
+#ifndef ESP_BUFF_STORE
+#if defined(__GNUC__) || defined(__clang__)
+#define ESP_BUFF_STORE(var, val)        __atomic_store_n(&(var), (val), __ATOMIC_RELEASE)
+#else
+#define ESP_BUFF_STORE(var, val)        (*(volatile size_t *)&(var) = (val))
+#endif
+#endif /* ESP_BUFF_STORE */
+
 /**
  * \brief           Buffer structure
+ *
+ *                  Buffer is lock-free for single producer and single consumer.
+ *                  Producer (interrupt, DMA or reader thread) only modifies `in` pointer
+ *                  with \ref esp_buff_write or \ref esp_buff_advance
+ *                  and consumer (processing thread) only modifies `out` pointer
+ *                  with \ref esp_buff_read or \ref esp_buff_skip.
+ *                  Other functions may be used by both sides,
+ *                  except \ref esp_buff_reset which requires both sides to be stopped
  */
 typedef struct esp_buff {
 	size_t size;                                /*!< Size of buffer in units of bytes */
@@ -63,6 +98,9 @@ size_t      esp_buff_peek(esp_buff_t* buff, size_t skip_count, void* data, size_
 void *      esp_buff_get_linear_block_address(esp_buff_t* buff);
 size_t      esp_buff_get_linear_block_length(esp_buff_t* buff);
 size_t      esp_buff_skip(esp_buff_t* buff, size_t len);
+void *      esp_buff_get_linear_block_write_address(esp_buff_t* buff);
+size_t      esp_buff_get_linear_block_write_length(esp_buff_t* buff);
+size_t      esp_buff_advance(esp_buff_t* buff, size_t len);
 
 /* C++ detection */
 #ifdef __cplusplus
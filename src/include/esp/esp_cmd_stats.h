@@ -0,0 +1,107 @@
+/**	
+ * \file            esp_cmd_stats.h
+ * \brief           Command latency statistics and tracing
+ */
+ 
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *  
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef __ESP_CMD_STATS_H
+#define __ESP_CMD_STATS_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp.h"
+
+/**
+ * \addtogroup      ESP
+ * \{
+ */
+    
+/**
+ * \defgroup        ESP_CMD_STATS Command statistics
+ * \brief           Latency histograms and trace of AT commands
+ * \{
+ *
+ * Commands are identified by number of API command,
+ * its name is returned by \ref esp_cmd_stats_name.
+ * Each command is timestamped when it is put to producer queue,
+ * when it is started, when first byte is received from device while command is active
+ * and when it is finished. Time from start to finish is execution time of AT command.
+ */
+
+/**
+ * \brief           Statistics of single command
+ * \sa              esp_cmd_stats_get
+ */
+typedef struct {
+    uint32_t count;                             /*!< Number of finished commands */
+    uint32_t errors;                            /*!< Number of commands finished with error, timeouts excluded */
+    uint32_t timeouts;                          /*!< Number of commands finished with \ref espTIMEOUT */
+    uint32_t queue_avg;                         /*!< Average time in producer queue before start, in units of milliseconds */
+    uint32_t first_avg;                         /*!< Average time from start to first response byte, in units of milliseconds */
+    uint32_t exec_avg;                          /*!< Average execution time, in units of milliseconds */
+    uint32_t exec_max;                          /*!< Maximal execution time, in units of milliseconds */
+    uint32_t hist[ESP_CFG_CMD_STATS_BUCKETS];   /*!< Log2 histogram of execution time, see \ref ESP_CFG_CMD_STATS_BUCKETS */
+} esp_cmd_stats_t;
+
+/**
+ * \brief           Trace entry of finished command
+ * \sa              esp_cmd_stats_trace
+ */
+typedef struct {
+    uint16_t cmd;                               /*!< Command number */
+    espr_t res;                                 /*!< Result of command */
+    uint32_t t_enqueue;                         /*!< Time when command was put to producer queue */
+    uint32_t t_start;                           /*!< Time when command was started */
+    uint32_t t_first;                           /*!< Time when first response byte was received, equal to `t_end` when there was no response */
+    uint32_t t_end;                             /*!< Time when command was finished */
+} esp_cmd_trace_t;
+
+const char* esp_cmd_stats_name(uint16_t cmd);
+espr_t      esp_cmd_stats_get(uint16_t cmd, esp_cmd_stats_t* stats);
+void        esp_cmd_stats_reset(void);
+size_t      esp_cmd_stats_trace(esp_cmd_trace_t* trace, size_t len);
+size_t      esp_cmd_stats_dump(char* buff, size_t len);
+ 
+/**
+ * \}
+ */
+    
+/**
+ * \}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ESP_CMD_STATS_H */
@@ -68,9 +68,70 @@
 #define ESP_CFG_MEM_ALIGNMENT               4
 #endif
 
+/**
+ * \brief           Enables (1) or disables (0) slab allocator for small memory blocks
+ *
+ *                  Fixed number of blocks for each size class is taken from memory regions
+ *                  when \ref esp_mem_assignmemory is called. Small allocations,
+ *                  such as messages, timeouts and packet buffer headers, are then served
+ *                  from per class free lists in constant time instead of first-fit search in heap.
+ *
+ * \note            Size classes are powers of 2, starting with \ref ESP_CFG_MEM_SLAB_MIN_SIZE
+ */
+#ifndef ESP_CFG_MEM_SLAB
+#define ESP_CFG_MEM_SLAB                    0
+#endif
+
+/**
+ * \brief           Block size of smallest slab class in units of bytes
+ *
+ * \note            Value must be power of 2 and at least \ref ESP_CFG_MEM_ALIGNMENT
+ */
+#ifndef ESP_CFG_MEM_SLAB_MIN_SIZE
+#define ESP_CFG_MEM_SLAB_MIN_SIZE           32
+#endif
+
+/**
+ * \brief           Number of slab size classes
+ */
+#ifndef ESP_CFG_MEM_SLAB_CLASSES
+#define ESP_CFG_MEM_SLAB_CLASSES            4
+#endif
+
+/**
+ * \brief           Number of blocks in each slab size class
+ */
+#ifndef ESP_CFG_MEM_SLAB_BLOCKS
+#define ESP_CFG_MEM_SLAB_BLOCKS             8
+#endif
+
+/**
+ * \brief           Enables (1) or disables (0) pool of preallocated messages for API functions
+ *
+ *                  When enabled, \ref ESP_CFG_MSG_POOL_SIZE messages are allocated once at stack init,
+ *                  each with its own semaphore for blocking calls.
+ *                  API functions then take message from pool in constant time
+ *                  and do not create semaphore on every blocking call.
+ *                  When pool is empty, heap is used as fallback
+ *
+ * \sa              esp_mem_msg_pool_get_stats
+ */
+#ifndef ESP_CFG_MSG_POOL
+#define ESP_CFG_MSG_POOL                    0
+#endif
+
+/**
+ * \brief           Number of messages in message pool
+ */
+#ifndef ESP_CFG_MSG_POOL_SIZE
+#define ESP_CFG_MSG_POOL_SIZE               8
+#endif
+
 /**
  * \brief           Maximal number of connections AT software can support on ESP device
  * \note            In case of official AT software, leave this on default value (5)
+ *
+ * \note            Connections are tracked with bitmap, any value from `1` to `127` is supported
  */
 #ifndef ESP_CFG_MAX_CONNS
 #define ESP_CFG_MAX_CONNS                   5
@@ -98,6 +159,130 @@
 #define ESP_CFG_MAX_SEND_RETRIES            3
 #endif
 
+/**
+ * \brief           Enables (1) or disables (0) buffered send with `AT+CIPSENDBUF` for TCP connections
+ *
+ *                  Instead of waiting for `SEND OK` after every chunk of data,
+ *                  next chunk is written as soon as device accepts previous one to its TCP send buffer.
+ *                  Data sent event and blocking send function finish when all data are accepted by device.
+ *                  `SEND FAIL` of buffered segment is reported later with \ref ESP_CB_CONN_DATA_SEND_ERR event
+ *
+ * \note            AT firmware must support `AT+CIPSENDBUF` command
+ */
+#ifndef ESP_CFG_CONN_SENDBUF
+#define ESP_CFG_CONN_SENDBUF                0
+#endif
+
+/**
+ * \brief           Maximal number of segments per connection waiting for `SEND OK` in buffered send mode
+ *
+ * \note            This parameter has no meaning when \ref ESP_CFG_CONN_SENDBUF is disabled
+ */
+#ifndef ESP_CFG_CONN_SENDBUF_SEGMENTS
+#define ESP_CFG_CONN_SENDBUF_SEGMENTS       4
+#endif
+
+/**
+ * \brief           Enables (1) or disables (0) send scheduler between connections
+ *
+ *                  Send commands are kept in per connection queues and producer thread
+ *                  sends one chunk of \ref ESP_CFG_CONN_MAX_DATA_LEN bytes at a time,
+ *                  switching between connections in round-robin order.
+ *                  Large send on one connection does not block other connections and other commands anymore
+ *
+ * \note            Other commands are executed between chunks, before any waiting data.
+ *                  Connection close command waits for data queued on the same connection
+ */
+#ifndef ESP_CFG_CONN_SEND_SCHED
+#define ESP_CFG_CONN_SEND_SCHED             0
+#endif
+
+/**
+ * \brief           Enables (1) or disables (0) priority lanes in producer thread
+ *
+ *                  Messages from API functions are sorted to control and data lane
+ *                  as soon as they leave producer message queue.
+ *                  Control commands, like connection close, status check or Wi-Fi commands,
+ *                  are executed before data sends waiting in data lane
+ *
+ * \note            Connection close command waits for data queued on the same connection
+ * \sa              ESP_CFG_PRODUCER_CONTROL_BURST, esp_get_prio_stats
+ */
+#ifndef ESP_CFG_PRODUCER_PRIO
+#define ESP_CFG_PRODUCER_PRIO               0
+#endif
+
+/**
+ * \brief           Maximal number of control commands executed in a row while data lane is waiting
+ *
+ *                  After this number of commands, one data command is executed
+ *                  to make sure data lane is not starved by stream of control commands
+ *
+ * \note            Used only when \ref ESP_CFG_PRODUCER_PRIO is enabled
+ */
+#ifndef ESP_CFG_PRODUCER_CONTROL_BURST
+#define ESP_CFG_PRODUCER_CONTROL_BURST      8
+#endif
+
+/**
+ * \brief           Enables (1) or disables (0) completion callbacks of non-blocking commands
+ *
+ *                  Callback is passed to `_ex` API functions or set with \ref esp_set_cmd_evt_fn
+ *                  for next non-blocking command and called from producer thread with final result of command
+ */
+#ifndef ESP_CFG_CMD_EVT
+#define ESP_CFG_CMD_EVT                     0
+#endif
+
+/**
+ * \brief           Enables (1) or disables (0) coalescing of the same queries
+ *
+ *                  When query command (connection status, current IP or MAC address, list of access points)
+ *                  is requested while the same query is already queued or executing,
+ *                  new request waits for result of existing one instead of sending another AT command
+ *
+ * \sa              esp_get_coalesced_count
+ */
+#ifndef ESP_CFG_CMD_COALESCE
+#define ESP_CFG_CMD_COALESCE                0
+#endif
+
+/**
+ * \brief           Enables (1) or disables (0) per-command latency statistics and tracing
+ *
+ *                  Every command is timestamped when queued, started, when first response byte
+ *                  is received and when finished. Execution times are collected
+ *                  to log2 histogram per command, last commands are kept in trace buffer
+ *
+ * \sa              ESP_CMD_STATS
+ */
+#ifndef ESP_CFG_CMD_STATS
+#define ESP_CFG_CMD_STATS                   0
+#endif
+
+/**
+ * \brief           Number of buckets in command execution time histogram
+ *
+ *                  Bucket `0` counts commands finished within `1` millisecond,
+ *                  bucket `n` counts commands finished within `2^(n-1)` to `2^n - 1` milliseconds.
+ *                  Last bucket counts all longer commands
+ *
+ * \note            This parameter has no meaning when \ref ESP_CFG_CMD_STATS is disabled
+ */
+#ifndef ESP_CFG_CMD_STATS_BUCKETS
+#define ESP_CFG_CMD_STATS_BUCKETS           16
+#endif
+
+/**
+ * \brief           Number of last finished commands kept in trace buffer
+ *
+ * \note            Set to `0` to disable tracing and keep only statistics
+ * \note            This parameter has no meaning when \ref ESP_CFG_CMD_STATS is disabled
+ */
+#ifndef ESP_CFG_CMD_STATS_TRACE_LEN
+#define ESP_CFG_CMD_STATS_TRACE_LEN         16
+#endif
+
 /**
  * \brief           Maximal buffer size for entries in +IPD statement from ESP
  * \note            If +IPD length is larger that this value, 
@@ -107,6 +292,93 @@
 #define ESP_CFG_IPD_MAX_BUFF_SIZE           1460
 #endif
 
+/**
+ * \brief           Enables (1) or disables (0) pool of preallocated packet buffers for received data
+ *
+ *                  When enabled, \ref ESP_CFG_PBUF_POOL_SIZE packet buffers are allocated once at stack init
+ *                  and +IPD data are received to them in constant time instead of allocation from heap.
+ *                  When pool is empty, heap is used as fallback
+ *
+ * \sa              esp_pbuf_pool_get_stats
+ */
+#ifndef ESP_CFG_PBUF_POOL
+#define ESP_CFG_PBUF_POOL                   0
+#endif
+
+/**
+ * \brief           Number of packet buffers in receive pool
+ */
+#ifndef ESP_CFG_PBUF_POOL_SIZE
+#define ESP_CFG_PBUF_POOL_SIZE              8
+#endif
+
+/**
+ * \brief           Payload size of packet buffer in receive pool in units of bytes
+ *
+ * \note            Value should not be smaller than \ref ESP_CFG_IPD_MAX_BUFF_SIZE,
+ *                  otherwise received data are always stored to packet buffers from heap
+ */
+#ifndef ESP_CFG_PBUF_POOL_BUFF_SIZE
+#define ESP_CFG_PBUF_POOL_BUFF_SIZE         ESP_CFG_IPD_MAX_BUFF_SIZE
+#endif
+
+/**
+ * \brief           Enables (1) or disables (0) passive receive mode for TCP connections
+ *
+ *                  Device keeps received data in its own buffer and only reports their length with `+IPD`.
+ *                  Stack reads data with `AT+CIPRECVDATA` only when there is space in receive window of connection,
+ *                  so slow application gives backpressure to remote side instead of losing data
+ *
+ * \note            Application must confirm every received packet buffer with \ref esp_conn_recved,
+ *                  otherwise no more data are read once receive window is full
+ * \note            When \ref ESP_CFG_PBUF_POOL is enabled, data are also read only when receive pool
+ *                  has free packet buffer, as sum of receive windows of all connections may exceed pool size
+ */
+#ifndef ESP_CFG_CONN_RECV_PASSIVE
+#define ESP_CFG_CONN_RECV_PASSIVE           0
+#endif
+
+/**
+ * \brief           Receive window of connection in units of bytes
+ *
+ *                  Maximal number of bytes read from device and not yet confirmed by application with \ref esp_conn_recved
+ *
+ * \note            This parameter has no meaning when \ref ESP_CFG_CONN_RECV_PASSIVE is disabled
+ */
+#ifndef ESP_CFG_CONN_RECV_WINDOW
+#define ESP_CFG_CONN_RECV_WINDOW            (4 * ESP_CFG_IPD_MAX_BUFF_SIZE)
+#endif
+
+/**
+ * \brief           Enables (1) or disables (0) zero-copy receive of +IPD data
+ *
+ *                  When enabled, packet buffers for received network data
+ *                  reference memory of input buffer directly instead of copying data.
+ *                  Input buffer memory is released when last reference to packet buffer is freed
+ *
+ * \note            \ref ESP_CFG_RCV_BUFF_SIZE must be few times bigger than \ref ESP_CFG_IPD_MAX_BUFF_SIZE.
+ *                  Data which are not linear in input buffer are copied to new packet buffer as usual
+ *
+ * \note            Received packet buffers must be freed by application as soon as possible.
+ *                  Input buffer can not accept new data until memory of oldest packet buffer is released
+ *
+ * \note            This mode can only be used when \ref ESP_CFG_INPUT_USE_PROCESS is disabled
+ */
+#ifndef ESP_CFG_IPD_ZERO_COPY
+#define ESP_CFG_IPD_ZERO_COPY               0
+#endif
+
+/**
+ * \brief           Maximal number of packet buffers referencing input buffer at the same time
+ *
+ *                  When all are in use, new data are copied to new packet buffer
+ *
+ * \note            This parameter has no meaning when \ref ESP_CFG_IPD_ZERO_COPY is disabled
+ */
+#ifndef ESP_CFG_IPD_ZERO_COPY_HOLDS
+#define ESP_CFG_IPD_ZERO_COPY_HOLDS         8
+#endif
+
 /**
  * \brief           Default baudrate used for AT port
  *
@@ -116,6 +388,38 @@
 #define ESP_CFG_AT_PORT_BAUDRATE            115200
 #endif
 
+/**
+ * \brief           Enables (1) or disables (0) AT port baudrate negotiation
+ *
+ *                  Stack steps through candidate baudrates and verifies
+ *                  each one with payload round trips before it is used
+ *
+ * \sa              ESP_BAUDRATE
+ */
+#ifndef ESP_CFG_AT_BAUDRATE_NEGOTIATE
+#define ESP_CFG_AT_BAUDRATE_NEGOTIATE       0
+#endif
+
+/**
+ * \brief           Length of payload in units of bytes sent in single round trip when AT port baudrate is verified
+ *
+ * \note            Payload is sent as part of command line and echoed back,
+ *                  whole line must fit to `128` bytes long buffer for received lines, therefore maximal value is `112`
+ * \note            This parameter has no meaning when \ref ESP_CFG_AT_BAUDRATE_NEGOTIATE is disabled
+ */
+#ifndef ESP_CFG_AT_BAUDRATE_CHECK_LEN
+#define ESP_CFG_AT_BAUDRATE_CHECK_LEN       96
+#endif
+
+/**
+ * \brief           Number of payload round trips when AT port baudrate is verified
+ *
+ * \note            This parameter has no meaning when \ref ESP_CFG_AT_BAUDRATE_NEGOTIATE is disabled
+ */
+#ifndef ESP_CFG_AT_BAUDRATE_CHECK_ROUNDS
+#define ESP_CFG_AT_BAUDRATE_CHECK_ROUNDS    32
+#endif
+
 /**
  * \brief           Enables (1) or disables (1) ESP acting as station
  * 
@@ -149,6 +453,19 @@
 #define ESP_CFG_RCV_BUFF_SIZE               0x400
 #endif
 
+/**
+ * \brief           Buffer size for AT command being transmitted to device
+ *
+ *                  Command is formatted to this buffer and sent to device
+ *                  with single call to low-level send function, instead of
+ *                  calling it for every part of command separately.
+ *
+ * \note            Set to `0` to disable buffer and send every part directly
+ */
+#ifndef ESP_CFG_AT_PORT_TX_BUFF_SIZE
+#define ESP_CFG_AT_PORT_TX_BUFF_SIZE        0
+#endif
+
 /**
  * \defgroup        ESP_CONF_DBG Debugging
  * \brief           Debugging configurations
@@ -318,7 +635,20 @@
 #ifndef ESP_CFG_INPUT_USE_PROCESS
 #define ESP_CFG_INPUT_USE_PROCESS           0
 #endif
- 
+
+/**
+ * \brief           Enables (1) or disables (0) POSIX (pthreads) system port types
+ *
+ *                  When enabled, system types in \ref ESP_SYS are defined for
+ *                  `esp_sys_posix.c` port instead of CMSIS-OS.
+ *                  Use it to run the stack on Linux or other POSIX host
+ *
+ * \note            This mode can only be used when \ref ESP_CFG_OS is enabled
+ */
+#ifndef ESP_CFG_SYS_PORT_POSIX
+#define ESP_CFG_SYS_PORT_POSIX              0
+#endif
+
 /**
  * \}
  */
@@ -384,6 +714,27 @@
 #define ESP_CFG_SNTP                        0
 #endif
 
+/**
+ * \brief           Enables (1) or disables (0) support for transparent (passthrough) transmission mode
+ *
+ *                  Single TCP or SSL connection exchanges raw data with application
+ *                  without `AT+CIPSEND` command, prompt and `SEND OK` for every packet
+ *
+ * \sa              ESP_TRANSPARENT
+ */
+#ifndef ESP_CFG_TRANSPARENT
+#define ESP_CFG_TRANSPARENT                 0
+#endif
+
+/**
+ * \brief           Time in units of milliseconds without data on AT port before and after `+++` escape sequence
+ *
+ * \note            This parameter has no meaning when \ref ESP_CFG_TRANSPARENT is disabled
+ */
+#ifndef ESP_CFG_TRANSPARENT_GUARD_TIME
+#define ESP_CFG_TRANSPARENT_GUARD_TIME      1000
+#endif
+
 /**
  * \brief           Enables (1) or disables (0) support for SNTP protocol with AT commands
  *
@@ -407,6 +758,29 @@
 #define ESP_CFG_CONN_POLL_INTERVAL          500
 #endif
 
+/**
+ * \brief           Number of slots in each level of timeout wheel, as power of 2
+ *
+ *                  Timeouts are kept in hierarchical timing wheel with resolution of 1 millisecond.
+ *                  Each level has `2^ESP_CFG_TIMEOUT_WHEEL_BITS` slots and covers
+ *                  `2^ESP_CFG_TIMEOUT_WHEEL_BITS` times longer time than level below.
+ *
+ * \note            `ESP_CFG_TIMEOUT_WHEEL_BITS * ESP_CFG_TIMEOUT_WHEEL_LEVELS` must be less than `32`
+ */
+#ifndef ESP_CFG_TIMEOUT_WHEEL_BITS
+#define ESP_CFG_TIMEOUT_WHEEL_BITS          6
+#endif
+
+/**
+ * \brief           Number of levels in timeout wheel
+ *
+ *                  Timeouts longer than wheel range (`2^24` ms with default values) are
+ *                  moved through top level again until they expire
+ */
+#ifndef ESP_CFG_TIMEOUT_WHEEL_LEVELS
+#define ESP_CFG_TIMEOUT_WHEEL_LEVELS        4
+#endif
+
 /**
  * \}
  */
@@ -421,12 +795,24 @@
 #error "Invalid ESP configuration. ESP_CFG_MODE_STATION and ESP_CFG_MODE_STATION cannot be disabled at the same time!"
 #endif
 
+#if ESP_CFG_TIMEOUT_WHEEL_BITS * ESP_CFG_TIMEOUT_WHEEL_LEVELS >= 32
+#error "Invalid ESP configuration. Timeout wheel range must fit to 32-bit time!"
+#endif
+
 #if !ESP_CFG_OS
     #if ESP_CFG_INPUT_USE_PROCESS
     #error "ESP_CFG_INPUT_USE_PROCESS may only be enabled when OS is used"
     #endif /* ESP_CFG_INPUT_USE_PROCESS */
 #endif /* !ESP_CFG_OS */
 
+#if ESP_CFG_IPD_ZERO_COPY && ESP_CFG_INPUT_USE_PROCESS
+#error "ESP_CFG_IPD_ZERO_COPY may only be enabled when ESP_CFG_INPUT_USE_PROCESS is disabled"
+#endif /* ESP_CFG_IPD_ZERO_COPY && ESP_CFG_INPUT_USE_PROCESS */
+
+#if ESP_CFG_MAX_CONNS < 1 || ESP_CFG_MAX_CONNS > 127
+#error "Invalid ESP configuration. ESP_CFG_MAX_CONNS must be between 1 and 127!"
+#endif
+
 #endif /* !__DOXYGEN__ */
 
 #endif /* __ESP_DEFAULT_CONFIG_H */
@@ -54,7 +54,11 @@ extern "C" {
 espr_t      esp_conn_start(esp_conn_p* conn, esp_conn_type_t type, const char* host, uint16_t port, void* arg, esp_cb_fn cb_func, uint32_t blocking);
 espr_t      esp_conn_close(esp_conn_p conn, uint32_t blocking);
 espr_t      esp_conn_send(esp_conn_p conn, const void* data, size_t btw, size_t* bw, uint32_t blocking);
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+espr_t      esp_conn_send_ex(esp_conn_p conn, const void* data, size_t btw, size_t* bw, esp_cmd_evt_fn evt_fn, void* evt_arg);
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
 espr_t      esp_conn_sendto(esp_conn_p conn, const void* ip, uint16_t port, const void* data, size_t btw, size_t* bw, uint32_t blocking);
+espr_t      esp_conn_send_pbuf(esp_conn_p conn, esp_pbuf_p pbuf, size_t* bw, uint32_t blocking);
 espr_t      esp_conn_set_arg(esp_conn_p conn, void* arg);
 void *      esp_conn_get_arg(esp_conn_p conn);
 uint8_t     esp_conn_is_client(esp_conn_p conn);
@@ -67,6 +71,9 @@ espr_t      esp_get_conns_status(uint32_t blocking);
 esp_conn_p  esp_conn_get_from_evt(esp_cb_t* evt);
 espr_t      esp_conn_write(esp_conn_p conn, const void* data, size_t btw, uint8_t flush, size_t* mem_available);
 espr_t      esp_conn_recved(esp_conn_p conn, esp_pbuf_p pbuf);
+#if ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__
+espr_t      esp_conn_get_send_stats(esp_conn_p conn, esp_conn_send_stats_t* stats);
+#endif /* ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__ */
  
 /**
  * \}
@@ -52,6 +52,8 @@ extern "C" {
  */
 
 espr_t      esp_input(const void* data, size_t len);
+void*       esp_input_reserve(size_t* len);
+espr_t      esp_input_commit(size_t len);
 espr_t      esp_input_process(const void* data, size_t len);
 
 /**
@@ -64,6 +64,35 @@ typedef struct mem_region_t {
  */
 typedef mem_region_t esp_mem_region_t;
 
+#if ESP_CFG_MEM_SLAB || __DOXYGEN__
+/**
+ * \brief           Statistics of single slab size class
+ * \sa              esp_mem_slab_get_stats
+ */
+typedef struct {
+    size_t size;                        /*!< Block size of class in units of bytes */
+    size_t blocks;                      /*!< Number of blocks in class */
+    size_t used;                        /*!< Number of blocks currently in use */
+    size_t max_used;                    /*!< Maximal number of blocks ever used at the same time */
+    uint32_t allocs;                    /*!< Number of allocations served by class */
+    uint32_t misses;                    /*!< Number of allocations of class size served by heap because class was empty */
+} esp_mem_slab_stats_t;
+#endif /* ESP_CFG_MEM_SLAB || __DOXYGEN__ */
+
+#if ESP_CFG_MSG_POOL || __DOXYGEN__
+/**
+ * \brief           Statistics of message pool
+ * \sa              esp_mem_msg_pool_get_stats
+ */
+typedef struct {
+    size_t msgs;                        /*!< Number of messages in pool */
+    size_t used;                        /*!< Number of messages currently in use */
+    size_t max_used;                    /*!< Maximal number of messages ever used at the same time */
+    uint32_t allocs;                    /*!< Number of messages served by pool */
+    uint32_t misses;                    /*!< Number of messages allocated from heap because pool was exhausted */
+} esp_mem_msg_pool_stats_t;
+#endif /* ESP_CFG_MSG_POOL || __DOXYGEN__ */
+
 void*   esp_mem_alloc(uint32_t size);
 void*   esp_mem_realloc(void* ptr, size_t size);
 void*   esp_mem_calloc(size_t num, size_t size);
@@ -73,6 +102,12 @@ size_t  esp_mem_getfull(void);
 size_t  esp_mem_getminfree(void);
 
 uint8_t esp_mem_assignmemory(const esp_mem_region_t* regions, size_t size);
+#if ESP_CFG_MEM_SLAB || __DOXYGEN__
+uint8_t esp_mem_slab_get_stats(size_t cls, esp_mem_slab_stats_t* stats);
+#endif /* ESP_CFG_MEM_SLAB || __DOXYGEN__ */
+#if ESP_CFG_MSG_POOL || __DOXYGEN__
+uint8_t esp_mem_msg_pool_get_stats(esp_mem_msg_pool_stats_t* stats);
+#endif /* ESP_CFG_MSG_POOL || __DOXYGEN__ */
     
 /**
  * \}
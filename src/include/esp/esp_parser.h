@@ -41,6 +41,9 @@ extern "C" {
 
 espr_t      espi_parse_cipstatus(const char* str);
 espr_t      espi_parse_ipd(const char* str);
+#if ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__
+espr_t      espi_parse_ciprecvdata(const char* str, esp_msg_t* msg);
+#endif /* ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__ */
     
 int32_t     espi_parse_number(const char** str);
 uint8_t     espi_parse_string(const char** src, char* dst, size_t dst_len, uint8_t trim);
@@ -50,7 +50,22 @@ extern "C" {
  * \brief           Packet buffer manager
  * \{
  */
-    
+
+#if ESP_CFG_PBUF_POOL || __DOXYGEN__
+/**
+ * \brief           Statistics of receive packet buffer pool
+ * \sa              esp_pbuf_pool_get_stats
+ */
+typedef struct {
+    size_t size;                                /*!< Payload size of single packet buffer in units of bytes */
+    size_t buffs;                               /*!< Number of packet buffers in pool */
+    size_t used;                                /*!< Number of packet buffers currently in use */
+    size_t max_used;                            /*!< Maximal number of packet buffers ever used at the same time (high-water mark) */
+    uint32_t allocs;                            /*!< Number of packet buffers served by pool */
+    uint32_t misses;                            /*!< Number of packet buffers allocated from heap because pool was exhausted */
+} esp_pbuf_pool_stats_t;
+#endif /* ESP_CFG_PBUF_POOL || __DOXYGEN__ */
+
 esp_pbuf_p      esp_pbuf_new(size_t len);
 uint16_t        esp_pbuf_free(esp_pbuf_p pbuf);
 const void *    esp_pbuf_data(const esp_pbuf_p pbuf);
@@ -67,6 +82,8 @@ size_t          esp_pbuf_memcmp(const esp_pbuf_p pbuf, const void* data, size_t
 size_t          esp_pbuf_strcmp(const esp_pbuf_p pbuf, const char* str, size_t offset);
 size_t          esp_pbuf_memfind(const esp_pbuf_p pbuf, const void* data, size_t len, size_t off);
 size_t          esp_pbuf_strfind(const esp_pbuf_p pbuf, const char* str, size_t off);
+size_t          esp_pbuf_memfind_nocase(const esp_pbuf_p pbuf, const void* data, size_t len, size_t off);
+size_t          esp_pbuf_strfind_nocase(const esp_pbuf_p pbuf, const char* str, size_t off);
 
 uint8_t         esp_pbuf_advance(esp_pbuf_p pbuf, int len);
 esp_pbuf_p      esp_pbuf_skip(esp_pbuf_p pbuf, size_t offset, size_t* new_offset);
@@ -74,6 +91,10 @@ esp_pbuf_p      esp_pbuf_skip(esp_pbuf_p pbuf, size_t offset, size_t* new_offset
 const void *    esp_pbuf_get_linear_addr(const esp_pbuf_p pbuf, size_t offset, size_t* new_len);
 
 void            esp_pbuf_set_ip(esp_pbuf_p pbuf, const void* ip, uint16_t port);
+
+#if ESP_CFG_PBUF_POOL || __DOXYGEN__
+uint8_t         esp_pbuf_pool_get_stats(esp_pbuf_pool_stats_t* stats);
+#endif /* ESP_CFG_PBUF_POOL || __DOXYGEN__ */
     
 /**
  * \}
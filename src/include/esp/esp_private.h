@@ -67,6 +67,10 @@ typedef enum {
     ESP_CMD_GSLP,                               /*!< Set ESP to sleep mode */
     ESP_CMD_RESTORE,                            /*!< Restore ESP internal settings to default values */
     ESP_CMD_UART,
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__
+    ESP_CMD_AT,                                 /*!< Test AT startup */
+    ESP_CMD_UART_CHECK,                         /*!< Payload round trip with echo to verify AT port baudrate */
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__ */
     ESP_CMD_SLEEP,
     ESP_CMD_WAKEUPGPIO,
     ESP_CMD_RFPOWER,
@@ -126,6 +130,11 @@ typedef enum {
     ESP_CMD_TCPIP_CIPSERVER,                    /*!< Enables/Disables server mode */
     ESP_CMD_TCPIP_CIPSERVERMAXCONN,             /*!< Sets maximal number of connections allowed for server population */
     ESP_CMD_TCPIP_CIPMODE,                      /*!< Transmission mode, either transparent or normal one */
+#if ESP_CFG_TRANSPARENT || __DOXYGEN__
+    ESP_CMD_TCPIP_CIPSTART_SINGLE,              /*!< Start connection in single connection mode */
+    ESP_CMD_TCPIP_CIPSEND_TRANSPARENT,          /*!< Start transparent data transmission */
+    ESP_CMD_TCPIP_CIPCLOSE_SINGLE,              /*!< Close connection in single connection mode */
+#endif /* ESP_CFG_TRANSPARENT || __DOXYGEN__ */
     ESP_CMD_TCPIP_CIPSTO,                       /*!< Sets connection timeout */
 #if ESP_CFG_PING || __DOXYGEN__
     ESP_CMD_TCPIP_PING,                         /*!< Ping domain */
@@ -137,6 +146,12 @@ typedef enum {
 #endif /* ESP_SNT || __DOXYGEN__ */
     ESP_CMD_TCPIP_CIPDNS,                       /*!< Configure user specific DNS servers */
     ESP_CMD_TCPIP_CIPDINFO,                     /*!< Configure what data are received on +IPD statement */
+#if ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__
+    ESP_CMD_TCPIP_CIPRECVMODE,                  /*!< Set active or passive receive mode */
+    ESP_CMD_TCPIP_CIPRECVDATA,                  /*!< Read data held by device in passive receive mode */
+#endif /* ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__ */
+
+    ESP_CMD_END,                                /*!< Last command entry, used for array sizes */
 } esp_cmd_t;
 
 /**
@@ -159,6 +174,22 @@ typedef struct esp_conn_t {
     size_t          buff_len;                   /*!< Total length of buffer */
     size_t          buff_ptr;                   /*!< Current write pointer of buffer */
     
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+    uint16_t        seg_id;                     /*!< ID of last segment written to device send buffer */
+    uint16_t        seg_id_ok;                  /*!< ID of last segment finished with `SEND OK` or `SEND FAIL` */
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
+#if ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__
+    size_t          recv_avail;                 /*!< Number of bytes held by device, reported with `+IPD` */
+    size_t          recv_unacked;               /*!< Number of bytes given to application and not yet confirmed with \ref esp_conn_recved */
+    uint8_t         recv_queued;                /*!< Set to 1 when `AT+CIPRECVDATA` command is waiting in queue or in progress */
+    uint8_t         recv_retry;                 /*!< Set to 1 when read could not be queued or timed out, it is retried from connection poll */
+#endif /* ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__ */
+#if ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__
+    uint32_t        send_chunks;                /*!< Number of data chunks scheduled on connection */
+    uint32_t        send_wait_total;            /*!< Sum of times chunks waited for their turn, in units of milliseconds */
+    uint32_t        send_wait_max;              /*!< Maximal time chunk waited for its turn, in units of milliseconds */
+#endif /* ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__ */
+    
     union {
         struct {
             uint8_t active:1;                   /*!< Status whether connection is active */
@@ -179,6 +210,10 @@ typedef struct esp_pbuf_t {
     uint8_t* payload;                           /*!< Pointer to payload memory */
     uint8_t ip[4];                              /*!< Remote address for received IPD data */
     uint16_t port;                              /*!< Remote port for received IPD data */
+#if ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+    uint8_t rx_hold;                            /*!< Input buffer hold number plus 1 when payload
+                                                    points to input buffer memory, `0` otherwise */
+#endif /* ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
 } esp_pbuf_t;
 
 /**
@@ -208,10 +243,53 @@ typedef struct esp_msg {
     uint32_t        block_time;                 /*!< Maximal blocking time in units of milliseconds. Use 0 to for non-blocking call */
     espr_t          res;                        /*!< Result of message operation */
     espr_t          (*fn)(struct esp_msg *);    /*!< Processing callback function to process packet */
+    uint16_t        send_calls;                 /*!< Number of low-level send function calls used for this message */
+    uint8_t         finished;                   /*!< Set to 1 when producer finished blocking message and released its semaphore */
+#if ESP_CFG_MSG_POOL || __DOXYGEN__
+    uint8_t         pooled;                     /*!< Message is from pool and its semaphore is reused */
+#endif /* ESP_CFG_MSG_POOL || __DOXYGEN__ */
+#if ESP_CFG_CONN_SEND_SCHED || ESP_CFG_PRODUCER_PRIO || ESP_CFG_MSG_POOL || __DOXYGEN__
+    struct esp_msg* next;                       /*!< Next message in connection send queue, priority lane or free list of pool */
+#endif /* ESP_CFG_CONN_SEND_SCHED || ESP_CFG_PRODUCER_PRIO || ESP_CFG_MSG_POOL || __DOXYGEN__ */
+#if ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__
+    uint32_t        sched_time;                 /*!< Time when message was put to connection send queue */
+#endif /* ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__ */
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+    esp_cmd_evt_fn  evt_fn;                     /*!< Function called when non-blocking command finishes */
+    void*           evt_arg;                    /*!< Custom user argument for completion function */
+    uint8_t         evt_set;                    /*!< Completion function was set by API function or message is internal,
+                                                        function set with \ref esp_set_cmd_evt_fn is not attached to it */
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
+#if ESP_CFG_CMD_COALESCE || __DOXYGEN__
+    struct esp_msg* co_next;                    /*!< Next query in list of queued queries or next waiter for the same query */
+    struct esp_msg* co_waiters;                 /*!< Messages waiting for result of this query */
+#endif /* ESP_CFG_CMD_COALESCE || __DOXYGEN__ */
+#if ESP_CFG_PRODUCER_PRIO || __DOXYGEN__
+    uint32_t        queue_time;                 /*!< Time when message was put to producer message queue */
+    esp_prio_t      prio;                       /*!< Priority lane of message */
+    uint8_t         prio_started;               /*!< Set to 1 when execution started and wait time was counted */
+#endif /* ESP_CFG_PRODUCER_PRIO || __DOXYGEN__ */
+#if ESP_CFG_CMD_STATS || __DOXYGEN__
+    uint32_t        t_enqueue;                  /*!< Time when message was put to producer message queue */
+    uint32_t        t_start;                    /*!< Time when processing function was called first time */
+    uint32_t        t_first;                    /*!< Time when first response byte was received */
+    uint8_t         t_started;                  /*!< Set to 1 when `t_start` is valid */
+    uint8_t         t_resp;                     /*!< Set to 1 when `t_first` is valid */
+#endif /* ESP_CFG_CMD_STATS || __DOXYGEN__ */
     union {
         struct {
             uint32_t baudrate;                  /*!< Baudrate for AT port */
         } uart;
+#if ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__
+        struct {
+            size_t rounds;                      /*!< Number of payload round trips */
+            size_t round;                       /*!< Current round trip */
+            uint16_t chk;                       /*!< Checksum of payload sent in current round trip */
+            uint8_t echo_ok;                    /*!< Set to `1` when echoed payload matches sent one */
+            uint32_t time;                      /*!< Time when first payload was sent */
+            uint32_t* bytes_per_sec;            /*!< Pointer to output variable for measured throughput */
+        } uart_check;                           /*!< Verify AT port with payload echo */
+#endif /* ESP_CFG_AT_BAUDRATE_NEGOTIATE || __DOXYGEN__ */
         struct {
             esp_mode_t mode;                    /*!< Mode of operation */                    
         } wifi_mode;                            /*!< When message type \ref ESP_CMD_WIFI_CWMODE is used */
@@ -290,6 +368,7 @@ typedef struct esp_msg {
             size_t btw;                         /*!< Number of remaining bytes to write */
             size_t ptr;                         /*!< Current write pointer for data */
             const uint8_t* data;                /*!< Data to send */
+            esp_pbuf_p pbuf;                    /*!< Packet buffer chain to send instead of linear data */
             size_t sent;                        /*!< Number of bytes sent in last packet */
             size_t sent_all;                    /*!< Number of bytes sent all together */
             uint8_t tries;                      /*!< Number of tries used for last packet */
@@ -299,7 +378,32 @@ typedef struct esp_msg {
             uint8_t fau;                        /*!< Free after use flag to free memory after data are sent (or not) */
             size_t* bw;                         /*!< Number of bytes written so far */
             uint8_t val_id;                     /*!< Connection current validation ID when command was sent to queue */
+#if ESP_CFG_CONN_SENDBUF || __DOXYGEN__
+            uint8_t buffered;                   /*!< Set to 1 when data are written with `AT+CIPSENDBUF` */
+            uint8_t wait_seg;                   /*!< Set to 1 when waiting for `SEND OK` of older segment before next write */
+#endif /* ESP_CFG_CONN_SENDBUF || __DOXYGEN__ */
+#if ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__
+            uint8_t yield;                      /*!< Set to 1 when chunk was sent and command yields to other connections */
+#endif /* ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__ */
         } conn_send;                            /*!< Structure to send data on connection */
+#if ESP_CFG_TRANSPARENT || __DOXYGEN__
+        struct {
+            uint8_t mode;                       /*!< Enter (1) or leave (0) transparent mode */
+            esp_conn_type_t type;               /*!< Connection type */
+            const char* host;                   /*!< Remote host */
+            uint16_t port;                      /*!< Remote port */
+            esp_transparent_recv_fn recv_fn;    /*!< Function to receive raw data */
+            void* arg;                          /*!< Custom argument for receive function */
+        } tcpip_mode;                           /*!< Transparent transmission mode */
+#endif /* ESP_CFG_TRANSPARENT || __DOXYGEN__ */
+#if ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__
+        struct {
+            esp_conn_t* conn;                   /*!< Pointer to connection to read data from */
+            size_t len;                         /*!< Number of bytes requested from device */
+            size_t read;                        /*!< Number of bytes returned by device */
+            uint8_t val_id;                     /*!< Connection current validation ID when command was sent to queue */
+        } conn_recv;                            /*!< Structure to read data in passive receive mode */
+#endif /* ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__ */
         
         /*
          * TCP/IP based commands
@@ -363,6 +467,57 @@ typedef struct {
     uint16_t local_port;                        /*!< Local port number */
 } esp_link_conn_t;
 
+#if ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+/**
+ * \brief           Region of input buffer referenced by packet buffer
+ */
+typedef struct {
+    size_t pos;                                 /*!< Start position of region in input buffer */
+    uint8_t used;                               /*!< Set to `1` while packet buffer is not freed */
+} esp_rx_hold_t;
+#endif /* ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
+
+#if ESP_CFG_TRANSPARENT || __DOXYGEN__
+/**
+ * \brief           Transparent transmission mode state
+ */
+typedef struct {
+    uint8_t active;                             /*!< Transparent session is open, other commands are rejected */
+    uint8_t raw;                                /*!< AT port carries raw data in both directions */
+    uint8_t exiting;                            /*!< Escape sequence is in progress, data from application are rejected */
+    uint8_t sending;                            /*!< Number of application calls writing raw data to AT port */
+    esp_transparent_recv_fn recv_fn;            /*!< Function to receive raw data */
+    void* arg;                                  /*!< Custom argument for receive function */
+} esp_transparent_t;
+#endif /* ESP_CFG_TRANSPARENT || __DOXYGEN__ */
+
+#if ESP_CFG_PRODUCER_PRIO || __DOXYGEN__
+/**
+ * \brief           Priority lane of producer thread
+ */
+typedef struct {
+    esp_msg_t* head;                            /*!< First message waiting in lane */
+    esp_msg_t* tail;                            /*!< Last message waiting in lane */
+    size_t queued;                              /*!< Number of messages waiting or executing */
+    size_t queued_max;                          /*!< Maximal number of messages at the same time */
+    uint32_t executed;                          /*!< Number of started messages */
+    uint32_t wait_total;                        /*!< Sum of wait times of started messages */
+    uint32_t wait_max;                          /*!< Maximal wait time of started message */
+} esp_prio_lane_t;
+#endif /* ESP_CFG_PRODUCER_PRIO || __DOXYGEN__ */
+
+/**
+ * \brief           Number of 32-bit words needed for bitmap of all connections
+ */
+#define ESP_CONN_MAP_WORDS              ((ESP_CFG_MAX_CONNS + 31) / 32)
+
+/**
+ * \brief           Bitmap with one bit per connection number
+ */
+typedef struct {
+    uint32_t w[ESP_CONN_MAP_WORDS];             /*!< Bit `n % 32` of word `n / 32` belongs to connection `n` */
+} esp_conn_map_t;
+
 /**
  * \brief           ESP global structure
  */
@@ -378,17 +533,52 @@ typedef struct {
 #if !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
     esp_buff_t          buff;                   /*!< Input processing buffer */
 #endif /* !ESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
+#if ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+    size_t              rx_ptr;                 /*!< Position of next byte to process in input buffer */
+    esp_rx_hold_t       rx_holds[ESP_CFG_IPD_ZERO_COPY_HOLDS];  /*!< Input buffer regions referenced by packet buffers, oldest first */
+    uint8_t             rx_holds_r;             /*!< Index of oldest entry in holds array */
+    uint8_t             rx_holds_cnt;           /*!< Number of entries in holds array */
+#endif /* ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
     esp_ll_t            ll;                     /*!< Low level functions */
+    uint32_t            baudrate;               /*!< Current baudrate of AT port */
+#if ESP_CFG_AT_PORT_TX_BUFF_SIZE || __DOXYGEN__
+    uint8_t             tx_buff[ESP_CFG_AT_PORT_TX_BUFF_SIZE];  /*!< Staging buffer for AT command being transmitted */
+    size_t              tx_len;                 /*!< Number of bytes waiting in staging buffer */
+#endif /* ESP_CFG_AT_PORT_TX_BUFF_SIZE || __DOXYGEN__ */
     
     esp_msg_t*          msg;                    /*!< Pointer to current user message being executed */
     
-    uint32_t            active_conns;           /*!< Bit field of currently active connections, @todo: In case user has more than 32 connections, single variable is not enough */
-    uint32_t            active_conns_last;      /*!< The same as previous but status before last check */
+    esp_conn_map_t      active_conns;           /*!< Connections reported active by last connection status check */
+    esp_conn_map_t      active_conns_last;      /*!< The same as previous but status before last check */
+    esp_conn_map_t      conns_open;             /*!< Connections with active flag set, iterated instead of all connections */
     
     esp_conn_t          conns[ESP_CFG_MAX_CONNS];   /*!< Array of all connection structures */
+#if (ESP_CFG_CONN_RECV_PASSIVE && ESP_CFG_PBUF_POOL) || __DOXYGEN__
+    uint8_t             recv_pool_wait;         /*!< Set to 1 when read was postponed because receive pool was empty */
+#endif /* (ESP_CFG_CONN_RECV_PASSIVE && ESP_CFG_PBUF_POOL) || __DOXYGEN__ */
+#if ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__
+    esp_msg_t*          send_q[ESP_CFG_MAX_CONNS];  /*!< Per connection queue of messages waiting for send scheduler */
+    esp_conn_map_t      send_q_map;             /*!< Connections with non-empty send queue */
+    size_t              send_q_next;            /*!< Connection checked first on next scheduling round */
+#endif /* ESP_CFG_CONN_SEND_SCHED || __DOXYGEN__ */
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+    esp_cmd_evt_fn      cmd_evt_fn;             /*!< Completion function for next command started by API function */
+    void*               cmd_evt_arg;            /*!< Custom user argument for completion function */
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
+#if ESP_CFG_CMD_COALESCE || __DOXYGEN__
+    esp_msg_t*          co_queries;             /*!< Queued or executing queries new requests may wait for */
+    uint32_t            co_saved;               /*!< Number of requests served by result of another query */
+#endif /* ESP_CFG_CMD_COALESCE || __DOXYGEN__ */
+#if ESP_CFG_PRODUCER_PRIO || __DOXYGEN__
+    esp_prio_lane_t     prio[ESP_PRIO_END];     /*!< Priority lanes of producer thread */
+    uint8_t             prio_burst;             /*!< Number of control commands executed since last data command */
+#endif /* ESP_CFG_PRODUCER_PRIO || __DOXYGEN__ */
     
     esp_link_conn_t     link_conn;              /*!< Link connection handle */
     esp_ipd_t           ipd;                    /*!< Incoming data structure */
+#if ESP_CFG_TRANSPARENT || __DOXYGEN__
+    esp_transparent_t   trans;                  /*!< Transparent transmission mode */
+#endif /* ESP_CFG_TRANSPARENT || __DOXYGEN__ */
     esp_cb_t            cb;                     /*!< Callback processing structure */
     
     esp_cb_fn           cb_func;                /*!< Default callback function */
@@ -448,6 +638,19 @@ extern esp_t esp;
 #define ESP_CHARHEXTONUM(x)                 (((x) >= '0' && (x) <= '9') ? ((x) - '0') : (((x) >= 'a' && (x) <= 'f') ? ((x) - 'a' + 10) : (((x) >= 'A' && (x) <= 'F') ? ((x) - 'A' + 10) : 0)))
 #define ESP_ISVALIDASCII(x)                 (((x) >= 32 && (x) <= 126) || (x) == '\r' || (x) == '\n')
 
+#define ESP_CONN_MAP_SET(map, n)            ((map)->w[(n) >> 5] |= ((uint32_t)1 << ((n) & 0x1F)))
+#define ESP_CONN_MAP_CLR(map, n)            ((map)->w[(n) >> 5] &= ~((uint32_t)1 << ((n) & 0x1F)))
+#define ESP_CONN_MAP_IS_SET(map, n)         (((map)->w[(n) >> 5] >> ((n) & 0x1F)) & 0x01)
+#define ESP_CONN_MAP_RESET(map)             memset((map), 0x00, sizeof(*(map)))
+
+/**
+ * \brief           Iterate over connection numbers set in bitmap, in ascending order
+ * \note            Bitmap is read again on every step, bits may be cleared inside loop body
+ * \param[in]       map: Pointer to \ref esp_conn_map_t bitmap
+ * \param[out]      n: Variable of type `size_t` with connection number
+ */
+#define ESP_CONN_MAP_FOR_EACH(map, n)       for ((n) = espi_conn_map_next((map), 0); (n) < ESP_CFG_MAX_CONNS; (n) = espi_conn_map_next((map), (n) + 1))
+
 /**
  * \brief           Protects (counts up) core from multiple accesses
  */
@@ -458,18 +661,58 @@ extern esp_t esp;
  */
 #define ESP_CORE_UNPROTECT()                esp_sys_unprotect()
 
+/**
+ * \brief           Check if message semaphore belongs to message pool and must not be deleted
+ */
+#if ESP_CFG_MSG_POOL || __DOXYGEN__
+#define ESP_MSG_SEM_IS_POOLED(m)            ((m)->pooled)
+#else /* ESP_CFG_MSG_POOL || __DOXYGEN__ */
+#define ESP_MSG_SEM_IS_POOLED(m)            0
+#endif /* !(ESP_CFG_MSG_POOL || __DOXYGEN__) */
+
 const char * espi_dbg_msg_to_string(esp_cmd_t cmd);
 
 espr_t      espi_process(const void* data, size_t len);
 espr_t      espi_process_buffer(void);
+#if ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+void        espi_rx_release(uint8_t hold);
+esp_pbuf_p  espi_pbuf_new_ref(void* payload, size_t len);
+#endif /* ESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
+#if ESP_CFG_MSG_POOL || __DOXYGEN__
+void        espi_msg_pool_init(void);
+esp_msg_t*  espi_msg_alloc(void);
+void        espi_msg_free(esp_msg_t* msg);
+#endif /* ESP_CFG_MSG_POOL || __DOXYGEN__ */
+#if ESP_CFG_CMD_STATS || __DOXYGEN__
+void        espi_cmd_stats_finish(esp_msg_t* msg);
+#endif /* ESP_CFG_CMD_STATS || __DOXYGEN__ */
+#if ESP_CFG_PBUF_POOL || __DOXYGEN__
+void        espi_pbuf_pool_init(void);
+esp_pbuf_p  espi_pbuf_pool_new(size_t len);
+size_t      espi_pbuf_pool_free(void);
+#endif /* ESP_CFG_PBUF_POOL || __DOXYGEN__ */
 
 espr_t      espi_initiate_cmd(esp_msg_t* msg);
 uint8_t     espi_is_valid_conn_ptr(esp_conn_p conn);
 espr_t      espi_send_cb(esp_cb_type_t type);
 espr_t      espi_send_conn_cb(esp_conn_t* conn, esp_cb_fn cb);
+void        espi_conn_send_data_free(esp_msg_t* msg);
 
 void        espi_conn_init(void);
-
+void        espi_conn_poll_start(void);
+void        espi_conn_set_active(esp_conn_t* conn, uint8_t active);
+size_t      espi_conn_map_next(const esp_conn_map_t* map, size_t from);
+#if ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__
+espr_t      espi_conn_recv_pull(esp_conn_t* conn);
+void        espi_conn_recv_pull_all(void);
+#endif /* ESP_CFG_CONN_RECV_PASSIVE || __DOXYGEN__ */
+#if ESP_CFG_TRANSPARENT || __DOXYGEN__
+espr_t      espi_transparent_restore(void);
+#endif /* ESP_CFG_TRANSPARENT || __DOXYGEN__ */
+
+#if ESP_CFG_CMD_COALESCE || __DOXYGEN__
+esp_msg_t*  espi_coalesce_finish(esp_msg_t* msg);
+#endif /* ESP_CFG_CMD_COALESCE || __DOXYGEN__ */
 espr_t      espi_send_msg_to_producer_mbox(esp_msg_t* msg, espr_t (*process_fn)(esp_msg_t *), uint32_t block, uint32_t max_block_time);
 
 #endif /* !__DOXYGEN__ */
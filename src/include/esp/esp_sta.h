@@ -52,6 +52,9 @@ extern "C" {
  */
 
 espr_t      esp_sta_join(const char* name, const char* pass, const uint8_t* mac, uint8_t def, uint32_t blocking);
+#if ESP_CFG_CMD_EVT || __DOXYGEN__
+espr_t      esp_sta_join_ex(const char* name, const char* pass, const uint8_t* mac, uint8_t def, esp_cmd_evt_fn evt_fn, void* evt_arg);
+#endif /* ESP_CFG_CMD_EVT || __DOXYGEN__ */
 espr_t      esp_sta_quit(uint32_t blocking);
 espr_t      esp_sta_getip(void* ip, void* gw, void* nm, uint8_t def, uint32_t blocking);
 espr_t      esp_sta_setip(const void* ip, const void* gw, const void* nm, uint8_t def, uint32_t blocking);
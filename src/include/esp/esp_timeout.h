@@ -58,12 +58,19 @@ typedef void (*esp_timeout_fn_t)(void *);
 
 /**
  * \brief           Timeout structure
+ *
+ *                  Structure may be allocated by user and used as handle
+ *                  with \ref esp_timeout_start and \ref esp_timeout_stop functions.
+ *                  Memory must stay valid until timeout is stopped or expires
  */
 typedef struct esp_timeout_t {
-    struct esp_timeout_t* next;                 /*!< Pointer to next timeout entry */
-    uint32_t time;                              /*!< Time difference from previous entry */
+    struct esp_timeout_t* next;                 /*!< Pointer to next timeout entry in wheel slot */
+    struct esp_timeout_t** pprev;               /*!< Pointer to next pointer of previous entry. `NULL` when not active */
+    uint32_t time;                              /*!< Absolute expiration time in units of milliseconds */
+    uint32_t period;                            /*!< Period in units of milliseconds or `0` for one-shot timeout */
     void* arg;                                  /*!< Argument to pass to callback function */
     esp_timeout_fn_t fn;                        /*!< Callback function for timeout */
+    uint8_t dyn;                                /*!< Set to `1` when memory was allocated by \ref esp_timeout_add */
 } esp_timeout_t;
 
 #ifdef ESP_INTERNAL
@@ -72,6 +79,10 @@ uint32_t        espi_get_from_mbox_with_timeout_checks(esp_sys_mbox_t* b, void**
 
 espr_t          esp_timeout_add(uint32_t time, void (*cb)(void *), void* arg);
 espr_t          esp_timeout_remove(esp_timeout_fn_t fn);
+
+espr_t          esp_timeout_start(esp_timeout_t* to, uint32_t time, uint32_t period, esp_timeout_fn_t fn, void* arg);
+espr_t          esp_timeout_stop(esp_timeout_t* to);
+uint8_t         esp_timeout_is_active(esp_timeout_t* to);
     
 /**
  * \}
@@ -0,0 +1,73 @@
+/**	
+ * \file            esp_transparent.h
+ * \brief           Transparent transmission mode API
+ */
+ 
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *  
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software, 
+ * and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef __ESP_TRANSPARENT_H
+#define __ESP_TRANSPARENT_H
+
+/* C++ detection */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp.h"
+
+/**
+ * \addtogroup      ESP
+ * \{
+ */
+    
+/**
+ * \defgroup        ESP_TRANSPARENT Transparent transmission mode
+ * \brief           Raw data exchange on single connection without AT commands
+ * \{
+ */
+ 
+espr_t      esp_transparent_start(esp_conn_type_t type, const char* host, uint16_t port,
+                                    esp_transparent_recv_fn recv_fn, void* arg, uint32_t blocking);
+espr_t      esp_transparent_send(const void* data, size_t btw);
+espr_t      esp_transparent_stop(uint32_t blocking);
+uint8_t     esp_transparent_is_active(void);
+ 
+/**
+ * \}
+ */
+    
+/**
+ * \}
+ */
+
+/* C++ detection */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ESP_TRANSPARENT_H */
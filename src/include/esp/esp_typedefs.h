@@ -137,9 +137,14 @@ typedef struct {
 #define ESP_MSG_VAR_FREE(name)                      
 #else /* 1 */
 #define ESP_MSG_VAR_DEFINE(name)                esp_msg_t* name
+#if ESP_CFG_MSG_POOL
+#define ESP_MSG_VAR_ALLOC(name)                 do { name = espi_msg_alloc(); if (!(name)) { ESP_DEBUGF(ESP_CFG_DBG_VAR, "Error allocating: %d bytes\r\n", sizeof(*(name))); return espERRMEM; } } while (0)
+#define ESP_MSG_VAR_FREE(name)                  espi_msg_free(name)
+#else /* ESP_CFG_MSG_POOL */
 #define ESP_MSG_VAR_ALLOC(name)                 do { name = esp_mem_alloc(sizeof(*(name))); if (!(name)) { ESP_DEBUGF(ESP_CFG_DBG_VAR, "Error allocating: %d bytes\r\n", sizeof(*(name))); return espERRMEM; } memset(name, 0x00, sizeof(*(name))); } while (0)
-#define ESP_MSG_VAR_REF(name)                   (*(name))
 #define ESP_MSG_VAR_FREE(name)                  esp_mem_free(name)
+#endif /* !ESP_CFG_MSG_POOL */
+#define ESP_MSG_VAR_REF(name)                   (*(name))
 #endif /* !1 */
 
 #endif /* defined(ESP_INTERNAL) || __DOXYGEN__ */
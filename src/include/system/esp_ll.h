@@ -42,6 +42,11 @@ extern "C" {
     
 espr_t      esp_ll_init(esp_ll_t* ll, uint32_t baudrate);
 
+#if ESP_CFG_SYS_PORT_POSIX
+int         esp_ll_posix_get_peer_fd(void);
+const char* esp_ll_posix_get_pty_name(void);
+#endif /* ESP_CFG_SYS_PORT_POSIX */
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
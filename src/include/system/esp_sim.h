@@ -0,0 +1,109 @@
+/**
+ * \file            esp_sim.h
+ * \brief           ESP AT firmware simulator for POSIX hosts
+ */
+
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef __ESP_SIM_H
+#define __ESP_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include "esp/esp.h"
+
+/**
+ * \addtogroup      ESP_PORT
+ * \{
+ */
+
+/**
+ * \defgroup        ESP_SIM AT firmware simulator
+ * \brief           Host side simulator of ESP AT firmware
+ * \{
+ *
+ * Simulator runs in separate thread and speaks subset of AT commands
+ * used by the library on other end of AT port, such as socketpair
+ * created by `esp_ll_posix.c` driver.
+ */
+
+/**
+ * \brief           Simulator configuration
+ */
+typedef struct {
+    uint32_t baudrate;                          /*!< Emulated UART baudrate in both directions. Use `0` for no delay */
+    uint16_t send_ok_loss;                      /*!< Probability to drop `SEND OK` response, in units of 1/1000 */
+    uint16_t send_ok_delay;                     /*!< Time in milliseconds from `Recv x bytes` to `SEND OK`, emulating remote acknowledge */
+    uint16_t reset_rate;                        /*!< Probability of spontaneous reset with `ready` per command, in units of 1/1000 */
+    uint8_t echo_data;                          /*!< Set to `1` to return data sent with `AT+CIPSEND` back as `+IPD` */
+    uint8_t ap_count;                           /*!< Number of access points reported by `AT+CWLAP` */
+    uint16_t guard_time;                        /*!< Minimal time in milliseconds without data before `+++` escape sequence in transparent mode */
+    uint32_t max_baudrate;                      /*!< Highest baudrate with reliable transfer, random bytes are corrupted above it. Use `0` for no limit */
+    uint32_t seed;                              /*!< Seed for random events */
+} esp_sim_cfg_t;
+
+/**
+ * \brief           Simulator statistics
+ */
+typedef struct {
+    uint32_t cmds;                              /*!< Number of processed AT commands */
+    uint32_t resets;                            /*!< Number of spontaneous resets */
+    uint32_t send_ok_lost;                      /*!< Number of dropped `SEND OK` responses */
+    uint64_t bytes_rx;                          /*!< Total bytes received from host */
+    uint64_t bytes_tx;                          /*!< Total bytes sent to host */
+    uint64_t data_sent;                         /*!< Payload bytes received with `AT+CIPSEND` */
+    uint64_t data_recv;                         /*!< Payload bytes sent to host with `+IPD` or `+CIPRECVDATA` */
+    uint64_t recv_dropped;                      /*!< Echoed payload bytes dropped due to full passive receive buffer */
+    uint64_t uart_errors;                       /*!< Bytes corrupted due to baudrate mismatch or baudrate above maximal one */
+} esp_sim_stats_t;
+
+espr_t      esp_sim_set_cfg(const esp_sim_cfg_t* cfg);
+espr_t      esp_sim_start(int fd);
+void        esp_sim_set_host_baudrate(uint32_t baud);
+void        esp_sim_get_stats(esp_sim_stats_t* stats);
+void        esp_sim_reset_stats(void);
+
+espr_t      esp_sim_ipd(uint8_t num, const void* data, size_t len);
+espr_t      esp_sim_remote_connect(uint8_t num, const uint8_t* ip, uint16_t port);
+espr_t      esp_sim_remote_close(uint8_t num);
+
+/**
+ * \}
+ */
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __ESP_SIM_H */
@@ -53,7 +53,7 @@ extern "C" {
  * \{
  */
 
-#if ESP_CFG_OS || __DOXYGEN__
+#if (ESP_CFG_OS && !ESP_CFG_SYS_PORT_POSIX) || __DOXYGEN__
 #include "cmsis_os.h"
 
 /**
@@ -123,7 +123,27 @@ typedef osPriority          esp_sys_thread_prio_t;
  * \note            Keep as is in case of CMSIS based OS, otherwise change for your OS
  */
 #define ESP_SYS_THREAD_SS           (1024)
-#endif /* ESP_OS || __DOXYGEN__ */
+#elif ESP_CFG_OS && ESP_CFG_SYS_PORT_POSIX
+#include "pthread.h"
+
+/*
+ * POSIX port types, see esp_sys_posix.c for implementation.
+ * Objects are allocated by the port and referenced by pointer
+ * so NULL can be used as invalid value, same as with CMSIS IDs
+ */
+typedef struct esp_sys_posix_mutex* esp_sys_mutex_t;
+typedef struct esp_sys_posix_sem*   esp_sys_sem_t;
+typedef struct esp_sys_posix_mbox*  esp_sys_mbox_t;
+typedef pthread_t                   esp_sys_thread_t;
+typedef int                         esp_sys_thread_prio_t;
+
+#define ESP_SYS_MBOX_NULL           (esp_sys_mbox_t)0
+#define ESP_SYS_SEM_NULL            (esp_sys_sem_t)0
+#define ESP_SYS_MUTEX_NULL          (esp_sys_mutex_t)0
+#define ESP_SYS_TIMEOUT             ((uint32_t)0xFFFFFFFFUL)
+#define ESP_SYS_THREAD_PRIO         (0)
+#define ESP_SYS_THREAD_SS           (0)         /* Use default pthread stack size */
+#endif /* ESP_CFG_OS */
 
 uint8_t     esp_sys_init(void);
 uint32_t    esp_sys_now(void);
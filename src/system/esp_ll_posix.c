@@ -0,0 +1,330 @@
+/**
+ * \file            esp_ll_posix.c
+ * \brief           Low-level communication with ESP device for POSIX systems
+ */
+
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE       700                 /* Required for pseudo-terminal functions */
+#endif
+#define ESP_INTERNAL
+#include "esp/esp.h"
+#include "esp/esp_input.h"
+#include "esp/esp_private.h"
+#include "system/esp_ll.h"
+
+#if !__DOXYGEN__
+#if ESP_CFG_SYS_PORT_POSIX
+
+#include "string.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "errno.h"
+#include "termios.h"
+#include "time.h"
+#include "sys/socket.h"
+#include "system/esp_sim.h"
+
+/*
+ * Channel used as AT port:
+ *
+ *  - ESP_LL_POSIX_SOCKETPAIR: Unix socketpair, other end is available with \ref esp_ll_posix_get_peer_fd
+ *  - ESP_LL_POSIX_PTY: Pseudo-terminal master, slave name is available with \ref esp_ll_posix_get_pty_name
+ *  - ESP_LL_POSIX_TTY: Serial device on ESP_LL_POSIX_TTY_PATH with real ESP device connected
+ *  - ESP_LL_POSIX_SIM: Unix socketpair with AT firmware simulator started on other end
+ */
+#define ESP_LL_POSIX_SOCKETPAIR             0
+#define ESP_LL_POSIX_PTY                    1
+#define ESP_LL_POSIX_TTY                    2
+#define ESP_LL_POSIX_SIM                    3
+
+#ifndef ESP_LL_POSIX_MODE
+#define ESP_LL_POSIX_MODE                   ESP_LL_POSIX_SOCKETPAIR
+#endif
+
+#ifndef ESP_LL_POSIX_TTY_PATH
+#define ESP_LL_POSIX_TTY_PATH               "/dev/ttyUSB0"
+#endif
+
+/* Maximal number of bytes read from channel at a time */
+#ifndef ESP_LL_POSIX_READ_SIZE
+#define ESP_LL_POSIX_READ_SIZE              0x1000
+#endif
+
+/* Size of memory assigned to ESP memory manager */
+#ifndef ESP_LL_POSIX_MEM_SIZE
+#define ESP_LL_POSIX_MEM_SIZE               0x40000
+#endif
+
+static uint8_t initialized;
+static int fd = -1;                             /* File descriptor used by stack */
+#if ESP_LL_POSIX_MODE != ESP_LL_POSIX_TTY
+static int peer_fd = -1;                        /* Other end of socketpair or opened pty slave */
+#endif /* ESP_LL_POSIX_MODE != ESP_LL_POSIX_TTY */
+static char pty_name[64];                       /* Name of pty slave device */
+static esp_sys_thread_t reader_thread_id;
+
+#if ESP_LL_POSIX_MODE == ESP_LL_POSIX_PTY || ESP_LL_POSIX_MODE == ESP_LL_POSIX_TTY
+/**
+ * \brief           Put terminal to raw mode with optional baudrate
+ * \param[in]       tfd: Terminal file descriptor
+ * \param[in]       baudrate: Baudrate to set or `0` to keep current
+ * \return          1 on success, 0 otherwise
+ */
+static uint8_t
+configure_tty(int tfd, uint32_t baudrate) {
+    struct termios tio;
+    speed_t speed;
+
+    if (tcgetattr(tfd, &tio)) {
+        return 0;
+    }
+    tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(CSIZE | PARENB | CSTOPB);
+    tio.c_cflag |= CS8 | CREAD | CLOCAL;
+    tio.c_cc[VMIN] = 1;                         /* Block until at least one byte is available */
+    tio.c_cc[VTIME] = 0;
+
+    if (baudrate) {
+        switch (baudrate) {
+            case 9600: speed = B9600; break;
+            case 19200: speed = B19200; break;
+            case 38400: speed = B38400; break;
+            case 57600: speed = B57600; break;
+            case 115200: speed = B115200; break;
+            case 230400: speed = B230400; break;
+#ifdef B460800
+            case 460800: speed = B460800; break;
+#endif /* B460800 */
+#ifdef B921600
+            case 921600: speed = B921600; break;
+#endif /* B921600 */
+#ifdef B1000000
+            case 1000000: speed = B1000000; break;
+#endif /* B1000000 */
+#ifdef B2000000
+            case 2000000: speed = B2000000; break;
+#endif /* B2000000 */
+#ifdef B3000000
+            case 3000000: speed = B3000000; break;
+#endif /* B3000000 */
+            default: return 0;                  /* Baudrate not supported by host */
+        }
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+    }
+    return tcsetattr(tfd, TCSANOW, &tio) == 0;
+}
+#endif /* ESP_LL_POSIX_MODE == ESP_LL_POSIX_PTY || ESP_LL_POSIX_MODE == ESP_LL_POSIX_TTY */
+
+/**
+ * \brief           Open channel used as AT port
+ * \param[in]       baudrate: Baudrate to use on AT port
+ * \return          1 on success, 0 otherwise
+ */
+static uint8_t
+open_channel(uint32_t baudrate) {
+#if ESP_LL_POSIX_MODE == ESP_LL_POSIX_SOCKETPAIR || ESP_LL_POSIX_MODE == ESP_LL_POSIX_SIM
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds)) {
+        return 0;
+    }
+    fd = fds[0];
+    peer_fd = fds[1];
+    ESP_UNUSED(baudrate);
+#if ESP_LL_POSIX_MODE == ESP_LL_POSIX_SIM
+    if (esp_sim_start(peer_fd) != espOK) {      /* Start simulator on device side */
+        return 0;
+    }
+#endif /* ESP_LL_POSIX_MODE == ESP_LL_POSIX_SIM */
+#elif ESP_LL_POSIX_MODE == ESP_LL_POSIX_PTY
+    const char* name;
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (fd < 0 || grantpt(fd) || unlockpt(fd) || (name = ptsname(fd)) == NULL) {
+        return 0;
+    }
+    strncpy(pty_name, name, sizeof(pty_name) - 1);
+
+    /*
+     * Keep slave opened to configure raw mode
+     * and to prevent read errors on master
+     * while nobody is connected to slave side
+     */
+    peer_fd = open(pty_name, O_RDWR | O_NOCTTY);
+    if (peer_fd < 0 || !configure_tty(peer_fd, 0)) {
+        return 0;
+    }
+    ESP_UNUSED(baudrate);
+#elif ESP_LL_POSIX_MODE == ESP_LL_POSIX_TTY
+    fd = open(ESP_LL_POSIX_TTY_PATH, O_RDWR | O_NOCTTY);
+    if (fd < 0) {
+        return 0;
+    }
+    return configure_tty(fd, baudrate);
+#endif /* ESP_LL_POSIX_MODE */
+    return 1;
+}
+
+/**
+ * \brief           Thread reading data from channel and sending them to stack
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+reader_thread(void* arg) {
+#if ESP_CFG_INPUT_USE_PROCESS
+    static uint8_t data[ESP_LL_POSIX_READ_SIZE];
+    size_t max_len = sizeof(data);
+#else /* ESP_CFG_INPUT_USE_PROCESS */
+    uint8_t* data;
+    size_t max_len;
+#endif /* !ESP_CFG_INPUT_USE_PROCESS */
+    ssize_t len;
+
+    ESP_UNUSED(arg);
+    while (1) {
+#if !ESP_CFG_INPUT_USE_PROCESS
+        /*
+         * Read directly to input buffer memory
+         * and never read more than input buffer is able to accept,
+         * which emulates hardware flow control
+         */
+        data = esp_input_reserve(&max_len);
+        if (data == NULL) {
+            struct timespec ts = { 0, 1000000L };
+            nanosleep(&ts, NULL);               /* Wait for processing thread to free memory */
+            continue;
+        }
+        max_len = ESP_MIN(max_len, ESP_LL_POSIX_READ_SIZE);
+#endif /* !ESP_CFG_INPUT_USE_PROCESS */
+        len = read(fd, data, max_len);          /* Read as much as available */
+        if (len > 0) {
+#if ESP_CFG_INPUT_USE_PROCESS
+            esp_input_process(data, (size_t)len);   /* Process data directly */
+#else /* ESP_CFG_INPUT_USE_PROCESS */
+            esp_input_commit((size_t)len);      /* Pass data written to input buffer */
+#endif /* !ESP_CFG_INPUT_USE_PROCESS */
+        } else if (len < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;                              /* Channel closed */
+        }
+    }
+}
+
+/**
+ * \brief           Send data to ESP device
+ * \param[in]       data: Pointer to data to send
+ * \param[in]       len: Number of bytes to send
+ * \return          Number of bytes sent
+ */
+static uint16_t
+send_data(const void* data, uint16_t len) {
+    const uint8_t* d = data;
+    uint16_t sent = 0;
+    ssize_t res;
+
+    while (sent < len) {
+        res = write(fd, &d[sent], len - sent);  /* Write may be partial, continue with rest */
+        if (res > 0) {
+            sent += (uint16_t)res;
+        } else if (res < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    return sent;
+}
+
+/**
+ * \brief           Get file descriptor of other socketpair end
+ * \note            Valid only in \ref ESP_LL_POSIX_SOCKETPAIR mode after \ref esp_ll_init
+ * \return          File descriptor on success, `-1` otherwise
+ */
+int
+esp_ll_posix_get_peer_fd(void) {
+#if ESP_LL_POSIX_MODE == ESP_LL_POSIX_SOCKETPAIR
+    return peer_fd;
+#else /* ESP_LL_POSIX_MODE == ESP_LL_POSIX_SOCKETPAIR */
+    return -1;
+#endif /* ESP_LL_POSIX_MODE == ESP_LL_POSIX_PTY || ESP_LL_POSIX_MODE == ESP_LL_POSIX_TTY */
+}
+
+/**
+ * \brief           Get pseudo-terminal slave device name to connect device or simulator to
+ * \note            Valid only in \ref ESP_LL_POSIX_PTY mode after \ref esp_ll_init
+ * \return          Device name on success, `NULL` otherwise
+ */
+const char *
+esp_ll_posix_get_pty_name(void) {
+    return pty_name[0] ? pty_name : NULL;
+}
+
+/**
+ * \brief           Callback function called from initialization process
+ * \note            This function may be called multiple times if AT baudrate is changed from application
+ * \param[in,out]   ll: Pointer to \ref esp_ll_t structure to fill data for communication functions
+ * \param[in]       baudrate: Baudrate to use on AT port
+ * \return          Member of \ref espr_t enumeration
+ */
+espr_t
+esp_ll_init(esp_ll_t* ll, uint32_t baudrate) {
+    static uint8_t memory[ESP_LL_POSIX_MEM_SIZE];
+    esp_mem_region_t mem_regions[] = {
+        { memory, sizeof(memory) }
+    };
+
+    if (!initialized) {
+        ll->send_fn = send_data;                /* Set callback function to send data */
+
+        esp_mem_assignmemory(mem_regions, ESP_ARRAYSIZE(mem_regions));  /* Assign memory for allocations */
+        if (!open_channel(baudrate)) {
+            return espERR;
+        }
+        if (!esp_sys_thread_create(&reader_thread_id, "esp_ll_reader", reader_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO)) {
+            return espERR;
+        }
+#if ESP_LL_POSIX_MODE == ESP_LL_POSIX_TTY
+    } else if (!configure_tty(fd, baudrate)) {  /* Change baudrate on real device */
+        return espERR;
+#endif /* ESP_LL_POSIX_MODE == ESP_LL_POSIX_TTY */
+    }
+#if ESP_LL_POSIX_MODE == ESP_LL_POSIX_SIM
+    esp_sim_set_host_baudrate(baudrate);        /* Simulator corrupts data on baudrate mismatch */
+#endif /* ESP_LL_POSIX_MODE == ESP_LL_POSIX_SIM */
+    initialized = 1;
+    return espOK;
+}
+
+#endif /* ESP_CFG_SYS_PORT_POSIX */
+#endif /* !__DOXYGEN__ */
@@ -0,0 +1,928 @@
+/**
+ * \file            esp_sim_posix.c
+ * \brief           ESP AT firmware simulator for POSIX hosts
+ */
+
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE       700                 /* Required for nanosleep */
+#endif
+#define ESP_INTERNAL
+#include "esp/esp_private.h"
+#include "system/esp_sim.h"
+
+#if ESP_CFG_SYS_PORT_POSIX || __DOXYGEN__
+
+#include "stdio.h"
+#include "stdarg.h"
+#include "string.h"
+#include "unistd.h"
+#include "errno.h"
+#include "time.h"
+#include "poll.h"
+
+#define SIM_MAX_CONNS               ESP_CFG_MAX_CONNS
+#define SIM_LINE_SIZE               256
+#define SIM_DATA_SIZE               ESP_CFG_CONN_MAX_DATA_LEN
+#define SIM_PENDING_SIZE            32
+#define SIM_RECV_SIZE               8192
+#define SIM_UART_ERROR_RATE         2           /* Probability of corrupted byte above maximal baudrate, in units of 1/1000 */
+
+#define SIM_IS_CMD(str)             (!strncmp(line, (str), sizeof(str) - 1))
+#define SIM_UART_UNRELIABLE()       (sim.baudrate != sim.host_baudrate || (sim.cfg.max_baudrate && sim.baudrate > sim.cfg.max_baudrate))
+
+/**
+ * \brief           Simulated connection
+ */
+typedef struct {
+    uint8_t active;                             /*!< Connection is active */
+    uint8_t is_server;                          /*!< Connection was accepted by server */
+    char type[4];                               /*!< Connection type string */
+    uint8_t ip[4];                              /*!< Remote IP address */
+    uint16_t port;                              /*!< Remote port */
+    uint16_t local_port;                        /*!< Local port */
+    uint16_t seg_id;                            /*!< Last segment ID written with `AT+CIPSENDBUF` */
+    uint16_t seg_id_ok;                         /*!< Last segment ID finished with `SEND OK` or `SEND FAIL` */
+    uint8_t rx[SIM_RECV_SIZE];                  /*!< Received data held in passive receive mode */
+    size_t rx_len;                              /*!< Number of bytes in receive buffer */
+} esp_sim_conn_t;
+
+/**
+ * \brief           Send result waiting for remote acknowledge
+ */
+typedef struct {
+    uint64_t time;                              /*!< Time in milliseconds when result is reported */
+    uint8_t num;                                /*!< Connection number */
+    uint8_t buffered;                           /*!< Data were sent with `AT+CIPSENDBUF` */
+    uint16_t seg_id;                            /*!< Segment ID for buffered send */
+} esp_sim_pending_t;
+
+/**
+ * \brief           Simulator state
+ */
+typedef struct {
+    int fd;                                     /*!< File descriptor of AT port */
+    esp_sim_cfg_t cfg;                          /*!< Active configuration */
+    uint8_t cfg_set;                            /*!< Configuration was set by user */
+    esp_sim_stats_t stats;                      /*!< Statistics */
+    esp_sys_mutex_t mutex;                      /*!< Mutex protecting writes and state */
+    esp_sys_thread_t thread;                    /*!< Simulator thread */
+    uint32_t rnd;                               /*!< Random generator state */
+    uint32_t baudrate;                          /*!< Current UART baudrate, changed with `AT+UART_CUR` */
+    uint32_t host_baudrate;                     /*!< UART baudrate of host side */
+
+    uint8_t echo;                               /*!< Command echo is enabled */
+    uint8_t sysmsg;                             /*!< `AT+SYSMSG_CUR` value */
+    uint8_t got_ip;                             /*!< Station is connected and has IP */
+    uint8_t recv_mode;                          /*!< `AT+CIPRECVMODE` value, `1` for passive receive */
+    uint8_t mux;                                /*!< `AT+CIPMUX` value */
+    uint8_t cipmode;                            /*!< `AT+CIPMODE` value, `1` for transparent transmission */
+    uint8_t raw;                                /*!< Transparent transmission is running, AT port carries raw data */
+    uint64_t raw_last;                          /*!< Time of last raw data from host, for escape sequence guard time */
+    esp_sim_conn_t conns[SIM_MAX_CONNS];        /*!< Connections */
+
+    char line[SIM_LINE_SIZE];                   /*!< Command line buffer */
+    size_t line_len;                            /*!< Length of command line */
+
+    uint8_t data[SIM_DATA_SIZE];                /*!< Buffer for `AT+CIPSEND` payload */
+    size_t data_len;                            /*!< Expected payload length, `0` when in command mode */
+    size_t data_ptr;                            /*!< Number of payload bytes received so far */
+    uint8_t data_conn;                          /*!< Connection number for payload */
+    uint8_t data_buffered;                      /*!< Payload was started with `AT+CIPSENDBUF` */
+
+    esp_sim_pending_t pending[SIM_PENDING_SIZE];/*!< Send results waiting to be reported, in time order */
+    size_t pending_r;                           /*!< Read index of pending results */
+    size_t pending_w;                           /*!< Write index of pending results */
+} esp_sim_t;
+
+static esp_sim_t sim;
+
+/**
+ * \brief           Get next pseudo random number
+ * \return          Random number
+ */
+static uint32_t
+sim_rand(void) {
+    sim.rnd ^= sim.rnd << 13;                   /* Xorshift32 for reproducible runs */
+    sim.rnd ^= sim.rnd >> 17;
+    sim.rnd ^= sim.rnd << 5;
+    return sim.rnd;
+}
+
+/**
+ * \brief           Check random event with probability in units of 1/1000
+ * \param[in]       rate: Probability of event
+ * \return          1 if event happened, 0 otherwise
+ */
+static uint8_t
+sim_event(uint16_t rate) {
+    return rate && (sim_rand() % 1000) < rate;
+}
+
+/**
+ * \brief           Get monotonic time
+ * \return          Time in units of milliseconds
+ */
+static uint64_t
+sim_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+/**
+ * \brief           Delay for time needed to transfer bytes over emulated UART
+ * \param[in]       len: Number of bytes
+ */
+static void
+sim_uart_delay(size_t len) {
+    struct timespec ts;
+    uint64_t ns;
+
+    if (!sim.cfg.baudrate || !len) {
+        return;
+    }
+    ns = (uint64_t)len * 10ULL * 1000000000ULL / sim.cfg.baudrate;  /* 10 bits per byte with start and stop bit */
+    ts.tv_sec = (time_t)(ns / 1000000000ULL);
+    ts.tv_nsec = (long)(ns % 1000000000ULL);
+    while (nanosleep(&ts, &ts) && errno == EINTR) {}
+}
+
+/**
+ * \brief           Corrupt random bits when UART runs faster than it reliably can
+ *                  or when host uses different baudrate
+ * \note            Mutex must be locked by caller
+ * \param[in,out]   data: Data transferred over UART
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+sim_uart_errors(uint8_t* data, size_t len) {
+    size_t i;
+
+    if (!SIM_UART_UNRELIABLE()) {
+        return;
+    }
+    for (i = 0; i < len; i++) {
+        if (sim.baudrate != sim.host_baudrate || sim_event(SIM_UART_ERROR_RATE)) {
+            data[i] ^= (uint8_t)(1 << (sim_rand() & 0x07));
+            sim.stats.uart_errors++;
+        }
+    }
+}
+
+/**
+ * \brief           Write data to file descriptor of AT port
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+sim_write_fd(const uint8_t* data, size_t len) {
+    ssize_t res;
+
+    while (len) {
+        res = write(sim.fd, data, len);
+        if (res > 0) {
+            data += res;
+            len -= (size_t)res;
+        } else if (res < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+}
+
+/**
+ * \brief           Write raw data to host
+ * \note            Mutex must be locked by caller
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+sim_write(const void* data, size_t len) {
+    const uint8_t* d = data;
+    uint8_t tmp[SIM_LINE_SIZE];
+    size_t n;
+
+    sim_uart_delay(len);
+    sim.stats.bytes_tx += len;
+    if (!SIM_UART_UNRELIABLE()) {
+        sim_write_fd(d, len);
+        return;
+    }
+    for (; len; len -= n, d += n) {             /* Corrupt copy of data, chunk by chunk */
+        n = ESP_MIN(len, sizeof(tmp));
+        memcpy(tmp, d, n);
+        sim_uart_errors(tmp, n);
+        sim_write_fd(tmp, n);
+    }
+}
+
+/**
+ * \brief           Write formatted string to host
+ * \note            Mutex must be locked by caller
+ * \param[in]       fmt: Format string
+ */
+static void
+sim_printf(const char* fmt, ...) {
+    char str[SIM_LINE_SIZE];
+    va_list va;
+    int len;
+
+    va_start(va, fmt);
+    len = vsnprintf(str, sizeof(str), fmt, va);
+    va_end(va);
+    if (len > 0) {
+        sim_write(str, ESP_MIN((size_t)len, sizeof(str) - 1));
+    }
+}
+
+/**
+ * \brief           Send received network data to host as `+IPD`
+ *
+ *                  In passive receive mode, TCP data are kept in connection buffer
+ *                  and only their length is reported
+ *
+ * \note            Mutex must be locked by caller
+ * \param[in]       num: Connection number
+ * \param[in]       data: Payload
+ * \param[in]       len: Payload length
+ * \return          `1` if data were accepted, `0` if receive buffer is full
+ */
+static uint8_t
+sim_send_ipd(uint8_t num, const void* data, size_t len) {
+    esp_sim_conn_t* c = &sim.conns[num];
+
+    if (sim.raw) {                              /* Data go to host without any header */
+        sim_write(data, len);
+        sim.stats.data_recv += len;
+        return 1;
+    }
+    if (sim.recv_mode && !strcmp(c->type, "TCP")) {
+        if (len > SIM_RECV_SIZE - c->rx_len) {
+            return 0;                           /* Remote side must wait for window */
+        }
+        memcpy(&c->rx[c->rx_len], data, len);
+        c->rx_len += len;
+        sim_printf("\r\n+IPD,%d,%d\r\n", (int)num, (int)len);
+        return 1;
+    }
+    sim_printf("\r\n+IPD,%d,%d,%d.%d.%d.%d,%d:", (int)num, (int)len,
+        (int)c->ip[0], (int)c->ip[1], (int)c->ip[2], (int)c->ip[3], (int)c->port);
+    sim_write(data, len);
+    sim.stats.data_recv += len;
+    return 1;
+}
+
+/**
+ * \brief           Put simulator to state after power-up
+ */
+static void
+sim_reset_state(void) {
+    memset(sim.conns, 0x00, sizeof(sim.conns));
+    sim.echo = 1;                               /* Echo is enabled by default on ESP */
+    sim.sysmsg = 0;
+    sim.got_ip = 0;
+    sim.recv_mode = 0;
+    sim.mux = 0;
+    sim.cipmode = 0;
+    sim.raw = 0;
+    sim.line_len = 0;
+    sim.data_len = 0;
+    sim.pending_r = sim.pending_w = 0;          /* Results of unfinished sends are lost */
+}
+
+/**
+ * \brief           Get quoted string argument
+ * \param[in,out]   str: Pointer to pointer to string to parse
+ * \param[out]      dst: Destination buffer
+ * \param[in]       len: Length of destination buffer
+ */
+static void
+sim_get_string(const char** str, char* dst, size_t len) {
+    const char* p = *str;
+    size_t i = 0;
+
+    while (*p && *p != '"') {
+        p++;
+    }
+    if (*p == '"') {
+        p++;
+    }
+    while (*p && *p != '"') {
+        if (*p == '\\' && p[1]) {               /* Escaped character */
+            p++;
+        }
+        if (i < len - 1) {
+            dst[i++] = *p;
+        }
+        p++;
+    }
+    if (*p == '"') {
+        p++;
+    }
+    dst[i] = 0;
+    *str = p;
+}
+
+/**
+ * \brief           Get number argument
+ * \param[in,out]   str: Pointer to pointer to string to parse
+ * \return          Parsed number
+ */
+static int32_t
+sim_get_number(const char** str) {
+    const char* p = *str;
+    int32_t val = 0;
+
+    while (*p && !ESP_CHARISNUM(*p)) {
+        p++;
+    }
+    while (ESP_CHARISNUM(*p)) {
+        val = val * 10 + ESP_CHARTONUM(*p);
+        p++;
+    }
+    *str = p;
+    return val;
+}
+
+/**
+ * \brief           Report connection just active
+ * \note            Mutex must be locked by caller
+ * \param[in]       num: Connection number
+ */
+static void
+sim_report_connect(uint8_t num) {
+    esp_sim_conn_t* c = &sim.conns[num];
+
+    if (sim.sysmsg & 0x02) {                    /* Link info enabled with AT+SYSMSG_CUR */
+        sim_printf("+LINK_CONN:0,%d,\"%s\",%d,\"%d.%d.%d.%d\",%d,%d\r\n", (int)num, c->type, (int)c->is_server,
+            (int)c->ip[0], (int)c->ip[1], (int)c->ip[2], (int)c->ip[3], (int)c->port, (int)c->local_port);
+    } else {
+        sim_printf("%d,CONNECT\r\n", (int)num);
+    }
+}
+
+/**
+ * \brief           Process received command line
+ * \note            Mutex must be locked by caller
+ * \param[in]       line: Command line with stripped CR and LF
+ */
+static void
+sim_process_cmd(const char* line) {
+    const char* p;
+    uint8_t i;
+
+    sim.stats.cmds++;
+    if (sim_event(sim.cfg.reset_rate)) {        /* Spontaneous reset? */
+        sim.stats.resets++;
+        sim_reset_state();
+        sim_printf("\r\n ets Jan  8 2013,rst cause:4, boot mode:(3,7)\r\n\r\nready\r\n");
+        return;
+    }
+    if (sim.echo) {
+        sim_printf("%s\r\r\n", line);           /* Firmware echoes command followed by CR CR LF */
+    }
+
+    if (!strcmp(line, "AT")) {
+        sim_printf("\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+RST")) {
+        sim_printf("\r\nOK\r\n");
+        sim_reset_state();
+        sim_printf("\r\n ets Jan  8 2013,rst cause:2, boot mode:(3,7)\r\n\r\nready\r\n");
+    } else if (SIM_IS_CMD("ATE")) {
+        sim.echo = line[3] == '1';
+        sim_printf("\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+GMR")) {
+        sim_printf("AT version:1.6.0.0(Feb  3 2018 12:00:06)\r\nSDK version:2.2.0(f28eaf2)\r\n"
+            "compile time:Feb  6 2018 14:36:25\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+SYSMSG_CUR=")) {
+        p = &line[14];
+        sim.sysmsg = (uint8_t)sim_get_number(&p);
+        sim_printf("\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+UART_CUR=")) {
+        p = &line[12];
+        sim_printf("\r\nOK\r\n");
+        sim.baudrate = (uint32_t)sim_get_number(&p);    /* Switch rate after OK */
+        sim.cfg.baudrate = sim.cfg.baudrate ? sim.baudrate : 0; /* Emulate transfer time only when enabled */
+    } else if (SIM_IS_CMD("AT+CWJAP")) {
+        sim.got_ip = 1;
+        sim_printf("WIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+CWQAP")) {
+        sim.got_ip = 0;
+        sim_printf("\r\nOK\r\nWIFI DISCONNECT\r\n");
+    } else if (SIM_IS_CMD("AT+CWLAP")) {
+        for (i = 0; i < sim.cfg.ap_count; i++) {
+            sim_printf("+CWLAP:(%d,\"sim_ap_%d\",%d,\"18:fe:34:00:00:%02x\",%d,-20,0)\r\n",
+                (int)(i % 5), (int)i, -40 - (int)(i % 50), (unsigned)i, (int)(1 + i % 13));
+        }
+        sim_printf("\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+CWLIF")) {
+        sim_printf("192.168.4.2,18:fe:34:00:01:02\r\n\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+CIPSTAMAC") || SIM_IS_CMD("AT+CIPAPMAC")) {
+        if (strchr(line, '?') != NULL) {
+            uint8_t is_ap = line[6] == 'A';
+            sim_printf("+%.*s:\"18:fe:34:00:00:%s\"\r\n\r\nOK\r\n", (int)(strchr(line, '?') - &line[3]), &line[3], is_ap ? "02" : "01");
+        } else {
+            sim_printf("\r\nOK\r\n");
+        }
+    } else if (SIM_IS_CMD("AT+CIPSTA_") || SIM_IS_CMD("AT+CIPAP_")) {
+        if (strchr(line, '?') != NULL) {
+            uint8_t is_ap = line[6] == 'A';
+            int len = (int)(strchr(line, '?') - &line[3]);
+            const char* net = is_ap ? "192.168.4" : "192.168.1";
+
+            sim_printf("+%.*s:ip:\"%s.%d\"\r\n", len, &line[3], net, is_ap ? 1 : 50);
+            sim_printf("+%.*s:gateway:\"%s.1\"\r\n", len, &line[3], net);
+            sim_printf("+%.*s:netmask:\"255.255.255.0\"\r\n\r\nOK\r\n", len, &line[3]);
+        } else {
+            sim_printf("\r\nOK\r\n");
+        }
+    } else if (SIM_IS_CMD("AT+CWHOSTNAME?")) {
+        sim_printf("+CWHOSTNAME:ESP_SIM\r\n\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+CIPDOMAIN=")) {
+        sim_printf("+CIPDOMAIN:93.184.216.34\r\n\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+PING=")) {
+        sim_printf("+%d\r\n\r\nOK\r\n", (int)(1 + sim_rand() % 20));
+    } else if (SIM_IS_CMD("AT+CIPSNTPTIME?")) {
+        sim_printf("+CIPSNTPTIME:Thu Jan 01 00:00:00 1970\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+CIPSTATUS")) {
+        sim_printf("STATUS:%d\r\n", sim.got_ip ? 2 : 5);
+        for (i = 0; i < SIM_MAX_CONNS; i++) {
+            esp_sim_conn_t* c = &sim.conns[i];
+            if (c->active) {
+                sim_printf("+CIPSTATUS:%d,\"%s\",\"%d.%d.%d.%d\",%d,%d,%d\r\n", (int)i, c->type,
+                    (int)c->ip[0], (int)c->ip[1], (int)c->ip[2], (int)c->ip[3], (int)c->port, (int)c->local_port, (int)c->is_server);
+            }
+        }
+        sim_printf("\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+CIPSTART=")) {
+        char type[4], host[64];
+        uint8_t num;
+        esp_sim_conn_t* c;
+
+        p = &line[12];
+        num = sim.mux ? (uint8_t)sim_get_number(&p) : 0;    /* Single connection has no number */
+        sim_get_string(&p, type, sizeof(type));
+        sim_get_string(&p, host, sizeof(host));
+        if (num >= SIM_MAX_CONNS) {
+            sim_printf("\r\nERROR\r\n");
+            return;
+        }
+        c = &sim.conns[num];
+        if (c->active) {
+            sim_printf("ALREADY CONNECTED\r\n\r\nERROR\r\n");
+        } else if (!strncmp(host, "fail", 4)) { /* Hosts starting with "fail" are never reachable */
+            sim_printf("%d,CONNECT FAIL\r\n\r\nERROR\r\n", (int)num);
+        } else {
+            memset(c, 0x00, sizeof(*c));
+            strncpy(c->type, type, sizeof(c->type) - 1);
+            c->port = (uint16_t)sim_get_number(&p);
+            c->local_port = (uint16_t)(1024 + sim_rand() % 30000);
+            c->ip[0] = 10;                      /* Resolve every host to private range */
+            c->ip[1] = 0;
+            c->ip[2] = (uint8_t)(sim_rand() % 255);
+            c->ip[3] = 1 + num;
+            c->active = 1;
+            c->seg_id = c->seg_id_ok = 0;
+            if (sim.mux) {
+                sim_report_connect(num);
+            } else {
+                sim_printf("CONNECT\r\n");
+            }
+            sim_printf("\r\nOK\r\n");
+        }
+    } else if (SIM_IS_CMD("AT+CIPCLOSE=")) {
+        uint8_t num;
+
+        p = &line[12];
+        num = (uint8_t)sim_get_number(&p);
+        if (num < SIM_MAX_CONNS && sim.conns[num].active) {
+            sim.conns[num].active = 0;
+            sim.conns[num].rx_len = 0;          /* Data not read yet are lost */
+            sim_printf("%d,CLOSED\r\n\r\nOK\r\n", (int)num);
+        } else {
+            sim_printf("UNLINK\r\n\r\nERROR\r\n");
+        }
+    } else if (SIM_IS_CMD("AT+CIPSEND=") || SIM_IS_CMD("AT+CIPSENDBUF=")) {
+        uint8_t num, buffered = SIM_IS_CMD("AT+CIPSENDBUF=");
+        size_t len;
+
+        p = &line[buffered ? 14 : 11];
+        num = (uint8_t)sim_get_number(&p);
+        len = (size_t)sim_get_number(&p);
+        if (num >= SIM_MAX_CONNS || !sim.conns[num].active) {
+            sim_printf("link is not valid\r\n\r\nERROR\r\n");
+        } else if (!len || len > SIM_DATA_SIZE
+            || (buffered && strcmp(sim.conns[num].type, "TCP"))) {
+            sim_printf("\r\nERROR\r\n");
+        } else if (((sim.pending_w + 1) % SIM_PENDING_SIZE) == sim.pending_r) {
+            sim_printf("\r\nbusy p...\r\n");    /* Device send buffer is full */
+        } else {
+            sim.data_conn = num;
+            sim.data_len = len;
+            sim.data_ptr = 0;
+            sim.data_buffered = buffered;
+            if (buffered) {                     /* Report next and last finished segment ID */
+                sim_printf("%d,%d\r\n", (int)(uint16_t)(sim.conns[num].seg_id + 1), (int)sim.conns[num].seg_id_ok);
+            }
+            sim_printf("\r\nOK\r\n> ");         /* Wait for data now */
+        }
+    } else if (SIM_IS_CMD("AT+CIPMUX=")) {
+        uint8_t mux;
+
+        p = &line[10];
+        mux = (uint8_t)sim_get_number(&p);
+        for (i = 0; i < SIM_MAX_CONNS && !sim.conns[i].active; i++) {}
+        if (mux != sim.mux && i < SIM_MAX_CONNS) {
+            sim_printf("link is builded\r\n\r\nERROR\r\n");
+        } else if (!mux && sim.cipmode) {
+            sim_printf("\r\nERROR\r\n");
+        } else {
+            sim.mux = mux;
+            sim_printf("\r\nOK\r\n");
+        }
+    } else if (SIM_IS_CMD("AT+CIPMODE=")) {
+        p = &line[11];
+        if (sim.mux) {                          /* Transparent mode requires single connection */
+            sim_printf("\r\nERROR\r\n");
+        } else {
+            sim.cipmode = (uint8_t)sim_get_number(&p);
+            sim_printf("\r\nOK\r\n");
+        }
+    } else if (!strcmp(line, "AT+CIPSEND")) {  /* Start transparent transmission */
+        if (sim.mux || !sim.cipmode || !sim.conns[0].active) {
+            sim_printf("\r\nERROR\r\n");
+        } else {
+            sim.raw = 1;
+            sim.raw_last = sim_now();
+            sim_printf("\r\nOK\r\n> ");
+        }
+    } else if (!strcmp(line, "AT+CIPCLOSE")) { /* Close single connection */
+        if (sim.mux || !sim.conns[0].active) {
+            sim_printf("\r\nERROR\r\n");
+        } else {
+            sim.conns[0].active = 0;
+            sim.conns[0].rx_len = 0;
+            sim_printf("CLOSED\r\n\r\nOK\r\n");
+        }
+    } else if (SIM_IS_CMD("AT+CIPRECVMODE=")) {
+        p = &line[15];
+        sim.recv_mode = (uint8_t)sim_get_number(&p);
+        sim_printf("\r\nOK\r\n");
+    } else if (SIM_IS_CMD("AT+CIPRECVDATA=")) {
+        uint8_t num;
+        size_t len;
+        esp_sim_conn_t* c;
+
+        p = &line[15];
+        num = (uint8_t)sim_get_number(&p);
+        len = (size_t)sim_get_number(&p);
+        c = &sim.conns[num < SIM_MAX_CONNS ? num : 0];
+        if (num >= SIM_MAX_CONNS || !c->active || !c->rx_len || !len) {
+            sim_printf("\r\nERROR\r\n");
+        } else {
+            len = len < c->rx_len ? len : c->rx_len;
+            sim_printf("+CIPRECVDATA,%d:", (int)len);
+            sim_write(c->rx, len);
+            sim_printf("\r\nOK\r\n");
+            memmove(c->rx, &c->rx[len], c->rx_len - len);
+            c->rx_len -= len;
+            sim.stats.data_recv += len;
+        }
+    } else if (SIM_IS_CMD("AT+CWMODE") || SIM_IS_CMD("AT+CIPDINFO=")
+        || SIM_IS_CMD("AT+CIPSERVER") || SIM_IS_CMD("AT+CIPSTO=") || SIM_IS_CMD("AT+CWSAP")
+        || SIM_IS_CMD("AT+CIPSSLSIZE=") || SIM_IS_CMD("AT+CWHOSTNAME=") || SIM_IS_CMD("AT+CIPSNTPCFG=")) {
+        sim_printf("\r\nOK\r\n");               /* Configuration commands without side effects */
+    } else {
+        sim_printf("\r\nERROR\r\n");
+    }
+}
+
+/**
+ * \brief           Report send results with expired acknowledge time
+ * \note            Mutex must be locked by caller
+ * \return          Time in milliseconds until next result is due, `-1` if there is none
+ */
+static int
+sim_process_pending(void) {
+    esp_sim_pending_t* pend;
+    uint64_t now = sim_now();
+
+    while (sim.pending_r != sim.pending_w) {
+        pend = &sim.pending[sim.pending_r];
+        if (pend->time > now) {
+            return (int)(pend->time - now);
+        }
+        if (pend->buffered) {
+            sim.conns[pend->num].seg_id_ok = pend->seg_id;
+            if (sim.conns[pend->num].active) {
+                sim_printf("%d,%d,SEND OK\r\n", (int)pend->num, (int)pend->seg_id);
+            }
+        } else {
+            sim_printf("\r\nSEND OK\r\n");
+        }
+        sim.pending_r = (sim.pending_r + 1) % SIM_PENDING_SIZE;
+    }
+    return -1;
+}
+
+/**
+ * \brief           Process payload received after `> ` prompt
+ * \note            Mutex must be locked by caller
+ */
+static void
+sim_process_data(void) {
+    esp_sim_pending_t* pend;
+    uint8_t num = sim.data_conn;
+    size_t len = sim.data_len;
+
+    sim.data_len = 0;                           /* Go back to command mode */
+    sim.stats.data_sent += len;
+    sim_printf("\r\nRecv %d bytes\r\n", (int)len);
+    if (sim_event(sim.cfg.send_ok_loss)) {
+        sim.stats.send_ok_lost++;               /* Device never reports result */
+    } else {
+        pend = &sim.pending[sim.pending_w];     /* Report result after remote acknowledge */
+        pend->time = sim_now() + sim.cfg.send_ok_delay;
+        pend->num = num;
+        pend->buffered = sim.data_buffered;
+        pend->seg_id = 0;
+        if (sim.data_buffered) {
+            pend->seg_id = ++sim.conns[num].seg_id;
+        }
+        sim.pending_w = (sim.pending_w + 1) % SIM_PENDING_SIZE;
+    }
+    sim_process_pending();
+    if (sim.cfg.echo_data && sim.conns[num].active) {
+        if (!sim_send_ipd(num, sim.data, len)) {/* Remote side echoes data back */
+            sim.stats.recv_dropped += len;      /* No space in passive receive buffer */
+        }
+    }
+}
+
+/**
+ * \brief           Simulator thread
+ * \param[in]       arg: Thread argument, not used
+ */
+static void
+sim_thread(void* arg) {
+    struct pollfd pfd;
+    uint8_t buff[0x800];
+    ssize_t len;
+    size_t i, n;
+    int timeout;
+
+    ESP_UNUSED(arg);
+    while (1) {
+        esp_sys_mutex_lock(&sim.mutex);
+        timeout = sim_process_pending();        /* Report results due now */
+        esp_sys_mutex_unlock(&sim.mutex);
+
+        pfd.fd = sim.fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (poll(&pfd, 1, timeout) == 0) {
+            continue;                           /* Timeout, next result is due */
+        }
+        len = read(sim.fd, buff, sizeof(buff));
+        if (len < 0 && errno == EINTR) {
+            continue;
+        } else if (len <= 0) {
+            break;                              /* Host closed AT port */
+        }
+        sim_uart_delay((size_t)len);            /* Transfer time from host to device */
+        esp_sys_mutex_lock(&sim.mutex);
+        sim_uart_errors(buff, (size_t)len);
+        sim.stats.bytes_rx += (size_t)len;
+        if (sim.raw) {                          /* Transparent transmission */
+            if (len == 3 && !memcmp(buff, "+++", 3) && sim_now() - sim.raw_last >= sim.cfg.guard_time) {
+                sim.raw = 0;                    /* Escape sequence, back to command mode */
+            } else {
+                sim.stats.data_sent += (size_t)len;
+                if (sim.cfg.echo_data) {
+                    sim_send_ipd(0, buff, (size_t)len); /* Remote side echoes data back */
+                }
+            }
+            sim.raw_last = sim_now();
+            len = 0;                            /* Nothing to process as commands */
+        }
+        for (i = 0; i < (size_t)len; ) {
+            if (sim.data_len) {                 /* Are we receiving payload? */
+                n = ESP_MIN(sim.data_len - sim.data_ptr, (size_t)len - i);
+                memcpy(&sim.data[sim.data_ptr], &buff[i], n);
+                sim.data_ptr += n;
+                i += n;
+                if (sim.data_ptr == sim.data_len) {
+                    sim_process_data();
+                }
+                continue;
+            }
+            if (buff[i] == '\n') {              /* End of command */
+                if (sim.line_len && sim.line[sim.line_len - 1] == '\r') {
+                    sim.line_len--;
+                }
+                sim.line[sim.line_len] = 0;
+                if (sim.line_len) {
+                    sim_process_cmd(sim.line);
+                }
+                sim.line_len = 0;
+            } else if (sim.line_len < sizeof(sim.line) - 1) {
+                sim.line[sim.line_len++] = (char)buff[i];
+            }
+            i++;
+        }
+        esp_sys_mutex_unlock(&sim.mutex);
+    }
+}
+
+/**
+ * \brief           Set simulator configuration
+ * \note            Function may be called before \ref esp_sim_start or at any time later
+ *                  to change behavior of running simulator
+ * \param[in]       cfg: Simulator configuration
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_sim_set_cfg(const esp_sim_cfg_t* cfg) {
+    ESP_ASSERT("cfg != NULL", cfg != NULL);     /* Assert input parameters */
+
+    if (esp_sys_mutex_isvalid(&sim.mutex)) {
+        esp_sys_mutex_lock(&sim.mutex);
+    }
+    sim.cfg = *cfg;
+    sim.cfg_set = 1;
+    sim.rnd = sim.cfg.seed ? sim.cfg.seed : 0x12345678UL;
+    if (esp_sys_mutex_isvalid(&sim.mutex)) {
+        esp_sys_mutex_unlock(&sim.mutex);
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Start simulator on file descriptor
+ * \note            When `esp_ll_posix.c` runs in `ESP_LL_POSIX_SIM` mode,
+ *                  simulator is started automatically on other end of AT port
+ * \param[in]       fd: File descriptor of device side of AT port
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_sim_start(int fd) {
+    ESP_ASSERT("fd >= 0", fd >= 0);             /* Assert input parameters */
+
+    if (!sim.cfg_set) {                         /* Apply default configuration */
+        sim.cfg.ap_count = 10;
+        sim.rnd = 0x12345678UL;
+    }
+    sim.fd = fd;
+    sim_reset_state();
+
+    if (!esp_sys_mutex_create(&sim.mutex)) {
+        return espERRMEM;
+    }
+    if (!esp_sys_thread_create(&sim.thread, "esp_sim", sim_thread, NULL, ESP_SYS_THREAD_SS, ESP_SYS_THREAD_PRIO)) {
+        esp_sys_mutex_delete(&sim.mutex);
+        esp_sys_mutex_invalid(&sim.mutex);
+        return espERR;
+    }
+    return espOK;
+}
+
+/**
+ * \brief           Set baudrate of host side of AT port
+ * \note            Function is called by `esp_ll_posix.c` driver on every \ref esp_ll_init call.
+ *                  First call sets baudrate of simulator too
+ * \param[in]       baud: Baudrate in units of bits per second
+ */
+void
+esp_sim_set_host_baudrate(uint32_t baud) {
+    esp_sys_mutex_lock(&sim.mutex);
+    if (!sim.baudrate) {
+        sim.baudrate = baud;
+    }
+    sim.host_baudrate = baud;
+    esp_sys_mutex_unlock(&sim.mutex);
+}
+
+/**
+ * \brief           Get simulator statistics
+ * \param[out]      stats: Pointer to output structure
+ */
+void
+esp_sim_get_stats(esp_sim_stats_t* stats) {
+    esp_sys_mutex_lock(&sim.mutex);
+    *stats = sim.stats;
+    esp_sys_mutex_unlock(&sim.mutex);
+}
+
+/**
+ * \brief           Reset simulator statistics, for example after warm-up phase
+ */
+void
+esp_sim_reset_stats(void) {
+    esp_sys_mutex_lock(&sim.mutex);
+    memset(&sim.stats, 0x00, sizeof(sim.stats));
+    esp_sys_mutex_unlock(&sim.mutex);
+}
+
+/**
+ * \brief           Send data from remote side on active connection
+ * \param[in]       num: Connection number
+ * \param[in]       data: Data to send to host
+ * \param[in]       len: Length of data in units of bytes
+ * \return          \ref espOK on success, \ref espERRMEM when passive receive buffer is full
+ *                  and remote side has to try again later, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_sim_ipd(uint8_t num, const void* data, size_t len) {
+    espr_t res = espERR;
+
+    ESP_ASSERT("num < SIM_MAX_CONNS", num < SIM_MAX_CONNS); /* Assert input parameters */
+    esp_sys_mutex_lock(&sim.mutex);
+    if (sim.conns[num].active && !sim.data_len) {   /* Firmware does not report data during prompt */
+        res = sim_send_ipd(num, data, len) ? espOK : espERRMEM;
+    }
+    esp_sys_mutex_unlock(&sim.mutex);
+    return res;
+}
+
+/**
+ * \brief           Simulate new incoming connection accepted by server
+ * \param[in]       num: Connection number
+ * \param[in]       ip: Remote IP address
+ * \param[in]       port: Remote port
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_sim_remote_connect(uint8_t num, const uint8_t* ip, uint16_t port) {
+    espr_t res = espERR;
+
+    ESP_ASSERT("num < SIM_MAX_CONNS", num < SIM_MAX_CONNS); /* Assert input parameters */
+    ESP_ASSERT("ip != NULL", ip != NULL);       /* Assert input parameters */
+    esp_sys_mutex_lock(&sim.mutex);
+    if (!sim.conns[num].active && !sim.data_len) {
+        esp_sim_conn_t* c = &sim.conns[num];
+
+        memset(c, 0x00, sizeof(*c));
+        strcpy(c->type, "TCP");
+        memcpy(c->ip, ip, sizeof(c->ip));
+        c->port = port;
+        c->local_port = 80;
+        c->is_server = 1;
+        c->active = 1;
+        sim_report_connect(num);
+        res = espOK;
+    }
+    esp_sys_mutex_unlock(&sim.mutex);
+    return res;
+}
+
+/**
+ * \brief           Simulate connection closed by remote side
+ * \param[in]       num: Connection number
+ * \return          \ref espOK on success, member of \ref espr_t enumeration otherwise
+ */
+espr_t
+esp_sim_remote_close(uint8_t num) {
+    espr_t res = espERR;
+
+    ESP_ASSERT("num < SIM_MAX_CONNS", num < SIM_MAX_CONNS); /* Assert input parameters */
+    esp_sys_mutex_lock(&sim.mutex);
+    if (sim.conns[num].active && !sim.data_len) {
+        sim.conns[num].active = 0;
+        sim.conns[num].rx_len = 0;
+        sim_printf("%d,CLOSED\r\n", (int)num);
+        res = espOK;
+    }
+    esp_sys_mutex_unlock(&sim.mutex);
+    return res;
+}
+
+#endif /* ESP_CFG_SYS_PORT_POSIX || __DOXYGEN__ */
@@ -0,0 +1,629 @@
+/**
+ * \file            esp_sys_posix.c
+ * \brief           System dependant functions for POSIX systems with pthreads
+ */
+
+/*
+ * Copyright (c) 2018 Tilen Majerle
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of ESP-AT.
+ *
+ * Author:          Tilen MAJERLE <tilen@majerle.eu>
+ */
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE       700                 /* Required for recursive mutex and monotonic clock */
+#endif
+#define ESP_INTERNAL
+#include "system/esp_sys.h"
+
+#if ESP_CFG_OS && ESP_CFG_SYS_PORT_POSIX || __DOXYGEN__
+
+#include "string.h"
+#include "time.h"
+#include "limits.h"
+#include "errno.h"
+
+/**
+ * \brief           Recursive mutex object
+ */
+struct esp_sys_posix_mutex {
+    pthread_mutex_t mutex;                      /* Recursive pthread mutex */
+};
+
+/**
+ * \brief           Binary semaphore object
+ */
+struct esp_sys_posix_sem {
+    pthread_mutex_t mutex;                      /* Mutex protecting token */
+    pthread_cond_t cond;                        /* Condition signalled on release */
+    uint8_t token;                              /* Token available (1) or not (0) */
+};
+
+/**
+ * \brief           Bounded message queue object
+ */
+struct esp_sys_posix_mbox {
+    pthread_mutex_t mutex;                      /* Mutex protecting queue */
+    pthread_cond_t not_empty;                   /* Condition signalled when entry is written */
+    pthread_cond_t not_full;                    /* Condition signalled when entry is read */
+    size_t size;                                /* Number of entries queue can hold */
+    size_t in;                                  /* Write index */
+    size_t out;                                 /* Read index */
+    size_t cnt;                                 /* Number of entries currently in queue */
+    void* entries[];                            /* Queue entries */
+};
+
+/**
+ * \brief           Thread start information
+ */
+typedef struct {
+    void (*thread_func)(void *);                /* User thread function */
+    void* arg;                                  /* User thread argument */
+} esp_sys_posix_thread_t;
+
+static esp_sys_mutex_t sys_mutex;               /* Mutex ID for main protection */
+
+/**
+ * \brief           Initialize condition variable with monotonic clock
+ * \param[in]       cond: Condition variable to initialize
+ * \return          1 on success, 0 otherwise
+ */
+static uint8_t
+cond_init(pthread_cond_t* cond) {
+    pthread_condattr_t attr;
+    uint8_t res;
+
+    if (pthread_condattr_init(&attr)) {
+        return 0;
+    }
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);  /* Timeouts must not depend on wall clock */
+    res = pthread_cond_init(cond, &attr) == 0;
+    pthread_condattr_destroy(&attr);
+    return res;
+}
+
+/**
+ * \brief           Get absolute monotonic time after specific timeout
+ * \param[out]      ts: Time structure to fill
+ * \param[in]       timeout: Timeout in units of milliseconds from now
+ */
+static void
+abs_timeout(struct timespec* ts, uint32_t timeout) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout / 1000;
+    ts->tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {           /* Normalize nanoseconds */
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * \brief           Wait on condition with optional timeout
+ * \note            Mutex must be locked by caller
+ * \param[in]       cond: Condition to wait for
+ * \param[in]       mutex: Locked mutex associated with condition
+ * \param[in]       ts: Absolute timeout or `NULL` to wait forever
+ * \return          1 when woken up, 0 on timeout
+ */
+static uint8_t
+cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* ts) {
+    if (ts == NULL) {
+        return pthread_cond_wait(cond, mutex) == 0;
+    }
+    return pthread_cond_timedwait(cond, mutex, ts) != ETIMEDOUT;
+}
+
+/**
+ * \brief           Thread entry wrapper to match pthread function prototype
+ * \param[in]       arg: Pointer to \ref esp_sys_posix_thread_t structure
+ * \return          Always `NULL`
+ */
+static void *
+thread_entry(void* arg) {
+    esp_sys_posix_thread_t t = *(esp_sys_posix_thread_t *)arg;
+
+    free(arg);                                  /* Start info is not needed anymore */
+    t.thread_func(t.arg);                       /* Run user thread */
+    return NULL;
+}
+
+/**
+ * \brief           Init system dependant parameters
+ * \note            Called from high-level application layer when required
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_init(void) {
+    return esp_sys_mutex_create(&sys_mutex);    /* Create system mutex */
+}
+
+/**
+ * \brief           Get current time in units of milliseconds
+ * \note            Monotonic clock is used, value wraps after ~49 days as on MCU ports
+ * \return          Current time in units of milliseconds
+ */
+uint32_t
+esp_sys_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL);
+}
+
+/**
+ * \brief           Protect stack core
+ * \note            This function is required with OS
+ *
+ * \note            This function may be called multiple times, recursive protection is required
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_protect(void) {
+    esp_sys_mutex_lock(&sys_mutex);             /* Lock system and protect it */
+    return 1;
+}
+
+/**
+ * \brief           Protect stack core
+ * \note            This function is required with OS
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_unprotect(void) {
+    esp_sys_mutex_unlock(&sys_mutex);           /* Release lock */
+    return 1;
+}
+
+/**
+ * \brief           Create a new mutex and pass it to input pointer
+ * \note            This function is required with OS
+ * \note            Recursive mutex must be created as it may be locked multiple times before unlocked
+ * \param[out]      p: Pointer to mutex structure to save result to
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mutex_create(esp_sys_mutex_t* p) {
+    pthread_mutexattr_t attr;
+
+    *p = malloc(sizeof(**p));                   /* Allocate mutex object */
+    if (*p == NULL) {
+        return 0;
+    }
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);  /* Create recursive mutex */
+    if (pthread_mutex_init(&(*p)->mutex, &attr)) {
+        free(*p);
+        *p = ESP_SYS_MUTEX_NULL;
+    }
+    pthread_mutexattr_destroy(&attr);
+    return !!*p;                                /* Return status */
+}
+
+/**
+ * \brief           Delete mutex from OS
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to mutex structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mutex_delete(esp_sys_mutex_t* p) {
+    if (pthread_mutex_destroy(&(*p)->mutex)) {  /* Mutex is still locked */
+        return 0;
+    }
+    free(*p);
+    return 1;
+}
+
+/**
+ * \brief           Wait forever to lock the mutex
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to mutex structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mutex_lock(esp_sys_mutex_t* p) {
+    return pthread_mutex_lock(&(*p)->mutex) == 0;   /* Wait forever for mutex */
+}
+
+/**
+ * \brief           Unlock mutex
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to mutex structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mutex_unlock(esp_sys_mutex_t* p) {
+    return pthread_mutex_unlock(&(*p)->mutex) == 0; /* Release mutex */
+}
+
+/**
+ * \brief           Check if mutex structure is valid OS entry
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to mutex structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mutex_isvalid(esp_sys_mutex_t* p) {
+    return !!*p;                                /* Check if mutex is valid */
+}
+
+/**
+ * \brief           Set mutex structure as invalid
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to mutex structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mutex_invalid(esp_sys_mutex_t* p) {
+    *p = ESP_SYS_MUTEX_NULL;                    /* Set mutex as invalid */
+    return 1;
+}
+
+/**
+ * \brief           Create a new binary semaphore and set initial state
+ * \note            Semaphore may only have 1 token available
+ * \note            This function is required with OS
+ * \param[out]      p: Pointer to semaphore structure to fill with result
+ * \param[in]       cnt: Count indicating default semaphore state:
+ *                     0: Lock it immediteally
+ *                     1: Leave it unlocked
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_sem_create(esp_sys_sem_t* p, uint8_t cnt) {
+    *p = malloc(sizeof(**p));                   /* Allocate semaphore object */
+    if (*p == NULL) {
+        return 0;
+    }
+    if (pthread_mutex_init(&(*p)->mutex, NULL)) {
+        free(*p);
+        *p = ESP_SYS_SEM_NULL;
+        return 0;
+    }
+    if (!cond_init(&(*p)->cond)) {
+        pthread_mutex_destroy(&(*p)->mutex);
+        free(*p);
+        *p = ESP_SYS_SEM_NULL;
+        return 0;
+    }
+    (*p)->token = !!cnt;                        /* Binary semaphore, one token at most */
+    return 1;
+}
+
+/**
+ * \brief           Delete binary semaphore
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to semaphore structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_sem_delete(esp_sys_sem_t* p) {
+    pthread_cond_destroy(&(*p)->cond);
+    pthread_mutex_destroy(&(*p)->mutex);
+    free(*p);
+    return 1;
+}
+
+/**
+ * \brief           Wait for semaphore to be available
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to semaphore structure
+ * \param[in]       timeout: Timeout to wait in milliseconds. When 0 is applied, wait forever
+ * \return          Number of milliseconds waited for semaphore to become available
+ */
+uint32_t
+esp_sys_sem_wait(esp_sys_sem_t* p, uint32_t timeout) {
+    struct timespec ts;
+    uint32_t tick = esp_sys_now();              /* Get start tick time */
+    uint8_t ok = 1;
+
+    if (timeout) {
+        abs_timeout(&ts, timeout);
+    }
+    pthread_mutex_lock(&(*p)->mutex);
+    while (!(*p)->token && ok) {                /* Wait for token or timeout */
+        ok = cond_wait(&(*p)->cond, &(*p)->mutex, timeout ? &ts : NULL);
+    }
+    if ((*p)->token) {                          /* Token may be released just at timeout */
+        (*p)->token = 0;                        /* Take token */
+        ok = 1;
+    }
+    pthread_mutex_unlock(&(*p)->mutex);
+    return ok ? (esp_sys_now() - tick) : ESP_SYS_TIMEOUT;
+}
+
+/**
+ * \brief           Release semaphore
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to semaphore structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_sem_release(esp_sys_sem_t* p) {
+    pthread_mutex_lock(&(*p)->mutex);
+    (*p)->token = 1;                            /* Set token available */
+    pthread_cond_signal(&(*p)->cond);           /* Wake up one waiting thread */
+    pthread_mutex_unlock(&(*p)->mutex);
+    return 1;
+}
+
+/**
+ * \brief           Check if semaphore is valid
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to semaphore structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_sem_isvalid(esp_sys_sem_t* p) {
+    return !!*p;                                /* Check if valid */
+}
+
+/**
+ * \brief           Invalid semaphore
+ * \note            This function is required with OS
+ * \param[in]       p: Pointer to semaphore structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_sem_invalid(esp_sys_sem_t* p) {
+    *p = ESP_SYS_SEM_NULL;                      /* Invaldiate semaphore */
+    return 1;
+}
+
+/**
+ * \brief           Create a new message queue with entry type of "void *"
+ * \note            This function is required with OS
+ * \param[out]      b: Pointer to message queue structure
+ * \param[in]       size: Number of entries for message queue to hold
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mbox_create(esp_sys_mbox_t* b, size_t size) {
+    if (!size) {
+        return 0;
+    }
+    *b = malloc(sizeof(**b) + size * sizeof((*b)->entries[0])); /* Allocate box with entries */
+    if (*b == NULL) {
+        return 0;
+    }
+    if (pthread_mutex_init(&(*b)->mutex, NULL)) {
+        free(*b);
+        *b = ESP_SYS_MBOX_NULL;
+        return 0;
+    }
+    if (!cond_init(&(*b)->not_empty)) {
+        pthread_mutex_destroy(&(*b)->mutex);
+        free(*b);
+        *b = ESP_SYS_MBOX_NULL;
+        return 0;
+    }
+    if (!cond_init(&(*b)->not_full)) {
+        pthread_cond_destroy(&(*b)->not_empty);
+        pthread_mutex_destroy(&(*b)->mutex);
+        free(*b);
+        *b = ESP_SYS_MBOX_NULL;
+        return 0;
+    }
+    (*b)->size = size;
+    (*b)->in = (*b)->out = (*b)->cnt = 0;
+    return 1;
+}
+
+/**
+ * \brief           Delete message queue
+ * \note            This function is required with OS
+ * \param[in]       b: Pointer to message queue structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mbox_delete(esp_sys_mbox_t* b) {
+    size_t cnt;
+
+    pthread_mutex_lock(&(*b)->mutex);
+    cnt = (*b)->cnt;
+    pthread_mutex_unlock(&(*b)->mutex);
+    if (cnt) {                                  /* We still have messages in queue, should not delete queue */
+        return 0;                               /* Return error as we still have entries in message queue */
+    }
+    pthread_cond_destroy(&(*b)->not_full);
+    pthread_cond_destroy(&(*b)->not_empty);
+    pthread_mutex_destroy(&(*b)->mutex);
+    free(*b);
+    return 1;
+}
+
+/**
+ * \brief           Put a new entry to message queue and wait until memory available
+ * \note            This function is required with OS
+ * \param[in]       b: Pointer to message queue structure
+ * \param[in]       m: Pointer to entry to insert to message queue
+ * \return          Time in units of milliseconds needed to put a message to queue
+ */
+uint32_t
+esp_sys_mbox_put(esp_sys_mbox_t* b, void* m) {
+    uint32_t tick = esp_sys_now();              /* Get start time */
+
+    pthread_mutex_lock(&(*b)->mutex);
+    while ((*b)->cnt == (*b)->size) {           /* Wait for free slot */
+        pthread_cond_wait(&(*b)->not_full, &(*b)->mutex);
+    }
+    (*b)->entries[(*b)->in] = m;                /* Write entry */
+    if (++(*b)->in == (*b)->size) {
+        (*b)->in = 0;
+    }
+    (*b)->cnt++;
+    pthread_cond_signal(&(*b)->not_empty);      /* Notify reader */
+    pthread_mutex_unlock(&(*b)->mutex);
+    return esp_sys_now() - tick;
+}
+
+/**
+ * \brief           Get a new entry from message queue with timeout
+ * \note            This function is required with OS
+ * \param[in]       b: Pointer to message queue structure
+ * \param[in]       m: Pointer to pointer to result to save value from message queue to
+ * \param[in]       timeout: Maximal timeout to wait for new message. When 0 is applied, wait for unlimited time
+ * \return          Time in units of milliseconds needed to put a message to queue
+ */
+uint32_t
+esp_sys_mbox_get(esp_sys_mbox_t* b, void** m, uint32_t timeout) {
+    struct timespec ts;
+    uint32_t time = esp_sys_now();              /* Get current time */
+    uint8_t ok = 1;
+
+    if (timeout) {
+        abs_timeout(&ts, timeout);
+    }
+    pthread_mutex_lock(&(*b)->mutex);
+    while (!(*b)->cnt && ok) {                  /* Wait for entry or timeout */
+        ok = cond_wait(&(*b)->not_empty, &(*b)->mutex, timeout ? &ts : NULL);
+    }
+    if ((*b)->cnt) {                            /* Did we get a message? */
+        *m = (*b)->entries[(*b)->out];          /* Set value */
+        if (++(*b)->out == (*b)->size) {
+            (*b)->out = 0;
+        }
+        (*b)->cnt--;
+        pthread_cond_signal(&(*b)->not_full);   /* Notify writer */
+        ok = 1;
+    }
+    pthread_mutex_unlock(&(*b)->mutex);
+    return ok ? (esp_sys_now() - time) : ESP_SYS_TIMEOUT;
+}
+
+/**
+ * \brief           Put a new entry to message queue without timeout (now or fail)
+ * \note            This function is required with OS
+ * \param[in]       b: Pointer to message queue structure
+ * \param[in]       m: Pointer to message to save to queue
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mbox_putnow(esp_sys_mbox_t* b, void* m) {
+    uint8_t res = 0;
+
+    pthread_mutex_lock(&(*b)->mutex);
+    if ((*b)->cnt < (*b)->size) {               /* Is there free slot? */
+        (*b)->entries[(*b)->in] = m;
+        if (++(*b)->in == (*b)->size) {
+            (*b)->in = 0;
+        }
+        (*b)->cnt++;
+        pthread_cond_signal(&(*b)->not_empty);
+        res = 1;
+    }
+    pthread_mutex_unlock(&(*b)->mutex);
+    return res;
+}
+
+/**
+ * \brief           Get an entry from message queue immediatelly
+ * \note            This function is required with OS
+ * \param[in]       b: Pointer to message queue structure
+ * \param[in]       m: Pointer to pointer to result to save value from message queue to
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mbox_getnow(esp_sys_mbox_t* b, void** m) {
+    uint8_t res = 0;
+
+    pthread_mutex_lock(&(*b)->mutex);
+    if ((*b)->cnt) {                            /* Is there any entry? */
+        *m = (*b)->entries[(*b)->out];
+        if (++(*b)->out == (*b)->size) {
+            (*b)->out = 0;
+        }
+        (*b)->cnt--;
+        pthread_cond_signal(&(*b)->not_full);
+        res = 1;
+    }
+    pthread_mutex_unlock(&(*b)->mutex);
+    return res;
+}
+
+/**
+ * \brief           Check if message queue is valid
+ * \note            This function is required with OS
+ * \param[in]       b: Pointer to message queue structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mbox_isvalid(esp_sys_mbox_t* b) {
+    return !!*b;                                /* Return status if message box is valid */
+}
+
+/**
+ * \brief           Invalid message queue
+ * \note            This function is required with OS
+ * \param[in]       b: Pointer to message queue structure
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_mbox_invalid(esp_sys_mbox_t* b) {
+    *b = ESP_SYS_MBOX_NULL;                     /* Invalidate message box */
+    return 1;
+}
+
+/**
+ * \brief           Create a new thread
+ * \note            This function is required with OS
+ * \note            Thread is created detached, priority parameter is ignored
+ * \param[out]      t: Pointer to thread identifier if create was successful
+ * \param[in]       name: Name of a new thread
+ * \param[in]       thread_func: Thread function to use as thread body
+ * \param[in]       arg: Thread function argument
+ * \param[in]       stack_size: Size of thread stack in uints of bytes.
+ *                      Default stack size is used when value is below `PTHREAD_STACK_MIN`
+ * \param[in]       prio: Thread priority
+ * \return          1 on success, 0 otherwise
+ */
+uint8_t
+esp_sys_thread_create(esp_sys_thread_t* t, const char* name, void (*thread_func)(void *), void* const arg, size_t stack_size, esp_sys_thread_prio_t prio) {
+    pthread_attr_t attr;
+    esp_sys_posix_thread_t* info;
+    uint8_t res;
+
+    (void)name;
+    (void)prio;
+    info = malloc(sizeof(*info));               /* Allocate start info, freed by new thread */
+    if (info == NULL) {
+        return 0;
+    }
+    info->thread_func = thread_func;
+    info->arg = arg;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (stack_size >= (size_t)PTHREAD_STACK_MIN) {
+        pthread_attr_setstacksize(&attr, stack_size);
+    }
+    res = pthread_create(t, &attr, thread_entry, info) == 0;    /* Create thread */
+    pthread_attr_destroy(&attr);
+    if (!res) {
+        free(info);
+    }
+    return res;
+}
+
+#endif /* ESP_CFG_OS && ESP_CFG_SYS_PORT_POSIX || __DOXYGEN__ */